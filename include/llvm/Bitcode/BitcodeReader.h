@@ -14,6 +14,7 @@
 #ifndef LLVM_BITCODE_BITCODEREADER_H
 #define LLVM_BITCODE_BITCODEREADER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Bitcode/BitCodes.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
@@ -22,6 +23,8 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace llvm {
   class LLVMContext;
@@ -48,6 +51,45 @@ namespace llvm {
     bool HasSummary;
   };
 
+  /// A thread-safe cache of the parts of lazily loaded bitcode modules that do
+  /// not depend on the LLVMContext they are loaded into: the offsets of the
+  /// function bodies, and the strings and record positions of the module
+  /// metadata block. Sharing one cache between the readers of a set of
+  /// bitcode buffers makes loading the same module again, e.g. to import from
+  /// it in several ThinLTO backends, cheaper. The buffers must outlive the
+  /// cache, as it is keyed by their address.
+  class BitcodeLazyLoadCache {
+  public:
+    /// A block of a bitcode buffer: the start of the buffer and the bit
+    /// position of the block in it.
+    using KeyTy = std::pair<const uint8_t *, uint64_t>;
+
+    /// The value ids and word offsets of the functions with a body.
+    using FunctionOffsetTable = std::vector<std::pair<unsigned, uint64_t>>;
+
+    /// The index of a module metadata block built for lazy loading.
+    struct MetadataIndex {
+      /// The MDStrings of the block, pointing into the bitcode buffer.
+      std::vector<StringRef> Strings;
+      /// The bit position of each metadata record.
+      std::vector<uint64_t> BitPositions;
+    };
+
+    /// Return the entry for \p Key, or null if there is none yet.
+    std::shared_ptr<const FunctionOffsetTable> getFunctionOffsets(KeyTy Key);
+    std::shared_ptr<const MetadataIndex> getMetadataIndex(KeyTy Key);
+
+    /// Add the entry for \p Key. The first entry added for a key is kept.
+    void addFunctionOffsets(KeyTy Key, FunctionOffsetTable Table);
+    void addMetadataIndex(KeyTy Key, MetadataIndex Index);
+
+  private:
+    std::mutex Mutex;
+    DenseMap<KeyTy, std::shared_ptr<const FunctionOffsetTable>>
+        FunctionOffsets;
+    DenseMap<KeyTy, std::shared_ptr<const MetadataIndex>> MetadataIndexes;
+  };
+
   /// Represents a module in a bitcode file.
   class BitcodeModule {
     // This covers the identification (if present) and module blocks.
@@ -72,10 +114,10 @@ namespace llvm {
     friend Expected<BitcodeFileContents>
     getBitcodeFileContents(MemoryBufferRef Buffer);
 
-    Expected<std::unique_ptr<Module>> getModuleImpl(LLVMContext &Context,
-                                                    bool MaterializeAll,
-                                                    bool ShouldLazyLoadMetadata,
-                                                    bool IsImporting);
+    Expected<std::unique_ptr<Module>>
+    getModuleImpl(LLVMContext &Context, bool MaterializeAll,
+                  bool ShouldLazyLoadMetadata, bool IsImporting,
+                  BitcodeLazyLoadCache *Cache);
 
   public:
     StringRef getBuffer() const {
@@ -88,10 +130,12 @@ namespace llvm {
     /// Read the bitcode module and prepare for lazy deserialization of function
     /// bodies. If ShouldLazyLoadMetadata is true, lazily load metadata as well.
     /// If IsImporting is true, this module is being parsed for ThinLTO
-    /// importing into another module.
-    Expected<std::unique_ptr<Module>> getLazyModule(LLVMContext &Context,
-                                                    bool ShouldLazyLoadMetadata,
-                                                    bool IsImporting);
+    /// importing into another module. If Cache is not null, the parts of the
+    /// module that can be shared between loads are looked up in, or added to,
+    /// the cache.
+    Expected<std::unique_ptr<Module>>
+    getLazyModule(LLVMContext &Context, bool ShouldLazyLoadMetadata,
+                  bool IsImporting, BitcodeLazyLoadCache *Cache = nullptr);
 
     /// Read the entire bitcode module and return it.
     Expected<std::unique_ptr<Module>> parseModule(LLVMContext &Context);
@@ -256,6 +256,10 @@ enum GlobalValueSummarySymtabCodes {
   // strings in strtab.
   // [n * name]
   FS_CFI_FUNCTION_DECLS = 18,
+  // PERMODULE_RELBF: [valueid, flags, instcount, fflags, numrefs,
+  //                   numrefs x valueid,
+  //                   n x (valueid, hotness, relblockfreq)]
+  FS_PERMODULE_RELBF = 19,
 };
 
 enum MetadataCodes {
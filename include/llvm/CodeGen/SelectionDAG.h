@@ -241,7 +241,8 @@ class SelectionDAG {
   /// CSE with existing nodes when a duplicate is requested.
   FoldingSet<SDNode> CSEMap;
 
-  /// Pool allocation for machine-opcode SDNode operands.
+  /// Pool allocation for machine-opcode SDNode operands. Operand arrays are
+  /// recycled across the blocks of a function and released between functions.
   BumpPtrAllocator OperandAllocator;
   ArrayRecycler<SDUse> OperandRecycler;
 
@@ -253,6 +254,9 @@ class SelectionDAG {
 
   uint16_t NextPersistentId = 0;
 
+  /// The number of nodes inserted since the DAG was last cleared.
+  unsigned NumNodesCreated = 0;
+
 public:
   /// Clients of various APIs that cause global effects on
   /// the DAG can optionally implement this interface.  This allows the clients
@@ -424,6 +428,10 @@ public:
     return AllNodes.size();
   }
 
+  /// Return the number of nodes created since the DAG was last cleared,
+  /// including nodes that were deleted since.
+  unsigned getNumNodesCreated() const { return NumNodesCreated; }
+
   iterator_range<allnodes_iterator> allnodes() {
     return make_range(allnodes_begin(), allnodes_end());
   }
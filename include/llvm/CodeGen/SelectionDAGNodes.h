@@ -585,6 +585,12 @@ public:
   /// Used for debug printing.
   uint16_t PersistentId;
 
+private:
+  /// Position of the node in the DAG combiner's worklist, or -1 if it is not
+  /// on the worklist. On 64-bit hosts it fills the padding after PersistentId.
+  int CombinerWorklistIndex = -1;
+
+public:
   //===--------------------------------------------------------------------===//
   //  Accessors
   //
@@ -680,6 +686,13 @@ public:
   /// Set unique node id.
   void setNodeId(int Id) { NodeId = Id; }
 
+  /// Return the position of the node in the DAG combiner's worklist, or -1 if
+  /// it is not on the worklist.
+  int getCombinerWorklistIndex() const { return CombinerWorklistIndex; }
+
+  /// Set the position of the node in the DAG combiner's worklist.
+  void setCombinerWorklistIndex(int Index) { CombinerWorklistIndex = Index; }
+
   /// Return the node ordering.
   unsigned getIROrder() const { return IROrder; }
 
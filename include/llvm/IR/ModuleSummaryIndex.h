@@ -56,12 +56,33 @@ struct CalleeInfo {
   };
   HotnessType Hotness = HotnessType::Unknown;
 
+  /// Sum of the frequencies of the call sites relative to the entry of the
+  /// caller, as a fixed point number with ScaleShift fractional bits, or 0 if
+  /// unknown.
+  uint32_t RelBlockFreq = 0;
+  static constexpr unsigned ScaleShift = 8;
+  static constexpr uint32_t MaxRelBlockFreq = (1u << 29) - 1;
+
   CalleeInfo() = default;
-  explicit CalleeInfo(HotnessType Hotness) : Hotness(Hotness) {}
+  explicit CalleeInfo(HotnessType Hotness, uint32_t RelBlockFreq = 0)
+      : Hotness(Hotness), RelBlockFreq(RelBlockFreq) {}
 
   void updateHotness(const HotnessType OtherHotness) {
     Hotness = std::max(Hotness, OtherHotness);
   }
+
+  /// Add a call site executed \p BlockFreq times per \p EntryFreq executions
+  /// of the caller's entry block. A call site too cold to be represented
+  /// counts as the smallest frequency, so that it is not taken as unknown.
+  void updateRelBlockFreq(uint64_t BlockFreq, uint64_t EntryFreq) {
+    if (EntryFreq == 0)
+      return;
+    uint64_t Freq = MaxRelBlockFreq;
+    if (BlockFreq < (UINT64_MAX >> ScaleShift))
+      Freq = std::min<uint64_t>((BlockFreq << ScaleShift) / EntryFreq, Freq);
+    Freq = std::max<uint64_t>(Freq, 1);
+    RelBlockFreq = std::min<uint64_t>(RelBlockFreq + Freq, MaxRelBlockFreq);
+  }
 };
 
 class GlobalValueSummary;
@@ -234,7 +255,8 @@ public:
 
   friend class ModuleSummaryIndex;
   friend void computeDeadSymbols(class ModuleSummaryIndex &,
-                                 const DenseSet<GlobalValue::GUID> &);
+                                 const DenseSet<GlobalValue::GUID> &,
+                                 unsigned);
 };
 
 /// \brief Alias summary information.
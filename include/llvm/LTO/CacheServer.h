@@ -0,0 +1,76 @@
+//===- CacheServer.h - Shared ThinLTO cache protocol ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the protocol spoken between the ThinLTO cache and a
+// shared cache server such as llvm-lto-cache-server.
+//
+// Each connection carries one request and one response. A request starts with
+// the magic "LTOC", the protocol version and an opcode, followed by:
+//   Get:      <u32 key size> <key>
+//   Put:      <u32 key size> <key> <object>
+//   Shutdown: nothing
+// A response is a status byte, followed by an <object> for a successful Get.
+// An <object> is the SHA1 of its contents, a u64 size and the contents. The
+// receiver of an object checks the hash before using or storing it. Integers
+// are little endian.
+//
+// Servers are addressed as "unix:<path>" or "tcp:<host>:<port>".
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LTO_CACHESERVER_H
+#define LLVM_LTO_CACHESERVER_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+
+namespace llvm {
+namespace lto {
+namespace cacheserver {
+
+enum : uint8_t { ProtocolVersion = 1 };
+
+enum class Opcode : uint8_t { Get = 'G', Put = 'P', Shutdown = 'Q' };
+
+enum class Status : uint8_t { Ok = 0, Miss = 1, Error = 2 };
+
+/// Return true if Key may be used as a cache key. Keys are restricted to
+/// characters that are safe to use in file names.
+bool isValidKey(StringRef Key);
+
+/// Open a socket listening on Address.
+Expected<int> listen(StringRef Address);
+
+/// Accept a connection on a socket returned by listen().
+Expected<int> accept(int ListenFD);
+
+/// Open a connection to the server listening on Address.
+Expected<int> connect(StringRef Address);
+
+/// Close a socket returned by one of the functions above.
+void close(int FD);
+
+Error writeRequest(int FD, Opcode Op, StringRef Key = StringRef());
+Expected<Opcode> readRequest(int FD, std::string &Key);
+
+Error writeStatus(int FD, Status S);
+Expected<Status> readStatus(int FD);
+
+Error writeObject(int FD, StringRef Object);
+/// Read an object and verify it against its hash. The returned buffer is
+/// named after Key.
+Expected<std::unique_ptr<MemoryBuffer>> readObject(int FD, StringRef Key);
+
+} // namespace cacheserver
+} // namespace lto
+} // namespace llvm
+
+#endif
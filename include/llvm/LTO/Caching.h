@@ -16,6 +16,7 @@
 #define LLVM_LTO_CACHING_H
 
 #include "llvm/LTO/LTO.h"
+#include <memory>
 #include <string>
 
 namespace llvm {
@@ -32,11 +33,44 @@ namespace lto {
 typedef std::function<void(unsigned Task, std::unique_ptr<MemoryBuffer> MB)>
     AddBufferFn;
 
+/// A shared store of native objects that a local cache can use as a second
+/// tier, e.g. a cache server shared by several machines. Objects are addressed
+/// by cache key.
+///
+/// Implementations must be thread safe. Failures are not fatal to the link;
+/// the local cache treats them as misses.
+class RemoteCache {
+public:
+  virtual ~RemoteCache();
+
+  /// Look up the object for Key. Returns null on a miss.
+  virtual Expected<std::unique_ptr<MemoryBuffer>> get(StringRef Key) = 0;
+
+  /// Store Object under Key.
+  virtual Error put(StringRef Key, StringRef Object) = 0;
+};
+
+/// Create a RemoteCache that talks to the cache server at Address, which is
+/// either "unix:<path>" or "tcp:<host>:<port>" (see llvm/LTO/CacheServer.h).
+Expected<std::unique_ptr<RemoteCache>>
+createCacheServerClient(StringRef Address);
+
 /// Create a local file system cache which uses the given cache directory and
 /// file callback. This function also creates the cache directory if it does not
 /// already exist.
-Expected<NativeObjectCache> localCache(StringRef CacheDirectoryPath,
-                                       AddBufferFn AddBuffer);
+///
+/// If Remote is not null, it is consulted on local misses, and objects built
+/// on a miss in both tiers are stored in it as well as in the local cache.
+///
+/// If CompressEntries is true and zlib is available, new entries are stored
+/// compressed and decompressed when they are hit. The buffers passed to
+/// AddBuffer are then not backed by a file, so clients that need the object
+/// file itself must not enable compression. Compressed and uncompressed
+/// entries can share a cache directory.
+Expected<NativeObjectCache>
+localCache(StringRef CacheDirectoryPath, AddBufferFn AddBuffer,
+           std::shared_ptr<RemoteCache> Remote = nullptr,
+           bool CompressEntries = false);
 
 } // namespace lto
 } // namespace llvm
@@ -19,6 +19,7 @@
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 
 #include <functional>
 
@@ -82,6 +83,28 @@ struct Config {
   /// Whether to emit the pass manager debuggging informations.
   bool DebugPassManager = false;
 
+  /// Number of threads running the whole-program analyses of the ThinLTO
+  /// thin link. Their results do not depend on it.
+  unsigned ThinLinkThreads = 1;
+
+  /// Whether to time the phases of the ThinLTO thin link. The timers are
+  /// reported with the other timers of the process.
+  bool TimeThinLink = false;
+
+  /// If nonzero, the ThinLTO backends running jobs start the largest job that
+  /// keeps the memory of the running jobs within this many bytes, as estimated
+  /// from the instruction counts of their summaries. Past a minimum number of
+  /// jobs, the resident memory gained by the process also has to fit. A job is
+  /// always started when none is running.
+  uint64_t ThinLTOMemoryBudget = 0;
+
+  /// Whether the ThinLTO backends running jobs print a table of the jobs.
+  bool ReportThinLTOJobs = false;
+
+  /// How the regular LTO module is split when it is code generated in
+  /// parallel.
+  SplitModulePartitioning CodeGenPartitioning = SplitModulePartitioning::Hash;
+
   bool ShouldDiscardValueNames = true;
   DiagnosticHandlerFunction DiagHandler;
 
@@ -47,19 +47,28 @@ class raw_pwrite_stream;
 ///
 /// This is done for correctness (if value exported, ensure we always
 /// emit a copy), and compile-time optimization (allow drop of duplicates).
+///
+/// The values are resolved on \p Threads threads, so \p isPrevailing may be
+/// called concurrently; \p recordNewLinkage is called from the calling thread,
+/// in index order.
 void thinLTOResolveWeakForLinkerInIndex(
     ModuleSummaryIndex &Index,
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
         isPrevailing,
     function_ref<void(StringRef, GlobalValue::GUID, GlobalValue::LinkageTypes)>
-        recordNewLinkage);
+        recordNewLinkage,
+    unsigned Threads = 1);
 
 /// Update the linkages in the given \p Index to mark exported values
 /// as external and non-exported values as internal. The ThinLTO backends
 /// must apply the changes to the Module via thinLTOInternalizeModule.
+///
+/// The values are updated on \p Threads threads, so \p isExported may be
+/// called concurrently.
 void thinLTOInternalizeAndPromoteInIndex(
     ModuleSummaryIndex &Index,
-    function_ref<bool(StringRef, GlobalValue::GUID)> isExported);
+    function_ref<bool(StringRef, GlobalValue::GUID)> isExported,
+    unsigned Threads = 1);
 
 namespace lto {
 
@@ -215,6 +224,29 @@ ThinBackend createWriteIndexesThinBackend(std::string OldPrefix,
                                           bool ShouldEmitImportsFiles,
                                           std::string LinkedObjectsFile);
 
+/// This ThinBackend runs the individual backend jobs in worker processes, at
+/// most ParallelismLevel at a time, so that the memory used by a backend is
+/// released when it completes and does not add to that of the link.
+///
+/// For each job, the backend writes the individual index of the module, as
+/// createWriteIndexesThinBackend does, and a list of the bitcode files of the
+/// module and of the modules it imports from. It then runs the program
+/// WorkerArgs[0] with the arguments:
+///
+///   WorkerArgs[1..] -o <object file> <index file> <module list file>
+///
+/// The worker is expected to call runThinBackendJob() and to exit with a
+/// non-zero status if it fails. The object file is then added to the output
+/// stream or the cache of the task. All the files are temporary files.
+ThinBackend createOutOfProcessThinBackend(unsigned ParallelismLevel,
+                                          std::vector<std::string> WorkerArgs);
+
+/// Run the backend job described by \p IndexPath and \p ModuleListPath, written
+/// by the ThinBackend of createOutOfProcessThinBackend, adding the object to
+/// \p AddStream as task 0.
+Error runThinBackendJob(Config &Conf, StringRef IndexPath,
+                        StringRef ModuleListPath, AddStreamFn AddStream);
+
 /// This class implements a resolution-based interface to LLVM's LTO
 /// functionality. It supports regular LTO, parallel LTO code generation and
 /// ThinLTO. You can use it from a linker in the following way:
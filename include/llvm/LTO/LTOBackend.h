@@ -27,6 +27,7 @@
 
 namespace llvm {
 
+class BitcodeLazyLoadCache;
 class BitcodeModule;
 class Error;
 class Module;
@@ -40,12 +41,15 @@ Error backend(Config &C, AddStreamFn AddStream,
               unsigned ParallelCodeGenParallelismLevel,
               std::unique_ptr<Module> M, ModuleSummaryIndex &CombinedIndex);
 
-/// Runs a ThinLTO backend.
+/// Runs a ThinLTO backend. If LazyLoadCache is not null, the modules imported
+/// from are loaded through it, so that backends running in the same process
+/// share the work of indexing them.
 Error thinBackend(Config &C, unsigned Task, AddStreamFn AddStream, Module &M,
                   const ModuleSummaryIndex &CombinedIndex,
                   const FunctionImporter::ImportMapTy &ImportList,
                   const GVSummaryMapTy &DefinedGlobals,
-                  MapVector<StringRef, BitcodeModule> &ModuleMap);
+                  MapVector<StringRef, BitcodeModule> &ModuleMap,
+                  BitcodeLazyLoadCache *LazyLoadCache = nullptr);
 }
 }
 
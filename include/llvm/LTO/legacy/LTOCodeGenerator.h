@@ -45,6 +45,7 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include <string>
 #include <vector>
 
@@ -111,6 +112,11 @@ struct LTOCodeGenerator {
     ShouldRestoreGlobalsLinkage = Value;
   }
 
+  /// Set how the merged module is split for parallel code generation.
+  void setCodeGenPartitioning(SplitModulePartitioning Value) {
+    CodeGenPartitioning = Value;
+  }
+
   void addMustPreserveSymbol(StringRef Sym) { MustPreserveSymbols[Sym] = 1; }
 
   /// Pass options to the driver and optimization passes.
@@ -239,6 +245,7 @@ private:
   bool ShouldInternalize = true;
   bool ShouldEmbedUselists = false;
   bool ShouldRestoreGlobalsLinkage = false;
+  SplitModulePartitioning CodeGenPartitioning = SplitModulePartitioning::Hash;
   TargetMachine::CodeGenFileType FileType = TargetMachine::CGFT_ObjectFile;
   std::unique_ptr<tool_output_file> DiagnosticOutputFile;
   bool Freestanding = false;
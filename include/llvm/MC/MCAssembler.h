@@ -173,13 +173,35 @@ private:
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
                                const MCAsmLayout &Layout) const;
 
+  /// The relaxation bookkeeping of a section during layout. It lets a
+  /// layout iteration skip the relaxable fragments whose fixup values cannot
+  /// have changed since they were last checked.
+  struct SectionRelaxState {
+    /// For each layout iteration of the section, the layout orders of the
+    /// first and last fragment that changed size in it. The first is greater
+    /// than the last if none did.
+    std::vector<std::pair<unsigned, unsigned>> Changed;
+    /// The layout orders of the fragments whose size depends on their offset.
+    std::vector<unsigned> OffsetDependent;
+    /// For each fragment, one plus the iteration it was last checked for
+    /// relaxation in, or zero if it never was.
+    std::vector<unsigned> LastChecked;
+  };
+
   /// \brief Perform one layout iteration and return true if any offsets
   /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  bool layoutOnce(MCAsmLayout &Layout,
+                  MutableArrayRef<SectionRelaxState> RelaxStates);
 
   /// \brief Perform one layout iteration of the given section and return true
   /// if any offsets were adjusted.
-  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec);
+  bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                         SectionRelaxState &RelaxState);
+
+  /// Return true if no fixup of \p F can have changed its value since the
+  /// iteration \p F was last checked for relaxation in.
+  bool isRelaxationUnchanged(const MCRelaxableFragment &F,
+                             const SectionRelaxState &RelaxState) const;
 
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
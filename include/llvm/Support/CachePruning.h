@@ -45,14 +45,26 @@ struct CachePruningPolicy {
   /// The maximum size for the cache directory in bytes. A value over the amount
   /// of available space on the disk will be reduced to the amount of available
   /// space. A value of 0 disables the absolute size-based pruning.
+  ///
+  /// Sizes are measured on disk, so compressed cache entries count for their
+  /// compressed size.
   uint64_t MaxSizeBytes = 0;
+
+  /// Drive pruning from an index of cache accesses kept in the cache directory
+  /// instead of scanning and stat()ing every file in it. Accesses are added to
+  /// the index by recordCacheAccess(). The directory is still scanned, and the
+  /// index rebuilt, when the index is missing or unreadable and once per
+  /// Expiration period, to pick up entries added by clients that do not record
+  /// their accesses.
+  bool UseIndex = false;
 };
 
 /// Parse the given string as a cache pruning policy. Defaults are taken from a
 /// default constructed CachePruningPolicy object.
 /// For example: "prune_interval=30s:prune_after=24h:cache_size=50%"
 /// which means a pruning interval of 30 seconds, expiration time of 24 hours
-/// and maximum cache size of 50% of available disk space.
+/// and maximum cache size of 50% of available disk space. The "use_index"
+/// key takes "true" or "false" and sets CachePruningPolicy::UseIndex.
 Expected<CachePruningPolicy> parseCachePruningPolicy(StringRef PolicyStr);
 
 /// Peform pruning using the supplied policy, returns true if pruning
@@ -63,6 +75,12 @@ Expected<CachePruningPolicy> parseCachePruningPolicy(StringRef PolicyStr);
 /// pattern "llvmcache-*".
 bool pruneCache(StringRef Path, CachePruningPolicy Policy);
 
+/// Record that the cache entry at EntryPath, of Size bytes on disk, was just
+/// created or used. This only appends to the cache directory's index, and does
+/// nothing if CacheDir has no index, i.e. if it is not pruned with
+/// CachePruningPolicy::UseIndex.
+void recordCacheAccess(StringRef CacheDir, StringRef EntryPath, uint64_t Size);
+
 } // namespace llvm
 
 #endif
@@ -52,6 +52,15 @@ public:
   /// allocated space.
   static size_t GetMallocUsage();
 
+  /// \brief Return the peak resident set size of the process in bytes.
+  /// This is the high-water mark of physical memory used by the process so
+  /// far, as reported by the operating system, or 0 if it is not available.
+  static size_t GetPeakResidentSetSize();
+
+  /// \brief Return the current resident set size of the process in bytes, or
+  /// 0 if it is not available.
+  static size_t GetResidentSetSize();
+
   /// This static function will set \p user_time to the amount of CPU time
   /// spent in user (non-kernel) mode and \p sys_time to the amount of CPU
   /// time spent in system (kernel) mode.  If the operating system does not
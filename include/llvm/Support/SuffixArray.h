@@ -0,0 +1,63 @@
+//===-- SuffixArray.h - Suffix and LCP arrays of integer strings -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions building the suffix array and the longest
+// common prefix (LCP) array of a string of unsigned integers, and finding its
+// repeated substrings from them.
+//
+// Together, the two arrays answer the repeat queries of a suffix tree in a
+// few flat arrays of 4 bytes per character, instead of one heap node per
+// character with a map of children. The suffix array is built in linear time
+// with the SA-IS algorithm of Nong, Zhang and Chan, "Linear Suffix Array
+// Construction by Almost Pure Induced-Sorting", and the LCP array with the
+// algorithm of Kasai et al., "Linear-Time Longest-Common-Prefix Computation in
+// Suffix Arrays and Its Applications".
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_SUFFIXARRAY_H
+#define LLVM_SUPPORT_SUFFIXARRAY_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include <vector>
+
+namespace llvm {
+
+/// Return the start indices of the suffixes of \p Str in lexicographic order.
+std::vector<unsigned> buildSuffixArray(ArrayRef<unsigned> Str);
+
+/// Return the LCP array of \p Str given its suffix array \p SA: element I is
+/// the length of the longest common prefix of the suffixes starting at
+/// SA[I - 1] and SA[I], and element 0 is 0.
+std::vector<unsigned> buildLCPArray(ArrayRef<unsigned> Str,
+                                    ArrayRef<unsigned> SA);
+
+/// A substring occurring more than once in a string.
+struct RepeatedSubstring {
+  /// The length of the substring.
+  unsigned Length;
+  /// Start indices of occurrences of the substring, in increasing order.
+  std::vector<unsigned> StartIndices;
+};
+
+/// Find the repeated substrings of \p Str, which must end with a character
+/// that occurs nowhere else.
+///
+/// Every index I of the string is reported at most once: with the longest
+/// prefix of the suffix starting at I that also starts at another index, if
+/// that prefix is at least \p MinLength long and is the longest repeated
+/// prefix of at least one other suffix. These are the internal nodes of the
+/// suffix tree of \p Str with their leaf children. The substrings are
+/// returned in increasing order of their first start index.
+std::vector<RepeatedSubstring> findRepeatedSubstrings(ArrayRef<unsigned> Str,
+                                                      unsigned MinLength = 1);
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_SUFFIXARRAY_H
@@ -163,7 +163,7 @@ public:
   ConstLoopSet getLoopSet() const;
 
   using iterator = SetVector<PEGBasicBlock *>::iterator;
-  using const_iterator = SetVector<const PEGBasicBlock *>::const_iterator;
+  using const_iterator = SetVector<PEGBasicBlock *>::const_iterator;
 
   iterator begin_succ() { return this->Successors.begin(); }
   iterator end_succ() { return this->Successors.end(); }
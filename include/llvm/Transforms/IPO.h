@@ -58,6 +58,12 @@ ModulePass *createStripDebugDeclarePass();
 // This pass removes unused symbols' debug info.
 ModulePass *createStripDeadDebugInfoPass();
 
+//===----------------------------------------------------------------------===//
+//
+// This pass deduplicates identified debug info types and removes debug info
+// that is no longer reachable, e.g. after linking many modules together.
+ModulePass *createCompactDebugInfoPass();
+
 //===----------------------------------------------------------------------===//
 /// createConstantMergePass - This function returns a new pass that merges
 /// duplicate global constants together into a single constant that is shared.
@@ -24,6 +24,16 @@ namespace llvm {
 class Module;
 class StringRef;
 
+/// How SplitModule assigns the globals that may be placed in any partition.
+enum class SplitModulePartitioning {
+  /// By a hash of their names.
+  Hash,
+  /// By clustering functions along their heaviest call edges, as weighted by
+  /// profile counts when available, and balancing the partitions by
+  /// instruction count.
+  CallGraph
+};
+
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
@@ -37,7 +47,8 @@ class StringRef;
 void SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals = false);
+    bool PreserveLocals = false,
+    SplitModulePartitioning Partitioning = SplitModulePartitioning::Hash);
 
 } // End llvm namespace
 
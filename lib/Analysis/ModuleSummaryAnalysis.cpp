@@ -264,9 +264,12 @@ computeFunctionSummary(ModuleSummaryIndex &Index, const Module &M,
         // to record the call edge to the alias in that case. Eventually
         // an alias summary will be created to associate the alias and
         // aliasee.
-        CallGraphEdges[Index.getOrInsertValueInfo(
-                           cast<GlobalValue>(CalledValue))]
-            .updateHotness(Hotness);
+        CalleeInfo &Info = CallGraphEdges[Index.getOrInsertValueInfo(
+            cast<GlobalValue>(CalledValue))];
+        Info.updateHotness(Hotness);
+        if (BFI)
+          Info.updateRelBlockFreq(BFI->getBlockFreq(&BB).getFrequency(),
+                                  BFI->getEntryFreq());
       } else {
         // Skip inline assembly calls.
         if (CI && CI->isInlineAsm())
@@ -19,6 +19,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/ADT/Twine.h"
@@ -88,6 +89,11 @@
 
 using namespace llvm;
 
+#define DEBUG_TYPE "bitcode-reader"
+
+STATISTIC(NumLazyLoadCacheHits, "Number of lazy load cache hits");
+STATISTIC(NumLazyLoadCacheMisses, "Number of lazy load cache misses");
+
 static cl::opt<bool> PrintSummaryGUIDs(
     "print-summary-global-ids", cl::init(false), cl::Hidden,
     cl::desc(
@@ -512,6 +518,9 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   bool StripDebugInfo = false;
   TBAAVerifier TBAAVerifyHelper;
 
+  /// Cache shared with the other readers of the buffer, if any.
+  BitcodeLazyLoadCache *LazyLoadCache = nullptr;
+
   std::vector<std::string> BundleTags;
   SmallVector<SyncScope::ID, 8> SSIDs;
 
@@ -528,7 +537,8 @@ public:
   /// \brief Main interface to parsing a bitcode buffer.
   /// \returns true if an error occurred.
   Error parseBitcodeInto(Module *M, bool ShouldLazyLoadMetadata = false,
-                         bool IsImporting = false);
+                         bool IsImporting = false,
+                         BitcodeLazyLoadCache *Cache = nullptr);
 
   static uint64_t decodeSignRotatedValue(uint64_t V);
 
@@ -736,7 +746,8 @@ private:
   std::vector<ValueInfo> makeRefList(ArrayRef<uint64_t> Record);
   std::vector<FunctionSummary::EdgeTy> makeCallList(ArrayRef<uint64_t> Record,
                                                     bool IsOldProfileFormat,
-                                                    bool HasProfile);
+                                                    bool HasProfile,
+                                                    bool HasRelBF = false);
   Error parseEntireSummary(unsigned ID);
   Error parseModuleStringTable();
 
@@ -1860,9 +1871,24 @@ Error BitcodeReader::parseGlobalValueSymbolTable() {
   unsigned FuncBitcodeOffsetDelta =
       Stream.getAbbrevIDWidth() + bitc::BlockIDWidth;
 
+  // The caller jumps back past the block when we are done, so on a cache hit
+  // the block does not need to be read at all.
+  BitcodeLazyLoadCache::KeyTy CacheKey(Stream.getBitcodeBytes().data(),
+                                       Stream.GetCurrentBitNo());
+  if (LazyLoadCache)
+    if (auto Table = LazyLoadCache->getFunctionOffsets(CacheKey)) {
+      for (const auto &Entry : *Table) {
+        uint64_t Record[] = {Entry.first, Entry.second};
+        setDeferredFunctionInfo(FuncBitcodeOffsetDelta,
+                                cast<Function>(ValueList[Entry.first]), Record);
+      }
+      return Error::success();
+    }
+
   if (Stream.EnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
     return error("Invalid record");
 
+  BitcodeLazyLoadCache::FunctionOffsetTable Table;
   SmallVector<uint64_t, 64> Record;
   while (true) {
     BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
@@ -1872,6 +1898,8 @@ Error BitcodeReader::parseGlobalValueSymbolTable() {
     case BitstreamEntry::Error:
       return error("Malformed block");
     case BitstreamEntry::EndBlock:
+      if (LazyLoadCache)
+        LazyLoadCache->addFunctionOffsets(CacheKey, std::move(Table));
       return Error::success();
     case BitstreamEntry::Record:
       break;
@@ -1882,6 +1910,8 @@ Error BitcodeReader::parseGlobalValueSymbolTable() {
     case bitc::VST_CODE_FNENTRY: // [valueid, offset]
       setDeferredFunctionInfo(FuncBitcodeOffsetDelta,
                               cast<Function>(ValueList[Record[0]]), Record);
+      if (LazyLoadCache)
+        Table.emplace_back(Record[0], Record[1]);
       break;
     }
   }
@@ -3288,10 +3318,13 @@ Error BitcodeReader::parseModule(uint64_t ResumeBit,
 }
 
 Error BitcodeReader::parseBitcodeInto(Module *M, bool ShouldLazyLoadMetadata,
-                                      bool IsImporting) {
+                                      bool IsImporting,
+                                      BitcodeLazyLoadCache *Cache) {
   TheModule = M;
+  LazyLoadCache = Cache;
   MDLoader = MetadataLoader(Stream, *M, ValueList, IsImporting,
-                            [&](unsigned ID) { return getTypeByID(ID); });
+                            [&](unsigned ID) { return getTypeByID(ID); },
+                            Cache);
   return parseModule(0, ShouldLazyLoadMetadata);
 }
 
@@ -5014,19 +5047,23 @@ ModuleSummaryIndexBitcodeReader::makeRefList(ArrayRef<uint64_t> Record) {
 }
 
 std::vector<FunctionSummary::EdgeTy> ModuleSummaryIndexBitcodeReader::makeCallList(
-    ArrayRef<uint64_t> Record, bool IsOldProfileFormat, bool HasProfile) {
+    ArrayRef<uint64_t> Record, bool IsOldProfileFormat, bool HasProfile,
+    bool HasRelBF) {
   std::vector<FunctionSummary::EdgeTy> Ret;
   Ret.reserve(Record.size());
   for (unsigned I = 0, E = Record.size(); I != E; ++I) {
     CalleeInfo::HotnessType Hotness = CalleeInfo::HotnessType::Unknown;
+    uint32_t RelBF = 0;
     ValueInfo Callee = getValueInfoFromValueId(Record[I]).first;
     if (IsOldProfileFormat) {
       I += 1; // Skip old callsitecount field
       if (HasProfile)
         I += 1; // Skip old profilecount field
-    } else if (HasProfile)
+    } else if (HasProfile || HasRelBF)
       Hotness = static_cast<CalleeInfo::HotnessType>(Record[++I]);
-    Ret.push_back(FunctionSummary::EdgeTy{Callee, CalleeInfo{Hotness}});
+    if (HasRelBF)
+      RelBF = std::min<uint64_t>(Record[++I], CalleeInfo::MaxRelBlockFreq);
+    Ret.push_back(FunctionSummary::EdgeTy{Callee, CalleeInfo{Hotness, RelBF}});
   }
   return Ret;
 }
@@ -5105,8 +5142,12 @@ Error ModuleSummaryIndexBitcodeReader::parseEntireSummary(unsigned ID) {
     // FS_PERMODULE_PROFILE: [valueid, flags, instcount, fflags, numrefs,
     //                        numrefs x valueid,
     //                        n x (valueid, hotness)]
+    // FS_PERMODULE_RELBF: [valueid, flags, instcount, fflags, numrefs,
+    //                      numrefs x valueid,
+    //                      n x (valueid, hotness, relblockfreq)]
     case bitc::FS_PERMODULE:
-    case bitc::FS_PERMODULE_PROFILE: {
+    case bitc::FS_PERMODULE_PROFILE:
+    case bitc::FS_PERMODULE_RELBF: {
       unsigned ValueID = Record[0];
       uint64_t RawFlags = Record[1];
       unsigned InstCount = Record[2];
@@ -5131,9 +5172,10 @@ Error ModuleSummaryIndexBitcodeReader::parseEntireSummary(unsigned ID) {
       std::vector<ValueInfo> Refs = makeRefList(
           ArrayRef<uint64_t>(Record).slice(RefListStartIndex, NumRefs));
       bool HasProfile = (BitCode == bitc::FS_PERMODULE_PROFILE);
+      bool HasRelBF = (BitCode == bitc::FS_PERMODULE_RELBF);
       std::vector<FunctionSummary::EdgeTy> Calls = makeCallList(
           ArrayRef<uint64_t>(Record).slice(CallGraphEdgeStartIndex),
-          IsOldProfileFormat, HasProfile);
+          IsOldProfileFormat, HasProfile, HasRelBF);
       auto FS = llvm::make_unique<FunctionSummary>(
           Flags, InstCount, getDecodedFFlags(RawFunFlags), std::move(Refs),
           std::move(Calls), std::move(PendingTypeTests),
@@ -5469,6 +5511,43 @@ static Expected<StringRef> readBlobInRecord(BitstreamCursor &Stream,
 // External interface
 //===----------------------------------------------------------------------===//
 
+std::shared_ptr<const BitcodeLazyLoadCache::FunctionOffsetTable>
+BitcodeLazyLoadCache::getFunctionOffsets(KeyTy Key) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto I = FunctionOffsets.find(Key);
+  if (I == FunctionOffsets.end()) {
+    ++NumLazyLoadCacheMisses;
+    return nullptr;
+  }
+  ++NumLazyLoadCacheHits;
+  return I->second;
+}
+
+std::shared_ptr<const BitcodeLazyLoadCache::MetadataIndex>
+BitcodeLazyLoadCache::getMetadataIndex(KeyTy Key) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto I = MetadataIndexes.find(Key);
+  if (I == MetadataIndexes.end()) {
+    ++NumLazyLoadCacheMisses;
+    return nullptr;
+  }
+  ++NumLazyLoadCacheHits;
+  return I->second;
+}
+
+void BitcodeLazyLoadCache::addFunctionOffsets(KeyTy Key,
+                                              FunctionOffsetTable Table) {
+  auto Entry = std::make_shared<const FunctionOffsetTable>(std::move(Table));
+  std::lock_guard<std::mutex> Lock(Mutex);
+  FunctionOffsets.insert({Key, std::move(Entry)});
+}
+
+void BitcodeLazyLoadCache::addMetadataIndex(KeyTy Key, MetadataIndex Index) {
+  auto Entry = std::make_shared<const MetadataIndex>(std::move(Index));
+  std::lock_guard<std::mutex> Lock(Mutex);
+  MetadataIndexes.insert({Key, std::move(Entry)});
+}
+
 Expected<std::vector<BitcodeModule>>
 llvm::getBitcodeModuleList(MemoryBufferRef Buffer) {
   auto FOrErr = getBitcodeFileContents(Buffer);
@@ -5585,7 +5664,8 @@ llvm::getBitcodeFileContents(MemoryBufferRef Buffer) {
 /// everything.
 Expected<std::unique_ptr<Module>>
 BitcodeModule::getModuleImpl(LLVMContext &Context, bool MaterializeAll,
-                             bool ShouldLazyLoadMetadata, bool IsImporting) {
+                             bool ShouldLazyLoadMetadata, bool IsImporting,
+                             BitcodeLazyLoadCache *Cache) {
   BitstreamCursor Stream(Buffer);
 
   std::string ProducerIdentification;
@@ -5608,8 +5688,8 @@ BitcodeModule::getModuleImpl(LLVMContext &Context, bool MaterializeAll,
   M->setMaterializer(R);
 
   // Delay parsing Metadata if ShouldLazyLoadMetadata is true.
-  if (Error Err =
-          R->parseBitcodeInto(M.get(), ShouldLazyLoadMetadata, IsImporting))
+  if (Error Err = R->parseBitcodeInto(M.get(), ShouldLazyLoadMetadata,
+                                      IsImporting, Cache))
     return std::move(Err);
 
   if (MaterializeAll) {
@@ -5626,8 +5706,9 @@ BitcodeModule::getModuleImpl(LLVMContext &Context, bool MaterializeAll,
 
 Expected<std::unique_ptr<Module>>
 BitcodeModule::getLazyModule(LLVMContext &Context, bool ShouldLazyLoadMetadata,
-                             bool IsImporting) {
-  return getModuleImpl(Context, false, ShouldLazyLoadMetadata, IsImporting);
+                             bool IsImporting, BitcodeLazyLoadCache *Cache) {
+  return getModuleImpl(Context, false, ShouldLazyLoadMetadata, IsImporting,
+                       Cache);
 }
 
 // Parse the specified bitcode buffer and merge the index into CombinedIndex.
@@ -5728,7 +5809,7 @@ Expected<std::unique_ptr<Module>> llvm::getOwningLazyBitcodeModule(
 
 Expected<std::unique_ptr<Module>>
 BitcodeModule::parseModule(LLVMContext &Context) {
-  return getModuleImpl(Context, true, false, false);
+  return getModuleImpl(Context, true, false, false, nullptr);
   // TODO: Restore the use-lists to the in-memory state when the bitcode was
   // written.  We must defer until the Module has been fully materialized.
 }
@@ -463,6 +463,10 @@ class MetadataLoader::MetadataLoaderImpl {
   /// True if metadata is being parsed for a module being ThinLTO imported.
   bool IsImporting = false;
 
+  /// Cache of the MDString and record indexes shared with the other readers of
+  /// the buffer, if any.
+  BitcodeLazyLoadCache *LazyLoadCache = nullptr;
+
   Error parseOneMetadata(SmallVectorImpl<uint64_t> &Record, unsigned Code,
                          PlaceholderQueue &Placeholders, StringRef Blob,
                          unsigned &NextMetadataNo);
@@ -629,10 +633,11 @@ public:
   MetadataLoaderImpl(BitstreamCursor &Stream, Module &TheModule,
                      BitcodeReaderValueList &ValueList,
                      std::function<Type *(unsigned)> getTypeByID,
-                     bool IsImporting)
+                     bool IsImporting, BitcodeLazyLoadCache *Cache)
       : MetadataList(TheModule.getContext()), ValueList(ValueList),
         Stream(Stream), Context(TheModule.getContext()), TheModule(TheModule),
-        getTypeByID(std::move(getTypeByID)), IsImporting(IsImporting) {}
+        getTypeByID(std::move(getTypeByID)), IsImporting(IsImporting),
+        LazyLoadCache(Cache) {}
 
   Error parseMetadata(bool ModuleLevel);
 
@@ -680,6 +685,17 @@ public:
 Expected<bool>
 MetadataLoader::MetadataLoaderImpl::lazyLoadModuleMetadataBlock() {
   IndexCursor = Stream;
+  // When another reader already indexed this block, reuse its indexes and only
+  // process the records that create metadata in this module.
+  BitcodeLazyLoadCache::KeyTy CacheKey(Stream.getBitcodeBytes().data(),
+                                       Stream.GetCurrentBitNo());
+  std::shared_ptr<const BitcodeLazyLoadCache::MetadataIndex> Cached;
+  if (LazyLoadCache)
+    Cached = LazyLoadCache->getMetadataIndex(CacheKey);
+  if (Cached) {
+    MDStringRef = Cached->Strings;
+    GlobalMetadataBitPosIndex = Cached->BitPositions;
+  }
   SmallVector<uint64_t, 64> Record;
   // Get the abbrevs, and preload record positions to make them lazy-loadable.
   while (true) {
@@ -690,6 +706,9 @@ MetadataLoader::MetadataLoaderImpl::lazyLoadModuleMetadataBlock() {
     case BitstreamEntry::Error:
       return error("Malformed block");
     case BitstreamEntry::EndBlock: {
+      if (LazyLoadCache && !Cached)
+        LazyLoadCache->addMetadataIndex(
+            CacheKey, {MDStringRef, GlobalMetadataBitPosIndex});
       return true;
     }
     case BitstreamEntry::Record: {
@@ -699,6 +718,8 @@ MetadataLoader::MetadataLoaderImpl::lazyLoadModuleMetadataBlock() {
       auto Code = IndexCursor.skipRecord(Entry.ID);
       switch (Code) {
       case bitc::METADATA_STRINGS: {
+        if (Cached)
+          break;
         // Rewind and parse the strings.
         IndexCursor.JumpToBit(CurrentPos);
         StringRef Blob;
@@ -729,6 +750,10 @@ MetadataLoader::MetadataLoaderImpl::lazyLoadModuleMetadataBlock() {
         assert(Entry.Kind == BitstreamEntry::Record &&
                "Corrupted bitcode: Expected `Record` when trying to find the "
                "Metadata index");
+        if (Cached) {
+          IndexCursor.skipRecord(Entry.ID);
+          break;
+        }
         Record.clear();
         auto Code = IndexCursor.readRecord(Entry.ID, Record);
         (void)Code;
@@ -1933,9 +1958,11 @@ MetadataLoader::~MetadataLoader() = default;
 MetadataLoader::MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                                BitcodeReaderValueList &ValueList,
                                bool IsImporting,
-                               std::function<Type *(unsigned)> getTypeByID)
-    : Pimpl(llvm::make_unique<MetadataLoaderImpl>(
-          Stream, TheModule, ValueList, std::move(getTypeByID), IsImporting)) {}
+                               std::function<Type *(unsigned)> getTypeByID,
+                               BitcodeLazyLoadCache *Cache)
+    : Pimpl(llvm::make_unique<MetadataLoaderImpl>(Stream, TheModule, ValueList,
+                                                  std::move(getTypeByID),
+                                                  IsImporting, Cache)) {}
 
 Error MetadataLoader::parseMetadata(bool ModuleLevel) {
   return Pimpl->parseMetadata(ModuleLevel);
@@ -21,6 +21,7 @@
 #include <memory>
 
 namespace llvm {
+class BitcodeLazyLoadCache;
 class BitcodeReaderValueList;
 class BitstreamCursor;
 class DISubprogram;
@@ -42,7 +43,8 @@ public:
   ~MetadataLoader();
   MetadataLoader(BitstreamCursor &Stream, Module &TheModule,
                  BitcodeReaderValueList &ValueList, bool IsImporting,
-                 std::function<Type *(unsigned)> getTypeByID);
+                 std::function<Type *(unsigned)> getTypeByID,
+                 BitcodeLazyLoadCache *Cache = nullptr);
   MetadataLoader &operator=(MetadataLoader &&);
   MetadataLoader(MetadataLoader &&);
 
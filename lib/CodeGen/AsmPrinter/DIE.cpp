@@ -142,11 +142,25 @@ DIEAbbrevSet::~DIEAbbrevSet() {
     Abbrev->~DIEAbbrev();
 }
 
+/// Gather the same data as DIEAbbrev::Profile for the abbreviation of \p Die,
+/// without generating it.
+static void profileAbbrev(const DIE &Die, FoldingSetNodeID &ID) {
+  ID.AddInteger(unsigned(Die.getTag()));
+  ID.AddInteger(unsigned(Die.hasChildren()));
+  for (const DIEValue &V : Die.values()) {
+    ID.AddInteger(unsigned(V.getAttribute()));
+    ID.AddInteger(unsigned(V.getForm()));
+    if (V.getForm() == dwarf::DW_FORM_implicit_const)
+      ID.AddInteger(int64_t(V.getDIEInteger().getValue()));
+  }
+}
+
 DIEAbbrev &DIEAbbrevSet::uniqueAbbreviation(DIE &Die) {
 
+  // Most DIEs reuse an existing abbreviation, so only generate it for the
+  // ones that do not.
   FoldingSetNodeID ID;
-  DIEAbbrev Abbrev = Die.generateAbbrev();
-  Abbrev.Profile(ID);
+  profileAbbrev(Die, ID);
 
   void *InsertPos;
   if (DIEAbbrev *Existing =
@@ -156,7 +170,7 @@ DIEAbbrev &DIEAbbrevSet::uniqueAbbreviation(DIE &Die) {
   }
 
   // Move the abbreviation to the heap and assign a number.
-  DIEAbbrev *New = new (Alloc) DIEAbbrev(std::move(Abbrev));
+  DIEAbbrev *New = new (Alloc) DIEAbbrev(Die.generateAbbrev());
   Abbreviations.push_back(New);
   New->setNumber(Abbreviations.size());
   Die.setAbbrevNumber(Abbreviations.size());
@@ -148,6 +148,11 @@ static const char *const DWARFGroupName = "dwarf";
 static const char *const DWARFGroupDescription = "DWARF Emission";
 static const char *const DbgTimerName = "writer";
 static const char *const DbgTimerDescription = "DWARF Debug Writer";
+static const char *const FinalizeTimerName = "finalize";
+static const char *const FinalizeTimerDescription =
+    "DWARF Unit Finalization and Sizing";
+static const char *const InfoTimerName = "info";
+static const char *const InfoTimerDescription = "DWARF Debug Info Section";
 
 void DebugLocDwarfExpression::emitOp(uint8_t Op, const char *Comment) {
   BS.EmitInt8(
@@ -748,7 +753,12 @@ void DwarfDebug::endModule() {
     return;
 
   // Finalize the debug info for the module.
-  finalizeModuleInfo();
+  {
+    NamedRegionTimer T(FinalizeTimerName, FinalizeTimerDescription,
+                       DWARFGroupName, DWARFGroupDescription,
+                       TimePassesIsEnabled);
+    finalizeModuleInfo();
+  }
 
   emitDebugStr();
 
@@ -762,7 +772,11 @@ void DwarfDebug::endModule() {
   emitAbbreviations();
 
   // Emit all the DIEs into a debug info section.
-  emitDebugInfo();
+  {
+    NamedRegionTimer T(InfoTimerName, InfoTimerDescription, DWARFGroupName,
+                       DWARFGroupDescription, TimePassesIsEnabled);
+    emitDebugInfo();
+  }
 
   // Emit info into a debug aranges section.
   if (GenerateARangeSection)
@@ -15,6 +15,7 @@
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/CodeGen/GlobalISel/CallLowering.h"
@@ -70,6 +71,9 @@
 
 #define DEBUG_TYPE "irtranslator"
 
+STATISTIC(NumFunctionsFailed,
+          "Number of functions that fell back in the IRTranslator");
+
 using namespace llvm;
 
 char IRTranslator::ID = 0;
@@ -85,6 +89,7 @@ static void reportTranslationError(MachineFunction &MF,
                                    OptimizationRemarkEmitter &ORE,
                                    OptimizationRemarkMissed &R) {
   MF.getProperties().set(MachineFunctionProperties::Property::FailedISel);
+  ++NumFunctionsFailed;
 
   // Print the function name explicitly if we don't have a debug location (which
   // makes the diagnostic less useful) or if we're going to emit a raw error.
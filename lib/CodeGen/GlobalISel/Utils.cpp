@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
 #include "llvm/CodeGen/MachineInstr.h"
@@ -24,6 +26,13 @@
 
 #define DEBUG_TYPE "globalisel-utils"
 
+STATISTIC(NumLegalizeFailures,
+          "Number of functions that fell back in the Legalizer");
+STATISTIC(NumRegBankSelectFailures,
+          "Number of functions that fell back in RegBankSelect");
+STATISTIC(NumSelectFailures,
+          "Number of functions that fell back in InstructionSelect");
+
 using namespace llvm;
 
 unsigned llvm::constrainRegToClass(MachineRegisterInfo &MRI,
@@ -82,6 +91,16 @@ void llvm::reportGISelFailure(MachineFunction &MF, const TargetPassConfig &TPC,
                               MachineOptimizationRemarkMissed &R) {
   MF.getProperties().set(MachineFunctionProperties::Property::FailedISel);
 
+  // Each function fails at most once: the later passes skip it.
+  Statistic *Failures = StringSwitch<Statistic *>(R.getPassName())
+                            .Case("gisel-legalize", &NumLegalizeFailures)
+                            .Case("gisel-regbankselect",
+                                  &NumRegBankSelectFailures)
+                            .Case("gisel-select", &NumSelectFailures)
+                            .Default(nullptr);
+  if (Failures)
+    ++*Failures;
+
   // Print the function name explicitly if we don't have a debug location (which
   // makes the diagnostic less useful) or if we're going to emit a raw error.
   if (!R.getLocation().isValid() || TPC.isGlobalISelAbortEnabled())
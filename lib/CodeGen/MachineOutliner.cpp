@@ -38,18 +38,39 @@
 /// For more information on the suffix tree data structure, please see
 /// https://www.cs.helsinki.fi/u/ukkonen/SuffixT1withFigs.pdf
 ///
+/// The same repeated sequences can be found from the suffix and LCP arrays of
+/// the instructions (-outliner-repeat-finder=suffix-array), which take a few
+/// flat arrays instead of a heap node and a map per instruction. Their build
+/// time is reported by -time-passes and the size of the tree by -debug-only.
+///
+/// Outlining adds a call and a return to every candidate, so it is a bad trade
+/// in hot code. Blocks with a hot profile count are never outlined from, and
+/// -outliner-cold-only restricts the pass to cold blocks: blocks with a cold
+/// profile count, or, without a profile, blocks much less frequent than their
+/// function's entry. Outlining can also expose new repeats, for instance calls
+/// to the same outlined function, which -outliner-rounds finds by running the
+/// whole pass again.
+///
 //===----------------------------------------------------------------------===//
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineBranchProbabilityInfo.h"
+#include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/SuffixArray.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include "llvm/Target/TargetMachine.h"
@@ -67,6 +88,37 @@ using namespace llvm;
 
 STATISTIC(NumOutlined, "Number of candidates outlined");
 STATISTIC(FunctionsCreated, "Number of functions created");
+STATISTIC(NumBlocksSkipped, "Number of blocks too hot to outline from");
+STATISTIC(NumRounds, "Number of outlining rounds run");
+
+namespace {
+/// The structure queried for repeated sequences of instructions.
+enum class RepeatFinderKind { SuffixTree, SuffixArray };
+} // Anonymous namespace.
+
+static cl::opt<RepeatFinderKind> RepeatFinder(
+    "outliner-repeat-finder", cl::Hidden,
+    cl::init(RepeatFinderKind::SuffixTree),
+    cl::desc("Structure used to find repeated sequences of instructions"),
+    cl::values(clEnumValN(RepeatFinderKind::SuffixTree, "suffix-tree",
+                          "Ukkonen suffix tree"),
+               clEnumValN(RepeatFinderKind::SuffixArray, "suffix-array",
+                          "Suffix and LCP arrays, about 20 bytes per "
+                          "instruction")));
+
+static cl::opt<bool> OutlineColdOnly(
+    "outliner-cold-only", cl::Hidden, cl::init(false),
+    cl::desc("Only outline from cold blocks"));
+
+static cl::opt<unsigned> ColdFreqRatio(
+    "outliner-cold-freq-ratio", cl::Hidden, cl::init(8),
+    cl::desc("Without a profile, blocks executed at least this many times less "
+             "often than their function's entry are cold"));
+
+static cl::opt<unsigned> OutlinerRounds(
+    "outliner-rounds", cl::Hidden, cl::init(1),
+    cl::desc("Maximum number of times to look for and outline repeated "
+             "sequences"));
 
 namespace {
 
@@ -557,6 +609,59 @@ public:
     assert(Root && "Root node can't be nullptr!");
     setSuffixIndices(*Root, 0);
   }
+
+  /// Return the repeated substrings of the tree, in the order of their first
+  /// leaf: the internal nodes with at least two leaf children, with the
+  /// suffix indices of those leaves.
+  ///
+  /// If a substring appears at least twice, then it must be represented by
+  /// an internal node which appears in at least two suffixes. Each suffix is
+  /// represented by a leaf node.
+  ///
+  /// The nodes are marked as visited, so this can only be called once.
+  std::vector<RepeatedSubstring> getRepeatedSubstrings() {
+    std::vector<RepeatedSubstring> Repeats;
+    // FIXME: Visit internal nodes instead of leaves.
+    for (SuffixTreeNode *Leaf : LeafVector) {
+      assert(Leaf && "Leaves in LeafVector cannot be null!");
+      assert(Leaf->Parent && "All leaves must have parents!");
+      SuffixTreeNode &Parent = *(Leaf->Parent);
+
+      // If it doesn't appear enough, or we already visited it, skip it.
+      if (Parent.OccurrenceCount < 2 || Parent.isRoot() || !Parent.IsInTree)
+        continue;
+
+      RepeatedSubstring RS;
+      RS.Length = Leaf->ConcatLen - Leaf->size();
+      for (auto &ChildPair : Parent.Children)
+        if (ChildPair.second->isLeaf())
+          RS.StartIndices.push_back(ChildPair.second->SuffixIdx);
+      std::sort(RS.StartIndices.begin(), RS.StartIndices.end());
+      // The occurrence count of a node is its number of leaf children, so
+      // the candidates found from the start indices cost the same as before.
+      assert(RS.StartIndices.size() == Parent.OccurrenceCount &&
+             "Occurrence count doesn't match the leaf children!");
+      Repeats.push_back(std::move(RS));
+
+      // Never visit this node again.
+      Parent.IsInTree = false;
+    }
+    return Repeats;
+  }
+
+  /// Return the memory used by the tree, in bytes.
+  size_t getMemorySize() const {
+    size_t Size = LeafVector.capacity() * sizeof(SuffixTreeNode *) +
+                  InternalEndIdxAllocator.getTotalMemory();
+    SmallVector<const SuffixTreeNode *, 32> Worklist(1, Root);
+    while (!Worklist.empty()) {
+      const SuffixTreeNode *N = Worklist.pop_back_val();
+      Size += sizeof(SuffixTreeNode) + N->Children.getMemorySize();
+      for (auto &ChildPair : N->Children)
+        Worklist.push_back(ChildPair.second);
+    }
+    return Size;
+  }
 };
 
 /// \brief Maps \p MachineInstrs to unsigned integers and stores the mappings.
@@ -716,8 +821,14 @@ struct MachineOutliner : public ModulePass {
 
   StringRef getPassName() const override { return "Machine Outliner"; }
 
+  /// The number of functions outlined by earlier rounds, which the names of
+  /// the functions of the current round are numbered after.
+  size_t OutlinedFunctionNum = 0;
+
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<MachineModuleInfo>();
+    AU.addRequired<MachineBranchProbabilityInfo>();
+    AU.addRequired<ProfileSummaryInfoWrapperPass>();
     AU.addPreserved<MachineModuleInfo>();
     AU.setPreservesAll();
     ModulePass::getAnalysisUsage(AU);
@@ -729,14 +840,13 @@ struct MachineOutliner : public ModulePass {
 
   /// Find all repeated substrings that satisfy the outlining cost model.
   ///
-  /// If a substring appears at least twice, then it must be represented by
-  /// an internal node which appears in at least two suffixes. Each suffix is
-  /// represented by a leaf node. To do this, we visit each internal node in
-  /// the tree, using the leaf children of each internal node. If an internal
-  /// node represents a beneficial substring, then we use each of its leaf
-  /// children to find the locations of its substring.
+  /// The repeated substrings are the internal nodes of the suffix tree of
+  /// \p Str with their leaf children, as found by a \p SuffixTree or by
+  /// \p findRepeatedSubstrings. If an internal node represents a beneficial
+  /// substring, then each of its leaf children is the location of a candidate.
   ///
-  /// \param ST A suffix tree to query.
+  /// \param Str The instruction mapping of the module.
+  /// \param Repeats The repeated substrings of \p Str.
   /// \param TII TargetInstrInfo for the target.
   /// \param Mapper Contains outlining mapping information.
   /// \param[out] CandidateList Filled with candidates representing each
@@ -745,8 +855,9 @@ struct MachineOutliner : public ModulePass {
   /// type of candidate.
   ///
   /// \returns The length of the longest candidate found.
-  size_t findCandidates(SuffixTree &ST, const TargetInstrInfo &TII,
-                        InstructionMapper &Mapper,
+  size_t findCandidates(ArrayRef<unsigned> Str,
+                        ArrayRef<RepeatedSubstring> Repeats,
+                        const TargetInstrInfo &TII, InstructionMapper &Mapper,
                         std::vector<Candidate> &CandidateList,
                         std::vector<OutlinedFunction> &FunctionList);
 
@@ -775,13 +886,13 @@ struct MachineOutliner : public ModulePass {
   /// \param[out] CandidateList Filled with outlining candidates for the module.
   /// \param[out] FunctionList Filled with functions corresponding to each type
   /// of \p Candidate.
-  /// \param ST The suffix tree for the module.
+  /// \param Mapper Contains the instruction mappings for the module.
   /// \param TII TargetInstrInfo for the module.
   ///
   /// \returns The length of the longest candidate found. 0 if there are none.
   unsigned buildCandidateList(std::vector<Candidate> &CandidateList,
                               std::vector<OutlinedFunction> &FunctionList,
-                              SuffixTree &ST, InstructionMapper &Mapper,
+                              InstructionMapper &Mapper,
                               const TargetInstrInfo &TII);
 
   /// \brief Remove any overlapping candidates that weren't handled by the
@@ -802,8 +913,21 @@ struct MachineOutliner : public ModulePass {
                      InstructionMapper &Mapper, unsigned MaxCandidateLen,
                      const TargetInstrInfo &TII);
 
-  /// Construct a suffix tree on the instructions in \p M and outline repeated
-  /// strings from that tree.
+  /// Return true if instructions may be outlined from \p MBB, given the block
+  /// frequencies \p MBFI of its function and the profile summary \p PSI.
+  bool isBlockColdEnough(const MachineBasicBlock &MBB,
+                         const MachineBlockFrequencyInfo &MBFI,
+                         ProfileSummaryInfo &PSI);
+
+  /// Map the instructions of \p M, find repeated sequences in them and
+  /// outline the beneficial ones.
+  ///
+  /// \returns true if something was outlined.
+  bool outlineRepeats(Module &M, const TargetRegisterInfo &TRI,
+                      const TargetInstrInfo &TII);
+
+  /// Find and outline repeated sequences in \p M until nothing is outlined or
+  /// -outliner-rounds rounds have run.
   bool runOnModule(Module &M) override;
 };
 
@@ -815,35 +939,27 @@ namespace llvm {
 ModulePass *createMachineOutlinerPass() { return new MachineOutliner(); }
 } // namespace llvm
 
-INITIALIZE_PASS(MachineOutliner, DEBUG_TYPE, "Machine Function Outliner", false,
-                false)
+INITIALIZE_PASS_BEGIN(MachineOutliner, DEBUG_TYPE, "Machine Function Outliner",
+                      false, false)
+INITIALIZE_PASS_DEPENDENCY(MachineBranchProbabilityInfo)
+INITIALIZE_PASS_DEPENDENCY(ProfileSummaryInfoWrapperPass)
+INITIALIZE_PASS_END(MachineOutliner, DEBUG_TYPE, "Machine Function Outliner",
+                    false, false)
 
-size_t
-MachineOutliner::findCandidates(SuffixTree &ST, const TargetInstrInfo &TII,
-                                InstructionMapper &Mapper,
-                                std::vector<Candidate> &CandidateList,
-                                std::vector<OutlinedFunction> &FunctionList) {
+size_t MachineOutliner::findCandidates(
+    ArrayRef<unsigned> Str, ArrayRef<RepeatedSubstring> Repeats,
+    const TargetInstrInfo &TII, InstructionMapper &Mapper,
+    std::vector<Candidate> &CandidateList,
+    std::vector<OutlinedFunction> &FunctionList) {
 
   CandidateList.clear();
   FunctionList.clear();
   size_t FnIdx = 0;
   size_t MaxLen = 0;
 
-  // FIXME: Visit internal nodes instead of leaves.
-  for (SuffixTreeNode *Leaf : ST.LeafVector) {
-    assert(Leaf && "Leaves in LeafVector cannot be null!");
-    if (!Leaf->IsInTree)
-      continue;
-
-    assert(Leaf->Parent && "All leaves must have parents!");
-    SuffixTreeNode &Parent = *(Leaf->Parent);
-
-    // If it doesn't appear enough, or we already outlined from it, skip it.
-    if (Parent.OccurrenceCount < 2 || Parent.isRoot() || !Parent.IsInTree)
-      continue;
-
+  for (const RepeatedSubstring &RS : Repeats) {
     // Figure out if this candidate is beneficial.
-    size_t StringLen = Leaf->ConcatLen - Leaf->size();
+    size_t StringLen = RS.Length;
 
     // Too short to be beneficial; skip it.
     // FIXME: This isn't necessarily true for, say, X86. If we factor in
@@ -865,27 +981,20 @@ MachineOutliner::findCandidates(SuffixTree &ST, const TargetInstrInfo &TII,
         CandidateClass;
 
     // Figure out the call overhead for each instance of the sequence.
-    for (auto &ChildPair : Parent.Children) {
-      SuffixTreeNode *M = ChildPair.second;
-
-      if (M && M->IsInTree && M->isLeaf()) {
-        // Each sequence is over [StartIt, EndIt].
-        MachineBasicBlock::iterator StartIt = Mapper.InstrList[M->SuffixIdx];
-        MachineBasicBlock::iterator EndIt =
-            Mapper.InstrList[M->SuffixIdx + StringLen - 1];
-
-        // Get the overhead for calling a function for this sequence and any
-        // target-specified data for how to construct the call.
-        std::pair<size_t, unsigned> CallOverheadPair =
-            TII.getOutliningCallOverhead(StartIt, EndIt);
-        CallOverhead += CallOverheadPair.first;
-        CandidatesForRepeatedSeq.emplace_back(M->SuffixIdx, StringLen, FnIdx,
-                                              CallOverheadPair.second);
-        CandidateClass.emplace_back(std::make_pair(StartIt, EndIt));
-
-        // Never visit this leaf again.
-        M->IsInTree = false;
-      }
+    for (unsigned StartIdx : RS.StartIndices) {
+      // Each sequence is over [StartIt, EndIt].
+      MachineBasicBlock::iterator StartIt = Mapper.InstrList[StartIdx];
+      MachineBasicBlock::iterator EndIt =
+          Mapper.InstrList[StartIdx + StringLen - 1];
+
+      // Get the overhead for calling a function for this sequence and any
+      // target-specified data for how to construct the call.
+      std::pair<size_t, unsigned> CallOverheadPair =
+          TII.getOutliningCallOverhead(StartIt, EndIt);
+      CallOverhead += CallOverheadPair.first;
+      CandidatesForRepeatedSeq.emplace_back(StartIdx, StringLen, FnIdx,
+                                            CallOverheadPair.second);
+      CandidateClass.emplace_back(std::make_pair(StartIt, EndIt));
     }
 
     std::pair<size_t, unsigned> FrameOverheadPair =
@@ -893,7 +1002,9 @@ MachineOutliner::findCandidates(SuffixTree &ST, const TargetInstrInfo &TII,
     size_t FrameOverhead = FrameOverheadPair.first;
 
     size_t OutliningCost = CallOverhead + FrameOverhead + SequenceOverhead;
-    size_t NotOutliningCost = SequenceOverhead * Parent.OccurrenceCount;
+    // Each start index is an occurrence of the sequence. For the suffix tree,
+    // this is the occurrence count of the node.
+    size_t NotOutliningCost = SequenceOverhead * RS.StartIndices.size();
 
     if (NotOutliningCost <= OutliningCost)
       continue;
@@ -911,17 +1022,17 @@ MachineOutliner::findCandidates(SuffixTree &ST, const TargetInstrInfo &TII,
     }
 
     // Save the function for the new candidate sequence.
-    std::vector<unsigned> CandidateSequence;
-    for (unsigned i = Leaf->SuffixIdx; i < Leaf->SuffixIdx + StringLen; i++)
-      CandidateSequence.push_back(ST.Str[i]);
+    std::vector<unsigned> CandidateSequence(
+        Str.begin() + RS.StartIndices[0],
+        Str.begin() + RS.StartIndices[0] + StringLen);
 
-    FunctionList.emplace_back(FnIdx, CandidatesForRepeatedSeq.size(),
+    FunctionList.emplace_back(OutlinedFunctionNum + FnIdx,
+                              CandidatesForRepeatedSeq.size(),
                               CandidateSequence, Benefit,
                               FrameOverheadPair.second);
 
     // Move to the next function.
     FnIdx++;
-    Parent.IsInTree = false;
   }
 
   return MaxLen;
@@ -1071,14 +1182,27 @@ void MachineOutliner::pruneOverlaps(std::vector<Candidate> &CandidateList,
 unsigned
 MachineOutliner::buildCandidateList(std::vector<Candidate> &CandidateList,
                                     std::vector<OutlinedFunction> &FunctionList,
-                                    SuffixTree &ST, InstructionMapper &Mapper,
+                                    InstructionMapper &Mapper,
                                     const TargetInstrInfo &TII) {
 
-  std::vector<unsigned> CandidateSequence; // Current outlining candidate.
-  size_t MaxCandidateLen = 0;              // Length of the longest candidate.
+  // Find the repeated sequences of instructions. Both structures find the
+  // same ones, in the same order.
+  std::vector<RepeatedSubstring> Repeats;
+  {
+    NamedRegionTimer T("find-repeats", "Find repeated sequences", DEBUG_TYPE,
+                       "Machine Outliner", TimePassesIsEnabled);
+    if (RepeatFinder == RepeatFinderKind::SuffixArray) {
+      Repeats = findRepeatedSubstrings(Mapper.UnsignedVec);
+    } else {
+      SuffixTree ST(Mapper.UnsignedVec);
+      DEBUG(dbgs() << "Suffix tree size: " << ST.getMemorySize()
+                   << " bytes for " << ST.Str.size() << " instructions\n");
+      Repeats = ST.getRepeatedSubstrings();
+    }
+  }
 
-  MaxCandidateLen =
-      findCandidates(ST, TII, Mapper, CandidateList, FunctionList);
+  size_t MaxCandidateLen = findCandidates(Mapper.UnsignedVec, Repeats, TII,
+                                          Mapper, CandidateList, FunctionList);
 
   // Sort the candidates in decending order. This will simplify the outlining
   // process when we have to remove the candidates from the mapping by
@@ -1201,17 +1325,33 @@ bool MachineOutliner::outline(Module &M,
   return OutlinedSomething;
 }
 
-bool MachineOutliner::runOnModule(Module &M) {
+bool MachineOutliner::isBlockColdEnough(const MachineBasicBlock &MBB,
+                                        const MachineBlockFrequencyInfo &MBFI,
+                                        ProfileSummaryInfo &PSI) {
+  // Trust the profile when there is one.
+  if (PSI.hasProfileSummary())
+    if (Optional<uint64_t> Count = MBFI.getBlockProfileCount(&MBB)) {
+      if (PSI.isHotCount(*Count))
+        return false;
+      return !OutlineColdOnly || PSI.isColdCount(*Count);
+    }
 
-  // Is there anything in the module at all?
-  if (M.empty())
-    return false;
+  if (!OutlineColdOnly)
+    return true;
+
+  // Otherwise, estimate from the static frequency of the block.
+  return MBFI.getBlockFreq(&MBB).getFrequency() * ColdFreqRatio <=
+         MBFI.getEntryFreq();
+}
 
+bool MachineOutliner::outlineRepeats(Module &M, const TargetRegisterInfo &TRI,
+                                     const TargetInstrInfo &TII) {
   MachineModuleInfo &MMI = getAnalysis<MachineModuleInfo>();
-  const TargetSubtargetInfo &STI =
-      MMI.getOrCreateMachineFunction(*M.begin()).getSubtarget();
-  const TargetRegisterInfo *TRI = STI.getRegisterInfo();
-  const TargetInstrInfo *TII = STI.getInstrInfo();
+  auto &MBPI = getAnalysis<MachineBranchProbabilityInfo>();
+  ProfileSummaryInfo &PSI =
+      *getAnalysis<ProfileSummaryInfoWrapperPass>().getPSI();
+  // Frequencies are only needed to tell hot blocks from cold ones.
+  bool NeedsFrequencies = OutlineColdOnly || PSI.hasProfileSummary();
 
   InstructionMapper Mapper;
 
@@ -1220,9 +1360,20 @@ bool MachineOutliner::runOnModule(Module &M) {
     MachineFunction &MF = MMI.getOrCreateMachineFunction(F);
 
     // Is the function empty? Safe to outline from?
-    if (F.empty() || !TII->isFunctionSafeToOutlineFrom(MF))
+    if (F.empty() || !TII.isFunctionSafeToOutlineFrom(MF))
       continue;
 
+    // The pass is not in a machine function pass manager, so compute the
+    // block frequencies on the fly.
+    MachineDominatorTree MDT;
+    MachineLoopInfo MLI;
+    MachineBlockFrequencyInfo MBFI;
+    if (NeedsFrequencies) {
+      MDT.getBase().recalculate(MF);
+      MLI.getBase().analyze(MDT.getBase());
+      MBFI.calculate(MF, MBPI, MLI);
+    }
+
     // If it is, look at each MachineBasicBlock in the function.
     for (MachineBasicBlock &MBB : MF) {
 
@@ -1230,23 +1381,57 @@ bool MachineOutliner::runOnModule(Module &M) {
       if (MBB.empty())
         continue;
 
+      // Is it cold enough to pay for the calls? Leaving it out of the string
+      // keeps its instructions out of every candidate.
+      if (NeedsFrequencies && !isBlockColdEnough(MBB, MBFI, PSI)) {
+        ++NumBlocksSkipped;
+        continue;
+      }
+
       // If yes, map it.
-      Mapper.convertToUnsignedVec(MBB, *TRI, *TII);
+      Mapper.convertToUnsignedVec(MBB, TRI, TII);
     }
   }
 
-  // Construct a suffix tree, use it to find candidates, and then outline them.
-  SuffixTree ST(Mapper.UnsignedVec);
+  // Find the repeated sequences, use them to find candidates, and then outline
+  // them.
   std::vector<Candidate> CandidateList;
   std::vector<OutlinedFunction> FunctionList;
 
   // Find all of the outlining candidates.
   unsigned MaxCandidateLen =
-      buildCandidateList(CandidateList, FunctionList, ST, Mapper, *TII);
+      buildCandidateList(CandidateList, FunctionList, Mapper, TII);
 
   // Remove candidates that overlap with other candidates.
-  pruneOverlaps(CandidateList, FunctionList, Mapper, MaxCandidateLen, *TII);
+  pruneOverlaps(CandidateList, FunctionList, Mapper, MaxCandidateLen, TII);
 
   // Outline each of the candidates and return true if something was outlined.
-  return outline(M, CandidateList, FunctionList, Mapper);
+  bool OutlinedSomething = outline(M, CandidateList, FunctionList, Mapper);
+  OutlinedFunctionNum += FunctionList.size();
+  return OutlinedSomething;
+}
+
+bool MachineOutliner::runOnModule(Module &M) {
+
+  // Is there anything in the module at all?
+  if (M.empty())
+    return false;
+
+  MachineModuleInfo &MMI = getAnalysis<MachineModuleInfo>();
+  const TargetSubtargetInfo &STI =
+      MMI.getOrCreateMachineFunction(*M.begin()).getSubtarget();
+  const TargetRegisterInfo *TRI = STI.getRegisterInfo();
+  const TargetInstrInfo *TII = STI.getInstrInfo();
+
+  // Outlined functions are not outlined from again, but the calls to them
+  // may form new repeated sequences with the instructions around them.
+  OutlinedFunctionNum = 0;
+  bool Changed = false;
+  for (unsigned Round = 0; Round != OutlinerRounds; ++Round) {
+    ++NumRounds;
+    if (!outlineRepeats(M, *TRI, *TII))
+      break;
+    Changed = true;
+  }
+  return Changed;
 }
@@ -84,6 +84,8 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumOverBudget,   "Number of functions over the work budget");
+STATISTIC(NumBudgetSpills, "Number of live ranges spilled to meet the budget");
 
 static cl::opt<SplitEditor::ComplementSpillMode> SplitSpillMode(
     "split-spill-mode", cl::Hidden,
@@ -123,6 +125,17 @@ static cl::opt<bool> EnableDeferredSpilling(
              "variable because of other evicted variables."),
     cl::init(false));
 
+static cl::opt<unsigned> WorkBudget(
+    "regalloc-work-budget", cl::Hidden,
+    cl::desc("Work units the greedy allocator may spend on a function before "
+             "it trades code quality for compile time (0 = unlimited)"),
+    cl::init(0));
+
+static cl::opt<unsigned> BudgetRecoloringMaxDepth(
+    "regalloc-budget-lcr-max-depth", cl::Hidden,
+    cl::desc("Last chance recoloring max depth past half the work budget"),
+    cl::init(1));
+
 // FIXME: Find a good default for this flag and remove the flag.
 static cl::opt<unsigned>
 CSRFirstTimeCost("regalloc-csr-first-time-cost",
@@ -223,6 +236,30 @@ class RAGreedy : public MachineFunctionPass,
 
   uint8_t CutOffInfo;
 
+  // With -regalloc-work-budget, allocation degrades as a function uses up its
+  // budget, so that huge functions trade code quality for compile time. A
+  // work unit is roughly one interference check of a live range against one
+  // physical register.
+  enum BudgetLevel {
+    /// Under half the budget: nothing is cut.
+    BL_Normal,
+
+    /// Past half the budget: last chance recoloring is limited to
+    /// -regalloc-budget-lcr-max-depth.
+    BL_LimitRecoloring,
+
+    /// Past the budget: no region or local splitting, only splitting around
+    /// blocks and instructions, and no hint recoloring.
+    BL_CheapSplit,
+
+    /// Past twice the budget: spillable ranges that don't get a free register
+    /// are spilled without eviction or splitting.
+    BL_SpillEverywhere
+  };
+
+  uint64_t WorkUnits;
+  BudgetLevel Budget;
+
 #ifndef NDEBUG
   static const char *const StageName[];
 #endif
@@ -372,6 +409,10 @@ private:
   unsigned selectOrSplitImpl(LiveInterval &, SmallVectorImpl<unsigned> &,
                              SmallVirtRegSet &, unsigned = 0);
 
+  /// Add \p Units to the work done on the current function, and degrade
+  /// allocation as the work budget runs out.
+  void chargeWork(uint64_t Units);
+
   bool LRE_CanEraseVirtReg(unsigned) override;
   void LRE_WillShrinkVirtReg(unsigned) override;
   void LRE_DidCloneVirtReg(unsigned, unsigned) override;
@@ -929,6 +970,7 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
   BestCost.setMax();
   unsigned BestPhys = 0;
   unsigned OrderLimit = Order.getOrder().size();
+  chargeWork(OrderLimit);
 
   // When we are just looking for a reduced cost per use, don't break any
   // hints, and only evict smaller spill weights.
@@ -2015,9 +2057,13 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
     NamedRegionTimer T("local_split", "Local Splitting", TimerGroupName,
                        TimerGroupDescription, TimePassesIsEnabled);
     SA->analyze(&VirtReg);
-    unsigned PhysReg = tryLocalSplit(VirtReg, Order, NewVRegs);
-    if (PhysReg || !NewVRegs.empty())
-      return PhysReg;
+    // Local splitting computes gap weights against every register.
+    if (Budget < BL_CheapSplit) {
+      chargeWork(SA->getUseSlots().size() * Order.getOrder().size());
+      unsigned PhysReg = tryLocalSplit(VirtReg, Order, NewVRegs);
+      if (PhysReg || !NewVRegs.empty())
+        return PhysReg;
+    }
     return tryInstructionSplit(VirtReg, Order, NewVRegs);
   }
 
@@ -2039,8 +2085,11 @@ unsigned RAGreedy::trySplit(LiveInterval &VirtReg, AllocationOrder &Order,
 
   // First try to split around a region spanning multiple blocks. RS_Split2
   // ranges already made dubious progress with region splitting, so they go
-  // straight to single block splitting.
-  if (getStage(VirtReg) < RS_Split2) {
+  // straight to single block splitting. So do all ranges past the work budget,
+  // as region splitting computes spill placements for every register.
+  if (getStage(VirtReg) < RS_Split2 && Budget < BL_CheapSplit) {
+    chargeWork((SA->getUseBlocks().size() + SA->getNumThroughBlocks()) *
+               Order.getOrder().size());
     unsigned PhysReg = tryRegionSplit(VirtReg, Order, NewVRegs);
     if (PhysReg || !NewVRegs.empty())
       return PhysReg;
@@ -2146,7 +2195,11 @@ unsigned RAGreedy::tryLastChanceRecoloring(LiveInterval &VirtReg,
   // We may want to reconsider that if we end up with a too large search space
   // for target with hundreds of registers.
   // Indeed, in that case we may want to cut the search space earlier.
-  if (Depth >= LastChanceRecoloringMaxDepth && !ExhaustiveSearch) {
+  unsigned MaxDepth = LastChanceRecoloringMaxDepth;
+  if (Budget >= BL_LimitRecoloring)
+    MaxDepth = std::min<unsigned>(MaxDepth, BudgetRecoloringMaxDepth);
+  chargeWork(Order.getOrder().size());
+  if (Depth >= MaxDepth && !ExhaustiveSearch) {
     DEBUG(dbgs() << "Abort because max depth has been reached.\n");
     CutOffInfo |= CO_Depth;
     return ~0u;
@@ -2549,6 +2602,8 @@ void RAGreedy::tryHintRecoloring(LiveInterval &VirtReg) {
 /// This is likely that we can assign the same register for b, c, and d,
 /// getting rid of 2 copies.
 void RAGreedy::tryHintsRecoloring() {
+  if (Budget >= BL_CheapSplit)
+    return;
   for (LiveInterval *LI : SetOfBrokenHints) {
     assert(TargetRegisterInfo::isVirtualRegister(LI->reg) &&
            "Recoloring is possible only for virtual registers");
@@ -2564,6 +2619,7 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
                                      SmallVectorImpl<unsigned> &NewVRegs,
                                      SmallVirtRegSet &FixedRegisters,
                                      unsigned Depth) {
+  chargeWork(1);
   unsigned CostPerUseLimit = ~0u;
   // First try assigning a free register.
   AllocationOrder Order(VirtReg.reg, *VRM, RegClassInfo, Matrix);
@@ -2587,10 +2643,15 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
   DEBUG(dbgs() << StageName[Stage]
                << " Cascade " << ExtraRegInfo[VirtReg.reg].Cascade << '\n');
 
+  // Past twice the work budget, spillable ranges are spilled right away.
+  // Unspillable ranges still need to evict to get a register.
+  bool SpillNow = Budget == BL_SpillEverywhere && VirtReg.isSpillable() &&
+                  Stage < RS_Done;
+
   // Try to evict a less worthy live range, but only for ranges from the primary
   // queue. The RS_Split ranges already failed to do this, and they should not
   // get a second chance until they have been split.
-  if (Stage != RS_Split)
+  if (Stage != RS_Split && !SpillNow)
     if (unsigned PhysReg =
             tryEvict(VirtReg, Order, NewVRegs, CostPerUseLimit)) {
       unsigned Hint = MRI->getSimpleHint(VirtReg.reg);
@@ -2609,14 +2670,14 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
   // The first time we see a live range, don't try to split or spill.
   // Wait until the second time, when all smaller ranges have been allocated.
   // This gives a better picture of the interference to split around.
-  if (Stage < RS_Split) {
+  if (Stage < RS_Split && !SpillNow) {
     setStage(VirtReg, RS_Split);
     DEBUG(dbgs() << "wait for second round\n");
     NewVRegs.push_back(VirtReg.reg);
     return 0;
   }
 
-  if (Stage < RS_Spill) {
+  if (Stage < RS_Spill && !SpillNow) {
     // Try splitting VirtReg or interferences.
     unsigned NewVRegSizeBefore = NewVRegs.size();
     unsigned PhysReg = trySplit(VirtReg, Order, NewVRegs);
@@ -2631,6 +2692,8 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
                                    Depth);
 
   // Finally spill VirtReg itself.
+  if (SpillNow)
+    ++NumBudgetSpills;
   if (EnableDeferredSpilling && getStage(VirtReg) < RS_Memory) {
     // TODO: This is experimental and in particular, we do not model
     // the live range splitting done by spilling correctly.
@@ -2655,6 +2718,25 @@ unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
   return 0;
 }
 
+void RAGreedy::chargeWork(uint64_t Units) {
+  WorkUnits += Units;
+  if (!WorkBudget || Budget == BL_SpillEverywhere)
+    return;
+
+  BudgetLevel Level = BL_Normal;
+  if (WorkUnits >= 2 * uint64_t(WorkBudget))
+    Level = BL_SpillEverywhere;
+  else if (WorkUnits >= WorkBudget)
+    Level = BL_CheapSplit;
+  else if (WorkUnits >= WorkBudget / 2)
+    Level = BL_LimitRecoloring;
+  if (Level > Budget) {
+    DEBUG(dbgs() << "Work budget level " << Level << " after " << WorkUnits
+                 << " units\n");
+    Budget = Level;
+  }
+}
+
 void RAGreedy::reportNumberOfSplillsReloads(MachineLoop *L, unsigned &Reloads,
                                             unsigned &FoldedReloads,
                                             unsigned &Spills,
@@ -2763,12 +2845,25 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
   SetOfBrokenHints.clear();
+  WorkUnits = 0;
+  Budget = BL_Normal;
 
   allocatePhysRegs();
   tryHintsRecoloring();
   postOptimization();
   reportNumberOfSplillsReloads();
 
+  if (Budget >= BL_CheapSplit) {
+    using namespace ore;
+
+    ++NumOverBudget;
+    MachineOptimizationRemarkMissed R(DEBUG_TYPE, "WorkBudget", DebugLoc(),
+                                      &MF->front());
+    ORE->emit(R << "register allocation used " << NV("WorkUnits", WorkUnits)
+                << " work units, over its budget of "
+                << NV("WorkBudget", unsigned(WorkBudget)));
+  }
+
   releaseMemory();
   return true;
 }
@@ -24,6 +24,7 @@ using namespace llvm;
 #define DEBUG_TYPE "reset-machine-function"
 
 STATISTIC(NumFunctionsReset, "Number of functions reset");
+STATISTIC(NumFunctionsKept, "Number of functions kept after selection");
 
 namespace {
   class ResetMachineFunction : public MachineFunctionPass {
@@ -57,6 +58,7 @@ namespace {
         }
         return true;
       }
+      ++NumFunctionsKept;
       return false;
     }
 
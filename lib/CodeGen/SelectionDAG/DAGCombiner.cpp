@@ -34,14 +34,18 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/KnownBits.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLowering.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/Target/TargetRegisterInfo.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
 #include <algorithm>
+#include <map>
 using namespace llvm;
 
 #define DEBUG_TYPE "dagcombine"
@@ -81,6 +85,18 @@ namespace {
     MaySplitLoadIndex("combiner-split-load-index", cl::Hidden, cl::init(true),
                       cl::desc("DAG combiner may split indexing from loads"));
 
+  static cl::opt<bool>
+    CombinerOpcodeStats("combiner-opcode-stats", cl::Hidden, cl::init(false),
+                        cl::desc("Print how often the nodes of each opcode "
+                                 "were visited and combined, at exit"));
+
+  /// Visits and successful combines of the nodes of one opcode.
+  struct OpcodeCombineCounts {
+    std::string Name;
+    uint64_t Visits = 0;
+    uint64_t Hits = 0;
+  };
+
 //------------------------------ DAGCombiner ---------------------------------//
 
   class DAGCombiner {
@@ -99,14 +115,12 @@ namespace {
     ///
     /// The worklist will not contain duplicates but may contain null entries
     /// due to nodes being deleted from the underlying DAG.
-    SmallVector<SDNode *, 64> Worklist;
-
-    /// \brief Mapping from an SDNode to its position on the worklist.
     ///
-    /// This is used to find and remove nodes from the worklist (by nulling
-    /// them) when they are deleted from the underlying DAG. It relies on
-    /// stable indices of nodes within the worklist.
-    DenseMap<SDNode *, unsigned> WorklistMap;
+    /// Each node on the worklist records its position in it, which is used to
+    /// find and remove nodes from the worklist (by nulling them) when they are
+    /// deleted from the underlying DAG. It relies on stable indices of nodes
+    /// within the worklist.
+    SmallVector<SDNode *, 64> Worklist;
 
     /// \brief Set of nodes which have been combined (at least once).
     ///
@@ -124,6 +138,29 @@ namespace {
         AddToWorklist(Node);
     }
 
+    /// Pop the next node to combine off the worklist, or return null if the
+    /// worklist is empty.
+    SDNode *getNextWorklistEntry() {
+      // The Worklist holds the SDNodes in order, but it may contain null
+      // entries.
+      SDNode *N = nullptr;
+      while (!N && !Worklist.empty())
+        N = Worklist.pop_back_val();
+
+      if (N) {
+        assert(N->getCombinerWorklistIndex() == (int)Worklist.size() &&
+               "Found a worklist entry with a different worklist index!");
+        N->setCombinerWorklistIndex(-1);
+      }
+      return N;
+    }
+
+    /// The counts of each opcode in this run, for -combiner-opcode-stats.
+    DenseMap<unsigned, OpcodeCombineCounts> OpcodeCombines;
+
+    /// Add the counts of this run to those printed at exit.
+    void flushOpcodeCombines();
+
     /// Call the node-specific routine that folds each particular type of node.
     SDValue visit(SDNode *N);
 
@@ -139,21 +176,23 @@ namespace {
       if (N->getOpcode() == ISD::HANDLENODE)
         return;
 
-      if (WorklistMap.insert(std::make_pair(N, Worklist.size())).second)
+      if (N->getCombinerWorklistIndex() < 0) {
+        N->setCombinerWorklistIndex(Worklist.size());
         Worklist.push_back(N);
+      }
     }
 
     /// Remove all instances of N from the worklist.
     void removeFromWorklist(SDNode *N) {
       CombinedNodes.erase(N);
 
-      auto It = WorklistMap.find(N);
-      if (It == WorklistMap.end())
+      int WorklistIndex = N->getCombinerWorklistIndex();
+      if (WorklistIndex < 0)
         return; // Not in the worklist.
 
       // Null out the entry rather than erasing it to avoid a linear operation.
-      Worklist[It->second] = nullptr;
-      WorklistMap.erase(It);
+      Worklist[WorklistIndex] = nullptr;
+      N->setCombinerWorklistIndex(-1);
     }
 
     void deleteAndRecombine(SDNode *N);
@@ -1380,18 +1419,7 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
   HandleSDNode Dummy(DAG.getRoot());
 
   // While the worklist isn't empty, find a node and try to combine it.
-  while (!WorklistMap.empty()) {
-    SDNode *N;
-    // The Worklist holds the SDNodes in order, but it may contain null entries.
-    do {
-      N = Worklist.pop_back_val();
-    } while (!N);
-
-    bool GoodWorklistEntry = WorklistMap.erase(N);
-    (void)GoodWorklistEntry;
-    assert(GoodWorklistEntry &&
-           "Found a worklist entry without a corresponding map entry!");
-
+  while (SDNode *N = getNextWorklistEntry()) {
     // If N has no uses, it is dead.  Make sure to revisit all N's operands once
     // N is deleted from the DAG, since they too may now be dead or may have a
     // reduced number of uses, allowing other xforms.
@@ -1424,8 +1452,19 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
       if (!CombinedNodes.count(ChildN.getNode()))
         AddToWorklist(ChildN.getNode());
 
+    OpcodeCombineCounts *Counts = nullptr;
+    if (CombinerOpcodeStats) {
+      Counts = &OpcodeCombines[N->getOpcode()];
+      if (Counts->Name.empty())
+        Counts->Name = N->getOperationName(&DAG);
+      ++Counts->Visits;
+    }
+
     SDValue RV = combine(N);
 
+    if (Counts && RV.getNode())
+      ++Counts->Hits;
+
     if (!RV.getNode())
       continue;
 
@@ -1467,6 +1506,57 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
   // If the root changed (e.g. it was a dead load, update the root).
   DAG.setRoot(Dummy.getValue());
   DAG.RemoveDeadNodes();
+
+  if (CombinerOpcodeStats)
+    flushOpcodeCombines();
+}
+
+namespace {
+
+/// The visits and successful combines of each opcode over all the DAGs of the
+/// process, printed at exit with -combiner-opcode-stats.
+struct OpcodeCombineStatistics {
+  std::map<unsigned, OpcodeCombineCounts> Opcodes;
+
+  ~OpcodeCombineStatistics() {
+    if (Opcodes.empty())
+      return;
+    std::vector<const OpcodeCombineCounts *> Sorted;
+    for (const auto &Opcode : Opcodes)
+      Sorted.push_back(&Opcode.second);
+    std::stable_sort(Sorted.begin(), Sorted.end(),
+                     [](const OpcodeCombineCounts *A,
+                        const OpcodeCombineCounts *B) {
+                       return A->Hits > B->Hits;
+                     });
+
+    std::unique_ptr<raw_ostream> OS = CreateInfoOutputFile();
+    *OS << "===" << std::string(73, '-') << "===\n"
+        << "                       DAG combines by opcode\n"
+        << "===" << std::string(73, '-') << "===\n\n"
+        << "        Hits       Visits  Opcode\n";
+    for (const OpcodeCombineCounts *C : Sorted)
+      *OS << format("%12" PRIu64 " %12" PRIu64 "  ", C->Hits, C->Visits)
+          << C->Name << '\n';
+    *OS << '\n';
+  }
+};
+
+} // end anonymous namespace
+
+static ManagedStatic<OpcodeCombineStatistics> OpcodeCombineStats;
+static ManagedStatic<sys::SmartMutex<true>> OpcodeCombineStatsLock;
+
+void DAGCombiner::flushOpcodeCombines() {
+  sys::SmartScopedLock<true> Lock(*OpcodeCombineStatsLock);
+  for (const auto &Opcode : OpcodeCombines) {
+    OpcodeCombineCounts &Counts = OpcodeCombineStats->Opcodes[Opcode.first];
+    if (Counts.Name.empty())
+      Counts.Name = Opcode.second.Name;
+    Counts.Visits += Opcode.second.Visits;
+    Counts.Hits += Opcode.second.Hits;
+  }
+  OpcodeCombines.clear();
 }
 
 SDValue DAGCombiner::visit(SDNode *N) {
@@ -732,6 +732,7 @@ static void VerifySDNode(SDNode *N) {
 /// verification and other common operations when a new node is allocated.
 void SelectionDAG::InsertNode(SDNode *N) {
   AllNodes.push_back(N);
+  ++NumNodesCreated;
 #ifndef NDEBUG
   N->PersistentId = NextPersistentId++;
   VerifySDNode(N);
@@ -910,6 +911,11 @@ void SelectionDAG::init(MachineFunction &NewMF,
   TLI = getSubtarget().getTargetLowering();
   TSI = getSubtarget().getSelectionDAGInfo();
   Context = &MF->getFunction()->getContext();
+
+  // Release the operand arrays recycled across the previous function's
+  // blocks.
+  OperandRecycler.clear(OperandAllocator);
+  OperandAllocator.Reset();
 }
 
 SelectionDAG::~SelectionDAG() {
@@ -970,10 +976,21 @@ SDNode *SelectionDAG::FindNodeOrInsertPos(const FoldingSetNodeID &ID,
 }
 
 void SelectionDAG::clear() {
+  // A large block grows the CSE map for all the blocks that follow. When the
+  // map is much larger than the DAG, taking the nodes out one by one is
+  // cheaper than clearing every bucket.
+  if (CSEMap.size() * 32 < CSEMap.capacity()) {
+    for (SDNode &N : allnodes())
+      if (N.getNextInBucket())
+        CSEMap.RemoveNode(&N);
+    assert(CSEMap.empty() && "CSE map holds a node outside the DAG");
+  } else {
+    CSEMap.clear();
+  }
+
+  // The operand arrays of the nodes are recycled for the next block rather
+  // than released.
   allnodes_clear();
-  OperandRecycler.clear(OperandAllocator);
-  OperandAllocator.Reset();
-  CSEMap.clear();
 
   ExtendedValueTypeNodes.clear();
   ExternalSymbols.clear();
@@ -988,6 +1005,7 @@ void SelectionDAG::clear() {
   InsertNode(&EntryNode);
   Root = getEntryNode();
   DbgInfo->clear();
+  NumNodesCreated = 0;
 }
 
 SDValue SelectionDAG::getFPExtendOrRound(SDValue Op, const SDLoc &DL, EVT VT) {
@@ -107,6 +107,11 @@ STATISTIC(NumFastIselSuccess, "Number of instructions fast isel selected");
 STATISTIC(NumFastIselBlocks, "Number of blocks selected entirely by fast isel");
 STATISTIC(NumDAGBlocks, "Number of blocks selected using DAG");
 STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
+STATISTIC(NumDAGNodesBuilt, "Number of DAG nodes built from IR");
+STATISTIC(NumDAGNodesCombined, "Number of DAG nodes created by DAG combining");
+STATISTIC(NumDAGNodesLegalized, "Number of DAG nodes created by legalization");
+STATISTIC(NumDAGNodesSelected,
+          "Number of DAG nodes created by instruction selection");
 STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
@@ -705,6 +710,22 @@ void SelectionDAGISel::ComputeLiveOutVRegInfo() {
   } while (!Worklist.empty());
 }
 
+namespace {
+
+/// Adds the number of DAG nodes created in its scope to a counter.
+class DAGNodeCounter {
+  const SelectionDAG &DAG;
+  unsigned &Count;
+  unsigned Start;
+
+public:
+  DAGNodeCounter(const SelectionDAG &DAG, unsigned &Count)
+      : DAG(DAG), Count(Count), Start(DAG.getNumNodesCreated()) {}
+  ~DAGNodeCounter() { Count += DAG.getNumNodesCreated() - Start; }
+};
+
+} // end anonymous namespace
+
 void SelectionDAGISel::CodeGenAndEmitDAG() {
   StringRef GroupName = "sdag";
   StringRef GroupDescription = "Instruction Selection and Scheduling";
@@ -734,6 +755,10 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   DEBUG(dbgs() << "Initial selection DAG: BB#" << BlockNumber
         << " '" << BlockName << "'\n"; CurDAG->dump());
 
+  // Count the nodes created by each phase, for -stats and -debug-only=isel.
+  unsigned NodesBuilt = CurDAG->getNumNodesCreated();
+  unsigned NodesCombined = 0, NodesLegalized = 0, NodesSelected = 0;
+
   if (ViewDAGCombine1 && MatchFilterBB)
     CurDAG->viewGraph("dag-combine1 input for " + BlockName);
 
@@ -741,6 +766,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("combine1", "DAG Combining 1", GroupName,
                        GroupDescription, TimePassesIsEnabled);
+    DAGNodeCounter C(*CurDAG, NodesCombined);
     CurDAG->Combine(BeforeLegalizeTypes, AA, OptLevel);
   }
 
@@ -756,6 +782,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("legalize_types", "Type Legalization", GroupName,
                        GroupDescription, TimePassesIsEnabled);
+    DAGNodeCounter C(*CurDAG, NodesLegalized);
     Changed = CurDAG->LegalizeTypes();
   }
 
@@ -773,6 +800,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("combine_lt", "DAG Combining after legalize types",
                          GroupName, GroupDescription, TimePassesIsEnabled);
+      DAGNodeCounter C(*CurDAG, NodesCombined);
       CurDAG->Combine(AfterLegalizeTypes, AA, OptLevel);
     }
 
@@ -783,6 +811,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("legalize_vec", "Vector Legalization", GroupName,
                        GroupDescription, TimePassesIsEnabled);
+    DAGNodeCounter C(*CurDAG, NodesLegalized);
     Changed = CurDAG->LegalizeVectors();
   }
 
@@ -793,6 +822,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("legalize_types2", "Type Legalization 2", GroupName,
                          GroupDescription, TimePassesIsEnabled);
+      DAGNodeCounter C(*CurDAG, NodesLegalized);
       CurDAG->LegalizeTypes();
     }
 
@@ -806,6 +836,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("combine_lv", "DAG Combining after legalize vectors",
                          GroupName, GroupDescription, TimePassesIsEnabled);
+      DAGNodeCounter C(*CurDAG, NodesCombined);
       CurDAG->Combine(AfterLegalizeVectorOps, AA, OptLevel);
     }
 
@@ -819,6 +850,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("legalize", "DAG Legalization", GroupName,
                        GroupDescription, TimePassesIsEnabled);
+    DAGNodeCounter C(*CurDAG, NodesLegalized);
     CurDAG->Legalize();
   }
 
@@ -832,6 +864,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("combine2", "DAG Combining 2", GroupName,
                        GroupDescription, TimePassesIsEnabled);
+    DAGNodeCounter C(*CurDAG, NodesCombined);
     CurDAG->Combine(AfterLegalizeDAG, AA, OptLevel);
   }
 
@@ -849,6 +882,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("isel", "Instruction Selection", GroupName,
                        GroupDescription, TimePassesIsEnabled);
+    DAGNodeCounter C(*CurDAG, NodesSelected);
     DoInstructionSelection();
   }
 
@@ -893,6 +927,15 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     delete Scheduler;
   }
 
+  DEBUG(dbgs() << "DAG nodes for BB#" << BlockNumber << ": " << NodesBuilt
+               << " built, " << NodesCombined << " combined, "
+               << NodesLegalized << " legalized, " << NodesSelected
+               << " selected\n");
+  NumDAGNodesBuilt += NodesBuilt;
+  NumDAGNodesCombined += NodesCombined;
+  NumDAGNodesLegalized += NodesLegalized;
+  NumDAGNodesSelected += NodesSelected;
+
   // Free the SelectionDAG state, now that we're finished with it.
   CurDAG->clear();
 }
@@ -66,11 +66,14 @@
 #include "llvm/IR/Value.h"
 #include "llvm/Support/AtomicOrdering.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -86,6 +89,11 @@
 
 using namespace llvm;
 
+static cl::opt<unsigned> PrintModuleThreads(
+    "print-module-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to print function bodies when printing "
+             "a whole module (0 = number of hardware threads)"));
+
 // Make virtual table appear in this compilation unit.
 AssemblyAnnotationWriter::~AssemblyAnnotationWriter() = default;
 
@@ -466,27 +474,57 @@ namespace {
 
 class TypePrinting {
 public:
-  /// NamedTypes - The named types that are used by the current module.
-  TypeFinder NamedTypes;
-
-  /// NumberedTypes - The numbered types, along with their value.
-  DenseMap<StructType*, unsigned> NumberedTypes;
-
   TypePrinting() = default;
   TypePrinting(const TypePrinting &) = delete;
   TypePrinting &operator=(const TypePrinting &) = delete;
 
-  void incorporateTypes(const Module &M);
+  /// Remember \p M as the module whose types should be numbered.  The module
+  /// is only walked once a numbered or named type list is actually needed,
+  /// so printing a single function or instruction does not pay for a
+  /// TypeFinder walk over the whole module.
+  void incorporateTypes(const Module &M) { DeferredM = &M; }
+
+  /// The named types that are used by the current module.
+  TypeFinder &getNamedTypes();
+
+  /// The numbered types, along with their value.
+  DenseMap<StructType*, unsigned> &getNumberedTypes();
 
   void print(Type *Ty, raw_ostream &OS);
 
   void printStructBody(StructType *Ty, raw_ostream &OS);
+
+private:
+  void incorporateDeferredTypes();
+
+  /// A module to process lazily when needed. Set to nullptr as soon as used.
+  const Module *DeferredM = nullptr;
+
+  /// NamedTypes - The named types that are used by the current module.
+  TypeFinder NamedTypes;
+
+  /// NumberedTypes - The numbered types, along with their value.
+  DenseMap<StructType*, unsigned> NumberedTypes;
 };
 
 } // end anonymous namespace
 
-void TypePrinting::incorporateTypes(const Module &M) {
-  NamedTypes.run(M, false);
+TypeFinder &TypePrinting::getNamedTypes() {
+  incorporateDeferredTypes();
+  return NamedTypes;
+}
+
+DenseMap<StructType*, unsigned> &TypePrinting::getNumberedTypes() {
+  incorporateDeferredTypes();
+  return NumberedTypes;
+}
+
+void TypePrinting::incorporateDeferredTypes() {
+  if (!DeferredM)
+    return;
+
+  NamedTypes.run(*DeferredM, false);
+  DeferredM = nullptr;
 
   // The list of struct types we got back includes all the struct types, split
   // the unnamed ones out to a numbering and remove the anonymous structs.
@@ -509,7 +547,6 @@ void TypePrinting::incorporateTypes(const Module &M) {
   NamedTypes.erase(NextToUse, NamedTypes.end());
 }
 
-
 /// CalcTypeName - Write the specified type to the specified raw_ostream, making
 /// use of type names or up references to shorten the type name where possible.
 void TypePrinting::print(Type *Ty, raw_ostream &OS) {
@@ -555,8 +592,9 @@ void TypePrinting::print(Type *Ty, raw_ostream &OS) {
     if (!STy->getName().empty())
       return PrintLLVMName(OS, STy->getName(), LocalPrefix);
 
-    DenseMap<StructType*, unsigned>::iterator I = NumberedTypes.find(STy);
-    if (I != NumberedTypes.end())
+    auto &Numbers = getNumberedTypes();
+    DenseMap<StructType*, unsigned>::iterator I = Numbers.find(STy);
+    if (I != Numbers.end())
       OS << '%' << I->second;
     else  // Not enumerated, print the hex address.
       OS << "%\"type " << STy << '\"';
@@ -711,6 +749,14 @@ public:
   /// This function does the actual initialization.
   inline void initialize();
 
+  /// Number the metadata and call-site attribute groups of every function in
+  /// \p M in the order incorporating the functions one after another would.
+  /// Afterwards, incorporating a function only creates function-local slots.
+  void processAllFunctions(const Module &M);
+
+  /// Take over the module-level slots numbered so far by \p Other.
+  void copyModuleSlots(const SlotTracker &Other);
+
   // Implementation Details
 private:
   /// CreateModuleSlot - Insert the specified GlobalValue* into the slot table.
@@ -929,6 +975,33 @@ void SlotTracker::processFunction() {
   ST_DEBUG("end processFunction!\n");
 }
 
+void SlotTracker::processAllFunctions(const Module &M) {
+  initialize();
+
+  for (const Function &F : M) {
+    if (!ShouldInitializeAllMetadata)
+      processFunctionMetadata(F);
+
+    for (auto &BB : F)
+      for (auto &I : BB)
+        if (auto CS = ImmutableCallSite(&I)) {
+          AttributeSet Attrs = CS.getAttributes().getFnAttributes();
+          if (Attrs.hasAttributes())
+            CreateAttributeSetSlot(Attrs);
+        }
+  }
+}
+
+void SlotTracker::copyModuleSlots(const SlotTracker &Other) {
+  assert(!Other.TheModule && "Module slots have not been created yet");
+  mMap = Other.mMap;
+  mNext = Other.mNext;
+  mdnMap = Other.mdnMap;
+  mdnNext = Other.mdnNext;
+  asMap = Other.asMap;
+  asNext = Other.asNext;
+}
+
 void SlotTracker::processGlobalObjectMetadata(const GlobalObject &GO) {
   SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
   GO.getAllMetadata(MDs);
@@ -1139,6 +1212,97 @@ static void WriteOptimizationInfo(raw_ostream &Out, const User *U) {
   }
 }
 
+static void WriteAPFloatInternal(raw_ostream &Out, const APFloat &APF) {
+  if (&APF.getSemantics() == &APFloat::IEEEsingle() ||
+      &APF.getSemantics() == &APFloat::IEEEdouble()) {
+    // We would like to output the FP constant value in exponential notation,
+    // but we cannot do this if doing so will lose precision.  Check here to
+    // make sure that we only output it in exponential format if we can parse
+    // the value back and get the same value.
+    //
+    bool ignored;
+    bool isDouble = &APF.getSemantics() == &APFloat::IEEEdouble();
+    bool isInf = APF.isInfinity();
+    bool isNaN = APF.isNaN();
+    if (!isInf && !isNaN) {
+      double Val = isDouble ? APF.convertToDouble() : APF.convertToFloat();
+      SmallString<128> StrVal;
+      APF.toString(StrVal, 6, 0, false);
+      // Check to make sure that the stringized number is not some string like
+      // "Inf" or NaN, that atof will accept, but the lexer will not.  Check
+      // that the string matches the "[-+]?[0-9]" regex.
+      //
+      assert(((StrVal[0] >= '0' && StrVal[0] <= '9') ||
+              ((StrVal[0] == '-' || StrVal[0] == '+') &&
+               (StrVal[1] >= '0' && StrVal[1] <= '9'))) &&
+             "[-+]?[0-9] regex does not match!");
+      // Reparse stringized version!
+      if (APFloat(APFloat::IEEEdouble(), StrVal).convertToDouble() == Val) {
+        Out << StrVal;
+        return;
+      }
+    }
+    // Otherwise we could not reparse it to exactly the same value, so we must
+    // output the string in hexadecimal format!  Note that loading and storing
+    // floating point types changes the bits of NaNs on some hosts, notably
+    // x86, so we must not use these types.
+    static_assert(sizeof(double) == sizeof(uint64_t),
+                  "assuming that double is 64 bits!");
+    APFloat apf = APF;
+    // Floats are represented in ASCII IR as double, convert.
+    if (!isDouble)
+      apf.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven,
+                  &ignored);
+    Out << format_hex(apf.bitcastToAPInt().getZExtValue(), 0, /*Upper=*/true);
+    return;
+  }
+
+  // Either half, or some form of long double.
+  // These appear as a magic letter identifying the type, then a
+  // fixed number of hex digits.
+  Out << "0x";
+  APInt API = APF.bitcastToAPInt();
+  if (&APF.getSemantics() == &APFloat::x87DoubleExtended()) {
+    Out << 'K';
+    Out << format_hex_no_prefix(API.getHiBits(16).getZExtValue(), 4,
+                                /*Upper=*/true);
+    Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+    return;
+  } else if (&APF.getSemantics() == &APFloat::IEEEquad()) {
+    Out << 'L';
+    Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+    Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+  } else if (&APF.getSemantics() == &APFloat::PPCDoubleDouble()) {
+    Out << 'M';
+    Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+    Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
+                                /*Upper=*/true);
+  } else if (&APF.getSemantics() == &APFloat::IEEEhalf()) {
+    Out << 'H';
+    Out << format_hex_no_prefix(API.getZExtValue(), 4,
+                                /*Upper=*/true);
+  } else
+    llvm_unreachable("Unsupported floating point type");
+}
+
+/// Print element \p Idx of \p CDS without materializing it as a Constant.
+/// getElementAsConstant would unique a new constant in the LLVMContext, which
+/// is not safe while several functions are being printed concurrently.
+static void WriteConstantDataElement(raw_ostream &Out,
+                                     const ConstantDataSequential *CDS,
+                                     unsigned Idx) {
+  Type *ETy = CDS->getElementType();
+  if (ETy->isIntegerTy()) {
+    Out << APInt(ETy->getIntegerBitWidth(), CDS->getElementAsInteger(Idx));
+    return;
+  }
+  WriteAPFloatInternal(Out, CDS->getElementAsAPFloat(Idx));
+}
+
 static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
                                   TypePrinting &TypePrinter,
                                   SlotTracker *Machine,
@@ -1153,81 +1317,7 @@ static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
   }
 
   if (const ConstantFP *CFP = dyn_cast<ConstantFP>(CV)) {
-    const APFloat &APF = CFP->getValueAPF();
-    if (&APF.getSemantics() == &APFloat::IEEEsingle() ||
-        &APF.getSemantics() == &APFloat::IEEEdouble()) {
-      // We would like to output the FP constant value in exponential notation,
-      // but we cannot do this if doing so will lose precision.  Check here to
-      // make sure that we only output it in exponential format if we can parse
-      // the value back and get the same value.
-      //
-      bool ignored;
-      bool isDouble = &APF.getSemantics() == &APFloat::IEEEdouble();
-      bool isInf = APF.isInfinity();
-      bool isNaN = APF.isNaN();
-      if (!isInf && !isNaN) {
-        double Val = isDouble ? APF.convertToDouble() : APF.convertToFloat();
-        SmallString<128> StrVal;
-        APF.toString(StrVal, 6, 0, false);
-        // Check to make sure that the stringized number is not some string like
-        // "Inf" or NaN, that atof will accept, but the lexer will not.  Check
-        // that the string matches the "[-+]?[0-9]" regex.
-        //
-        assert(((StrVal[0] >= '0' && StrVal[0] <= '9') ||
-                ((StrVal[0] == '-' || StrVal[0] == '+') &&
-                 (StrVal[1] >= '0' && StrVal[1] <= '9'))) &&
-               "[-+]?[0-9] regex does not match!");
-        // Reparse stringized version!
-        if (APFloat(APFloat::IEEEdouble(), StrVal).convertToDouble() == Val) {
-          Out << StrVal;
-          return;
-        }
-      }
-      // Otherwise we could not reparse it to exactly the same value, so we must
-      // output the string in hexadecimal format!  Note that loading and storing
-      // floating point types changes the bits of NaNs on some hosts, notably
-      // x86, so we must not use these types.
-      static_assert(sizeof(double) == sizeof(uint64_t),
-                    "assuming that double is 64 bits!");
-      APFloat apf = APF;
-      // Floats are represented in ASCII IR as double, convert.
-      if (!isDouble)
-        apf.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven,
-                          &ignored);
-      Out << format_hex(apf.bitcastToAPInt().getZExtValue(), 0, /*Upper=*/true);
-      return;
-    }
-
-    // Either half, or some form of long double.
-    // These appear as a magic letter identifying the type, then a
-    // fixed number of hex digits.
-    Out << "0x";
-    APInt API = APF.bitcastToAPInt();
-    if (&APF.getSemantics() == &APFloat::x87DoubleExtended()) {
-      Out << 'K';
-      Out << format_hex_no_prefix(API.getHiBits(16).getZExtValue(), 4,
-                                  /*Upper=*/true);
-      Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-      return;
-    } else if (&APF.getSemantics() == &APFloat::IEEEquad()) {
-      Out << 'L';
-      Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-      Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-    } else if (&APF.getSemantics() == &APFloat::PPCDoubleDouble()) {
-      Out << 'M';
-      Out << format_hex_no_prefix(API.getLoBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-      Out << format_hex_no_prefix(API.getHiBits(64).getZExtValue(), 16,
-                                  /*Upper=*/true);
-    } else if (&APF.getSemantics() == &APFloat::IEEEhalf()) {
-      Out << 'H';
-      Out << format_hex_no_prefix(API.getZExtValue(), 4,
-                                  /*Upper=*/true);
-    } else
-      llvm_unreachable("Unsupported floating point type");
+    WriteAPFloatInternal(Out, CFP->getValueAPF());
     return;
   }
 
@@ -1280,15 +1370,12 @@ static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
     Out << '[';
     TypePrinter.print(ETy, Out);
     Out << ' ';
-    WriteAsOperandInternal(Out, CA->getElementAsConstant(0),
-                           &TypePrinter, Machine,
-                           Context);
+    WriteConstantDataElement(Out, CA, 0);
     for (unsigned i = 1, e = CA->getNumElements(); i != e; ++i) {
       Out << ", ";
       TypePrinter.print(ETy, Out);
       Out << ' ';
-      WriteAsOperandInternal(Out, CA->getElementAsConstant(i), &TypePrinter,
-                             Machine, Context);
+      WriteConstantDataElement(Out, CA, i);
     }
     Out << ']';
     return;
@@ -1326,17 +1413,23 @@ static void WriteConstantInternal(raw_ostream &Out, const Constant *CV,
 
   if (isa<ConstantVector>(CV) || isa<ConstantDataVector>(CV)) {
     Type *ETy = CV->getType()->getVectorElementType();
+    auto *CDV = dyn_cast<ConstantDataVector>(CV);
+    auto WriteElement = [&](unsigned i) {
+      if (CDV)
+        WriteConstantDataElement(Out, CDV, i);
+      else
+        WriteAsOperandInternal(Out, CV->getAggregateElement(i), &TypePrinter,
+                               Machine, Context);
+    };
     Out << '<';
     TypePrinter.print(ETy, Out);
     Out << ' ';
-    WriteAsOperandInternal(Out, CV->getAggregateElement(0U), &TypePrinter,
-                           Machine, Context);
+    WriteElement(0);
     for (unsigned i = 1, e = CV->getType()->getVectorNumElements(); i != e;++i){
       Out << ", ";
       TypePrinter.print(ETy, Out);
       Out << ' ';
-      WriteAsOperandInternal(Out, CV->getAggregateElement(i), &TypePrinter,
-                             Machine, Context);
+      WriteElement(i);
     }
     Out << '>';
     return;
@@ -2145,6 +2238,10 @@ public:
 
   void printModule(const Module *M);
 
+  /// Print the functions of \p M on \p Threads threads, each into its own
+  /// buffer, and emit the buffers in module order.
+  void printFunctionsInParallel(const Module *M, unsigned Threads);
+
   void writeOperand(const Value *Op, bool PrintType);
   void writeParamOperand(const Value *Operand, AttributeSet Attrs);
   void writeOperandBundles(ImmutableCallSite CS);
@@ -2383,9 +2480,16 @@ void AssemblyWriter::printModule(const Module *M) {
   // Output global use-lists.
   printUseLists(nullptr);
 
-  // Output all of the functions.
-  for (const Function &F : *M)
-    printFunction(&F);
+  // Output all of the functions.  Annotation writers and use-list orders are
+  // stateful across functions, so those are always printed serially.
+  unsigned Threads = PrintModuleThreads ? PrintModuleThreads
+                                        : heavyweight_hardware_concurrency();
+  if (Threads > 1 && M->size() > 1 && !AnnotationWriter &&
+      !ShouldPreserveUseListOrder)
+    printFunctionsInParallel(M, Threads);
+  else
+    for (const Function &F : *M)
+      printFunction(&F);
   assert(UseListOrders.empty() && "All use-lists should have been consumed");
 
   // Output all attribute groups.
@@ -2407,6 +2511,42 @@ void AssemblyWriter::printModule(const Module *M) {
   }
 }
 
+void AssemblyWriter::printFunctionsInParallel(const Module *M,
+                                              unsigned Threads) {
+  // Number all metadata and attribute groups up front, in the order the
+  // serial writer would have, so that the workers only create function-local
+  // slots and the output does not depend on how the work was scheduled.
+  Machine.processAllFunctions(*M);
+
+  std::vector<const Function *> Functions;
+  for (const Function &F : *M)
+    Functions.push_back(&F);
+
+  // Every chunk gets its own copy of the module-level slots, so use a few
+  // more chunks than threads for load balancing but not one per function.
+  size_t NumChunks = std::min<size_t>(Functions.size(), 4 * Threads);
+  std::vector<std::string> Buffers(NumChunks);
+  ThreadPool Pool(Threads);
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk) {
+    size_t Begin = Functions.size() * Chunk / NumChunks;
+    size_t End = Functions.size() * (Chunk + 1) / NumChunks;
+    Pool.async([&, Chunk, Begin, End] {
+      SlotTracker ChunkMachine(static_cast<const Module *>(nullptr),
+                               /* ShouldInitializeAllMetadata */ true);
+      ChunkMachine.copyModuleSlots(Machine);
+      raw_string_ostream ROS(Buffers[Chunk]);
+      formatted_raw_ostream OS(ROS);
+      AssemblyWriter W(OS, ChunkMachine, M, nullptr, IsForDebug);
+      for (size_t I = Begin; I != End; ++I)
+        W.printFunction(Functions[I]);
+    });
+  }
+  Pool.wait();
+
+  for (const std::string &Buffer : Buffers)
+    Out << Buffer;
+}
+
 static void printMetadataIdentifier(StringRef Name,
                                     formatted_raw_ostream &Out) {
   if (Name.empty()) {
@@ -2642,18 +2782,18 @@ void AssemblyWriter::printComdat(const Comdat *C) {
 }
 
 void AssemblyWriter::printTypeIdentities() {
-  if (TypePrinter.NumberedTypes.empty() &&
-      TypePrinter.NamedTypes.empty())
+  DenseMap<StructType*, unsigned> &Numbers = TypePrinter.getNumberedTypes();
+  TypeFinder &NamedTypes = TypePrinter.getNamedTypes();
+  if (Numbers.empty() && NamedTypes.empty())
     return;
 
   Out << '\n';
 
   // We know all the numbers that each type is used and we know that it is a
   // dense assignment.  Convert the map to an index table.
-  std::vector<StructType*> NumberedTypes(TypePrinter.NumberedTypes.size());
-  for (DenseMap<StructType*, unsigned>::iterator I =
-       TypePrinter.NumberedTypes.begin(), E = TypePrinter.NumberedTypes.end();
-       I != E; ++I) {
+  std::vector<StructType*> NumberedTypes(Numbers.size());
+  for (DenseMap<StructType*, unsigned>::iterator I = Numbers.begin(),
+       E = Numbers.end(); I != E; ++I) {
     assert(I->second < NumberedTypes.size() && "Didn't get a dense numbering?");
     NumberedTypes[I->second] = I->first;
   }
@@ -2668,13 +2808,13 @@ void AssemblyWriter::printTypeIdentities() {
     Out << '\n';
   }
 
-  for (unsigned i = 0, e = TypePrinter.NamedTypes.size(); i != e; ++i) {
-    PrintLLVMName(Out, TypePrinter.NamedTypes[i]->getName(), LocalPrefix);
+  for (unsigned i = 0, e = NamedTypes.size(); i != e; ++i) {
+    PrintLLVMName(Out, NamedTypes[i]->getName(), LocalPrefix);
     Out << " = type ";
 
     // Make sure we print out at least one level of the type structure, so
     // that we do not get %FILE = type %FILE
-    TypePrinter.printStructBody(TypePrinter.NamedTypes[i], Out);
+    TypePrinter.printStructBody(NamedTypes[i], Out);
     Out << '\n';
   }
 }
@@ -3382,24 +3522,49 @@ void AssemblyWriter::printUseLists(const Function *F) {
 //                       External Interface declarations
 //===----------------------------------------------------------------------===//
 
+/// Call \p Print with a formatted stream writing to \p ROS.
+///
+/// formatted_raw_ostream takes over the buffering of the stream it wraps, so
+/// printing straight to an unbuffered stream such as errs() or dbgs() would
+/// issue a write for every token. Print such output into memory and write it
+/// out at once instead; buffering \p ROS itself would leave it buffered after
+/// the formatted stream hands its settings back.
+template <typename PrintFnTy>
+static void printBuffered(raw_ostream &ROS, PrintFnTy Print) {
+  if (ROS.GetBufferSize()) {
+    formatted_raw_ostream OS(ROS);
+    Print(OS);
+    return;
+  }
+  SmallString<256> Buffer;
+  {
+    raw_svector_ostream BOS(Buffer);
+    formatted_raw_ostream OS(BOS);
+    Print(OS);
+  }
+  ROS << Buffer;
+}
+
 void Function::print(raw_ostream &ROS, AssemblyAnnotationWriter *AAW,
                      bool ShouldPreserveUseListOrder,
                      bool IsForDebug) const {
   SlotTracker SlotTable(this->getParent());
-  formatted_raw_ostream OS(ROS);
-  AssemblyWriter W(OS, SlotTable, this->getParent(), AAW,
-                   IsForDebug,
-                   ShouldPreserveUseListOrder);
-  W.printFunction(this);
+  printBuffered(ROS, [&](formatted_raw_ostream &OS) {
+    AssemblyWriter W(OS, SlotTable, this->getParent(), AAW,
+                     IsForDebug,
+                     ShouldPreserveUseListOrder);
+    W.printFunction(this);
+  });
 }
 
 void Module::print(raw_ostream &ROS, AssemblyAnnotationWriter *AAW,
                    bool ShouldPreserveUseListOrder, bool IsForDebug) const {
   SlotTracker SlotTable(this);
-  formatted_raw_ostream OS(ROS);
-  AssemblyWriter W(OS, SlotTable, this, AAW, IsForDebug,
-                   ShouldPreserveUseListOrder);
-  W.printModule(this);
+  printBuffered(ROS, [&](formatted_raw_ostream &OS) {
+    AssemblyWriter W(OS, SlotTable, this, AAW, IsForDebug,
+                     ShouldPreserveUseListOrder);
+    W.printModule(this);
+  });
 }
 
 void NamedMDNode::print(raw_ostream &ROS, bool IsForDebug) const {
@@ -3489,43 +3654,47 @@ void Value::print(raw_ostream &ROS, bool IsForDebug) const {
 
 void Value::print(raw_ostream &ROS, ModuleSlotTracker &MST,
                   bool IsForDebug) const {
-  formatted_raw_ostream OS(ROS);
-  SlotTracker EmptySlotTable(static_cast<const Module *>(nullptr));
-  SlotTracker &SlotTable =
-      MST.getMachine() ? *MST.getMachine() : EmptySlotTable;
-  auto incorporateFunction = [&](const Function *F) {
-    if (F)
-      MST.incorporateFunction(*F);
-  };
-
-  if (const Instruction *I = dyn_cast<Instruction>(this)) {
-    incorporateFunction(I->getParent() ? I->getParent()->getParent() : nullptr);
-    AssemblyWriter W(OS, SlotTable, getModuleFromVal(I), nullptr, IsForDebug);
-    W.printInstruction(*I);
-  } else if (const BasicBlock *BB = dyn_cast<BasicBlock>(this)) {
-    incorporateFunction(BB->getParent());
-    AssemblyWriter W(OS, SlotTable, getModuleFromVal(BB), nullptr, IsForDebug);
-    W.printBasicBlock(BB);
-  } else if (const GlobalValue *GV = dyn_cast<GlobalValue>(this)) {
-    AssemblyWriter W(OS, SlotTable, GV->getParent(), nullptr, IsForDebug);
-    if (const GlobalVariable *V = dyn_cast<GlobalVariable>(GV))
-      W.printGlobal(V);
-    else if (const Function *F = dyn_cast<Function>(GV))
-      W.printFunction(F);
-    else
-      W.printIndirectSymbol(cast<GlobalIndirectSymbol>(GV));
-  } else if (const MetadataAsValue *V = dyn_cast<MetadataAsValue>(this)) {
-    V->getMetadata()->print(ROS, MST, getModuleFromVal(V));
-  } else if (const Constant *C = dyn_cast<Constant>(this)) {
-    TypePrinting TypePrinter;
-    TypePrinter.print(C->getType(), OS);
-    OS << ' ';
-    WriteConstantInternal(OS, C, TypePrinter, MST.getMachine(), nullptr);
-  } else if (isa<InlineAsm>(this) || isa<Argument>(this)) {
-    this->printAsOperand(OS, /* PrintType */ true, MST);
-  } else {
-    llvm_unreachable("Unknown value to print out!");
-  }
+  printBuffered(ROS, [&](formatted_raw_ostream &OS) {
+    SlotTracker EmptySlotTable(static_cast<const Module *>(nullptr));
+    SlotTracker &SlotTable =
+        MST.getMachine() ? *MST.getMachine() : EmptySlotTable;
+    auto incorporateFunction = [&](const Function *F) {
+      if (F)
+        MST.incorporateFunction(*F);
+    };
+
+    if (const Instruction *I = dyn_cast<Instruction>(this)) {
+      incorporateFunction(I->getParent() ? I->getParent()->getParent()
+                                         : nullptr);
+      AssemblyWriter W(OS, SlotTable, getModuleFromVal(I), nullptr,
+                       IsForDebug);
+      W.printInstruction(*I);
+    } else if (const BasicBlock *BB = dyn_cast<BasicBlock>(this)) {
+      incorporateFunction(BB->getParent());
+      AssemblyWriter W(OS, SlotTable, getModuleFromVal(BB), nullptr,
+                       IsForDebug);
+      W.printBasicBlock(BB);
+    } else if (const GlobalValue *GV = dyn_cast<GlobalValue>(this)) {
+      AssemblyWriter W(OS, SlotTable, GV->getParent(), nullptr, IsForDebug);
+      if (const GlobalVariable *V = dyn_cast<GlobalVariable>(GV))
+        W.printGlobal(V);
+      else if (const Function *F = dyn_cast<Function>(GV))
+        W.printFunction(F);
+      else
+        W.printIndirectSymbol(cast<GlobalIndirectSymbol>(GV));
+    } else if (const MetadataAsValue *V = dyn_cast<MetadataAsValue>(this)) {
+      V->getMetadata()->print(OS, MST, getModuleFromVal(V));
+    } else if (const Constant *C = dyn_cast<Constant>(this)) {
+      TypePrinting TypePrinter;
+      TypePrinter.print(C->getType(), OS);
+      OS << ' ';
+      WriteConstantInternal(OS, C, TypePrinter, MST.getMachine(), nullptr);
+    } else if (isa<InlineAsm>(this) || isa<Argument>(this)) {
+      this->printAsOperand(OS, /* PrintType */ true, MST);
+    } else {
+      llvm_unreachable("Unknown value to print out!");
+    }
+  });
 }
 
 /// Print without a type, skipping the TypePrinting object.
@@ -105,6 +105,8 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -117,6 +119,16 @@ using namespace llvm;
 
 static cl::opt<bool> VerifyDebugInfo("verify-debug-info", cl::init(true));
 
+static cl::opt<unsigned> VerifyThreads(
+    "verify-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to verify function bodies in "
+             "verifyModule (0 = number of hardware threads)"));
+
+static cl::opt<bool> VerifyChangedFunctionsOnly(
+    "verify-changed-functions-only", cl::Hidden, cl::init(false),
+    cl::desc("Let VerifierPass re-verify only the function bodies whose "
+             "cached verification result was invalidated since the last run"));
+
 namespace llvm {
 
 struct VerifierSupport {
@@ -393,6 +405,80 @@ public:
     return !Broken;
   }
 
+  /// Fold the cross-function state that \p Other collected while verifying
+  /// \p Fns into this verifier, so that the module-level checks in \c verify()
+  /// see every function.  Checks that span both verifiers are diagnosed here,
+  /// in the order of \p Fns.
+  ///
+  /// \returns false if such a check failed.
+  bool mergeFunctionState(const Verifier &Other,
+                          ArrayRef<const Function *> Fns) {
+    Broken = false;
+    BrokenDebugInfo |= Other.BrokenDebugInfo;
+
+    SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+    for (const Function *F : Fns) {
+      // A broken function may have several !dbg attachments, so look at the
+      // first rather than asserting in getSubprogram().
+      MDs.clear();
+      F->getAllMetadata(MDs);
+      auto DbgI = find_if(MDs, [](const std::pair<unsigned, MDNode *> &MD) {
+        return MD.first == LLVMContext::MD_dbg;
+      });
+      auto *SP =
+          DbgI == MDs.end() ? nullptr : dyn_cast<DISubprogram>(DbgI->second);
+      if (!SP || Other.DISubprogramAttachments.lookup(SP) != F)
+        continue;
+      const Function *&AttachedTo = DISubprogramAttachments[SP];
+      if (AttachedTo && AttachedTo != F) {
+        DebugInfoCheckFailed("DISubprogram attached to more than one function",
+                             SP, F);
+        continue;
+      }
+      AttachedTo = F;
+    }
+
+    for (const auto &Counts : Other.FrameEscapeInfo) {
+      auto &Entry = FrameEscapeInfo[Counts.first];
+      Entry.first = std::max(Entry.first, Counts.second.first);
+      Entry.second = std::max(Entry.second, Counts.second.second);
+    }
+
+    MDNodes.insert(Other.MDNodes.begin(), Other.MDNodes.end());
+    CUVisited.insert(Other.CUVisited.begin(), Other.CUVisited.end());
+    return !Broken;
+  }
+
+  /// Record what the checks across functions need to know about \p F, whose
+  /// body was verified before and has not changed since, without visiting the
+  /// body again: its subprogram, which no other function may have, and the
+  /// compile unit of that subprogram.
+  ///
+  /// \returns false if \p F shares its subprogram with another function.
+  bool verifyUnchangedFunction(const Function &F) {
+    assert(F.getParent() == &M &&
+           "An instance of this class only works with a specific module!");
+    Broken = false;
+    SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+    F.getAllMetadata(MDs);
+    for (const auto &MD : MDs) {
+      auto *SP = MD.first == LLVMContext::MD_dbg
+                     ? dyn_cast<DISubprogram>(MD.second)
+                     : nullptr;
+      if (!SP)
+        continue;
+      if (Metadata *Unit = SP->getRawUnit())
+        CUVisited.insert(Unit);
+      const Function *&AttachedTo = DISubprogramAttachments[SP];
+      if (AttachedTo && AttachedTo != &F)
+        DebugInfoCheckFailed("DISubprogram attached to more than one function",
+                             SP, &F);
+      else
+        AttachedTo = &F;
+    }
+    return !Broken;
+  }
+
 private:
   // Verification methods...
   void visitGlobalValue(const GlobalValue &GV);
@@ -4642,14 +4728,104 @@ bool llvm::verifyFunction(const Function &f, raw_ostream *OS) {
   return !V.verify(F);
 }
 
+/// Some checks create types or constants in the LLVMContext on first use,
+/// which is not safe to do from several threads.  Create them up front.
+static void prepareConcurrentVerification(const Module &M) {
+  LLVMContext &Context = M.getContext();
+  ConstantTokenNone::get(Context);
+
+  // The message for an attribute on a value of the wrong type prints the
+  // attributes incompatible with the type, which only depend on whether it is
+  // an integer, a pointer or neither.
+  Type *Tys[] = {Type::getInt8Ty(Context), Type::getInt8PtrTy(Context),
+                 Type::getVoidTy(Context)};
+  for (Type *Ty : Tys)
+    AttributeSet::get(Context, AttributeFuncs::typeIncompatible(Ty));
+
+  for (const Function &F : M) {
+    Intrinsic::ID ID = F.getIntrinsicID();
+    if (!ID)
+      continue;
+    SmallVector<Intrinsic::IITDescriptor, 8> Table;
+    Intrinsic::getIntrinsicInfoTableEntries(ID, Table);
+    ArrayRef<Intrinsic::IITDescriptor> TableRef = Table;
+    SmallVector<Type *, 4> ArgTys;
+    FunctionType *FTy = F.getFunctionType();
+    if (Intrinsic::matchIntrinsicType(FTy->getReturnType(), TableRef, ArgTys))
+      continue;
+    for (Type *ParamTy : FTy->params())
+      if (Intrinsic::matchIntrinsicType(ParamTy, TableRef, ArgTys))
+        break;
+  }
+}
+
+/// Verify the functions of \p M on \p Threads threads and fold the results
+/// into \p V.  Each chunk of functions is checked by its own Verifier, and
+/// the diagnostics are written to \p OS in module order once all chunks are
+/// done, so the output does not depend on scheduling.
+///
+/// \returns true if any function is broken.
+static bool verifyFunctionsInParallel(Verifier &V, const Module &M,
+                                      raw_ostream *OS,
+                                      bool TreatBrokenDebugInfoAsError,
+                                      unsigned Threads) {
+  prepareConcurrentVerification(M);
+
+  std::vector<const Function *> Functions;
+  for (const Function &F : M)
+    Functions.push_back(&F);
+
+  // Use a few more chunks than threads for load balancing.
+  size_t NumChunks = std::min<size_t>(Functions.size(), 4 * Threads);
+  std::vector<std::string> Diags(NumChunks);
+  std::vector<std::unique_ptr<raw_string_ostream>> DiagStreams;
+  std::vector<std::unique_ptr<Verifier>> ChunkVerifiers;
+  std::vector<char> ChunkBroken(NumChunks, false);
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk) {
+    DiagStreams.push_back(llvm::make_unique<raw_string_ostream>(Diags[Chunk]));
+    ChunkVerifiers.push_back(llvm::make_unique<Verifier>(
+        OS ? DiagStreams.back().get() : nullptr, TreatBrokenDebugInfoAsError,
+        M));
+  }
+
+  auto ChunkFunctions = [&](size_t Chunk) {
+    size_t Begin = Functions.size() * Chunk / NumChunks;
+    size_t End = Functions.size() * (Chunk + 1) / NumChunks;
+    return makeArrayRef(Functions).slice(Begin, End - Begin);
+  };
+
+  ThreadPool Pool(Threads);
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk)
+    Pool.async([&, Chunk] {
+      for (const Function *F : ChunkFunctions(Chunk))
+        ChunkBroken[Chunk] |= !ChunkVerifiers[Chunk]->verify(*F);
+    });
+  Pool.wait();
+
+  bool Broken = false;
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk) {
+    if (OS)
+      *OS << DiagStreams[Chunk]->str();
+    Broken |= ChunkBroken[Chunk];
+    Broken |= !V.mergeFunctionState(*ChunkVerifiers[Chunk],
+                                    ChunkFunctions(Chunk));
+  }
+  return Broken;
+}
+
 bool llvm::verifyModule(const Module &M, raw_ostream *OS,
                         bool *BrokenDebugInfo) {
   // Don't use a raw_null_ostream.  Printing IR is expensive.
   Verifier V(OS, /*ShouldTreatBrokenDebugInfoAsError=*/!BrokenDebugInfo, M);
 
+  unsigned Threads =
+      VerifyThreads ? VerifyThreads : heavyweight_hardware_concurrency();
   bool Broken = false;
-  for (const Function &F : M)
-    Broken |= !V.verify(F);
+  if (Threads > 1 && M.size() > 1)
+    Broken |= verifyFunctionsInParallel(V, M, OS, !BrokenDebugInfo, Threads);
+  else
+    for (const Function &F : M)
+      Broken |= !V.verify(F);
 
   Broken |= !V.verify();
   if (BrokenDebugInfo)
@@ -4996,10 +5172,67 @@ FunctionPass *llvm::createVerifierPass(bool FatalErrors) {
   return new VerifierLegacyPass(FatalErrors);
 }
 
+namespace {
+/// Marks a function whose body passed the verifier. The result stays cached
+/// until a pass changes the function, which lets the module verifier skip the
+/// bodies that did not change since they were last verified.
+struct VerifiedFunctionAnalysis
+    : public AnalysisInfoMixin<VerifiedFunctionAnalysis> {
+  struct Result {};
+  Result run(Function &, FunctionAnalysisManager &) { return Result(); }
+  static AnalysisKey Key;
+};
+} // end anonymous namespace
+
+AnalysisKey VerifiedFunctionAnalysis::Key;
+
+/// Verify \p M like verifyModule, but only visit the bodies of the functions
+/// that changed since \p FAM last saw them verified.  The module-level checks
+/// always run, and the unchanged functions still take part in the checks
+/// across functions through their subprograms.  Functions using
+/// llvm.localescape or llvm.localrecover are always verified again, as the
+/// indices they escape and recover are checked against each other.
+static bool verifyChangedFunctions(Module &M, FunctionAnalysisManager &FAM,
+                                   bool &BrokenDebugInfo) {
+  FAM.registerPass([] { return VerifiedFunctionAnalysis(); });
+
+  SmallPtrSet<const Function *, 4> UsesFrameEscape;
+  for (Intrinsic::ID ID : {Intrinsic::localescape, Intrinsic::localrecover})
+    if (Function *Decl = M.getFunction(Intrinsic::getName(ID)))
+      for (const User *U : Decl->users())
+        if (auto *I = dyn_cast<Instruction>(U))
+          UsesFrameEscape.insert(I->getFunction());
+
+  Verifier V(&dbgs(), /*ShouldTreatBrokenDebugInfoAsError=*/false, M);
+  bool Broken = false;
+  for (Function &F : M) {
+    if (!UsesFrameEscape.count(&F) &&
+        FAM.getCachedResult<VerifiedFunctionAnalysis>(F)) {
+      Broken |= !V.verifyUnchangedFunction(F);
+      continue;
+    }
+    if (!V.verify(F))
+      Broken = true;
+    else if (!V.hasBrokenDebugInfo())
+      FAM.getResult<VerifiedFunctionAnalysis>(F);
+  }
+
+  Broken |= !V.verify();
+  BrokenDebugInfo = V.hasBrokenDebugInfo();
+  return Broken;
+}
+
 AnalysisKey VerifierAnalysis::Key;
 VerifierAnalysis::Result VerifierAnalysis::run(Module &M,
-                                               ModuleAnalysisManager &) {
+                                               ModuleAnalysisManager &AM) {
   Result Res;
+  if (VerifyChangedFunctionsOnly)
+    if (auto *FAMProxy =
+            AM.getCachedResult<FunctionAnalysisManagerModuleProxy>(M)) {
+      Res.IRBroken = verifyChangedFunctions(M, FAMProxy->getManager(),
+                                            Res.DebugInfoBroken);
+      return Res;
+    }
   Res.IRBroken = llvm::verifyModule(M, &dbgs(), &Res.DebugInfoBroken);
   return Res;
 }
@@ -0,0 +1,404 @@
+//===-CacheServer.cpp - Shared ThinLTO cache protocol ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the protocol spoken with a shared ThinLTO cache server,
+// and the client used as the second tier of the local cache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/LTO/CacheServer.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/LTO/Caching.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/SHA1.h"
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#ifdef LLVM_ON_UNIX
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace llvm;
+using namespace llvm::lto;
+using namespace llvm::lto::cacheserver;
+
+static const char Magic[4] = {'L', 'T', 'O', 'C'};
+
+// Objects larger than this are rejected rather than trusted to a corrupted or
+// hostile size field.
+static const uint64_t MaxObjectSize = uint64_t(1) << 32;
+
+// Clients and servers give up on a peer that stalls for longer than this.
+static const unsigned TimeoutSeconds = 30;
+
+static Error makeError(const Twine &Msg) {
+  return make_error<StringError>(Msg, inconvertibleErrorCode());
+}
+
+static Error makeSystemError(const Twine &Msg) {
+  return make_error<StringError>(Msg + ": " + std::strerror(errno),
+                                 inconvertibleErrorCode());
+}
+
+bool cacheserver::isValidKey(StringRef Key) {
+  if (Key.empty() || Key.size() > 256)
+    return false;
+  for (char C : Key)
+    if (!isalnum(static_cast<unsigned char>(C)) && C != '_' && C != '-')
+      return false;
+  return true;
+}
+
+#ifdef LLVM_ON_UNIX
+
+static void setTimeouts(int FD) {
+  struct timeval TV;
+  TV.tv_sec = TimeoutSeconds;
+  TV.tv_usec = 0;
+  ::setsockopt(FD, SOL_SOCKET, SO_RCVTIMEO, &TV, sizeof(TV));
+  ::setsockopt(FD, SOL_SOCKET, SO_SNDTIMEO, &TV, sizeof(TV));
+#ifdef SO_NOSIGPIPE
+  int One = 1;
+  ::setsockopt(FD, SOL_SOCKET, SO_NOSIGPIPE, &One, sizeof(One));
+#endif
+}
+
+/// Call Fn with each socket address that Address resolves to until it returns
+/// a valid descriptor.
+static Expected<int>
+forEachSocketAddress(StringRef Address,
+                     function_ref<int(int, const sockaddr *, socklen_t)> Fn) {
+  if (Address.startswith("unix:")) {
+    StringRef Path = Address.drop_front(strlen("unix:"));
+    sockaddr_un Addr;
+    std::memset(&Addr, 0, sizeof(Addr));
+    if (Path.empty() || Path.size() >= sizeof(Addr.sun_path))
+      return makeError("invalid unix socket path '" + Path + "'");
+    Addr.sun_family = AF_UNIX;
+    std::memcpy(Addr.sun_path, Path.data(), Path.size());
+    int FD = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (FD < 0)
+      return makeSystemError("cannot create socket");
+    if (Fn(FD, reinterpret_cast<const sockaddr *>(&Addr), sizeof(Addr)) < 0) {
+      Error E = makeSystemError(Address);
+      ::close(FD);
+      return std::move(E);
+    }
+    return FD;
+  }
+
+  if (!Address.startswith("tcp:"))
+    return makeError("invalid cache server address '" + Address +
+                     "', expected unix:<path> or tcp:<host>:<port>");
+  StringRef Host, Port;
+  std::tie(Host, Port) = Address.drop_front(strlen("tcp:")).rsplit(':');
+  if (Host.empty() || Port.empty())
+    return makeError("invalid cache server address '" + Address + "'");
+
+  addrinfo Hints;
+  std::memset(&Hints, 0, sizeof(Hints));
+  Hints.ai_family = AF_UNSPEC;
+  Hints.ai_socktype = SOCK_STREAM;
+  addrinfo *Res;
+  if (int EC = ::getaddrinfo(Host.str().c_str(), Port.str().c_str(), &Hints,
+                             &Res))
+    return makeError(Address + ": " + ::gai_strerror(EC));
+
+  int Result = -1;
+  int LastErrno = 0;
+  for (addrinfo *AI = Res; AI && Result < 0; AI = AI->ai_next) {
+    int FD = ::socket(AI->ai_family, AI->ai_socktype, AI->ai_protocol);
+    if (FD >= 0 && Fn(FD, AI->ai_addr, AI->ai_addrlen) >= 0) {
+      Result = FD;
+      break;
+    }
+    LastErrno = errno;
+    if (FD >= 0)
+      ::close(FD);
+  }
+  ::freeaddrinfo(Res);
+  if (Result < 0) {
+    errno = LastErrno;
+    return makeSystemError(Address);
+  }
+  return Result;
+}
+
+Expected<int> cacheserver::listen(StringRef Address) {
+  return forEachSocketAddress(
+      Address, [](int FD, const sockaddr *Addr, socklen_t Len) {
+        int One = 1;
+        ::setsockopt(FD, SOL_SOCKET, SO_REUSEADDR, &One, sizeof(One));
+        if (::bind(FD, Addr, Len) < 0)
+          return -1;
+        return ::listen(FD, SOMAXCONN);
+      });
+}
+
+Expected<int> cacheserver::accept(int ListenFD) {
+  int FD;
+  do
+    FD = ::accept(ListenFD, nullptr, nullptr);
+  while (FD < 0 && errno == EINTR);
+  if (FD < 0)
+    return makeSystemError("cannot accept connection");
+  setTimeouts(FD);
+  return FD;
+}
+
+Expected<int> cacheserver::connect(StringRef Address) {
+  Expected<int> FD = forEachSocketAddress(
+      Address, [](int FD, const sockaddr *Addr, socklen_t Len) {
+        return ::connect(FD, Addr, Len);
+      });
+  if (FD)
+    setTimeouts(*FD);
+  return FD;
+}
+
+void cacheserver::close(int FD) { ::close(FD); }
+
+static Error writeAll(int FD, StringRef Data) {
+#ifdef MSG_NOSIGNAL
+  const int Flags = MSG_NOSIGNAL;
+#else
+  const int Flags = 0;
+#endif
+  while (!Data.empty()) {
+    ssize_t N = ::send(FD, Data.data(), Data.size(), Flags);
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0)
+      return makeSystemError("cannot write to cache connection");
+    Data = Data.drop_front(N);
+  }
+  return Error::success();
+}
+
+static Error readAll(int FD, char *Buf, size_t Size) {
+  while (Size) {
+    ssize_t N = ::recv(FD, Buf, Size, 0);
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N < 0)
+      return makeSystemError("cannot read from cache connection");
+    if (N == 0)
+      return makeError("cache connection closed unexpectedly");
+    Buf += N;
+    Size -= N;
+  }
+  return Error::success();
+}
+
+#else
+
+static Error unsupported() {
+  return makeError("cache servers are not supported on this platform");
+}
+
+Expected<int> cacheserver::listen(StringRef) { return unsupported(); }
+Expected<int> cacheserver::accept(int) { return unsupported(); }
+Expected<int> cacheserver::connect(StringRef) { return unsupported(); }
+void cacheserver::close(int) {}
+
+static Error writeAll(int, StringRef) { return unsupported(); }
+static Error readAll(int, char *, size_t) { return unsupported(); }
+
+#endif
+
+template <typename T> static Error writeInt(int FD, T Value) {
+  char Buf[sizeof(T)];
+  support::endian::write<T, support::little, support::unaligned>(Buf, Value);
+  return writeAll(FD, StringRef(Buf, sizeof(Buf)));
+}
+
+template <typename T> static Expected<T> readInt(int FD) {
+  char Buf[sizeof(T)];
+  if (Error E = readAll(FD, Buf, sizeof(Buf)))
+    return std::move(E);
+  return support::endian::read<T, support::little, support::unaligned>(Buf);
+}
+
+static std::array<uint8_t, 20> hashObject(StringRef Object) {
+  return SHA1::hash(
+      makeArrayRef(reinterpret_cast<const uint8_t *>(Object.data()),
+                   Object.size()));
+}
+
+Error cacheserver::writeRequest(int FD, Opcode Op, StringRef Key) {
+  char Header[sizeof(Magic) + 2];
+  std::memcpy(Header, Magic, sizeof(Magic));
+  Header[sizeof(Magic)] = ProtocolVersion;
+  Header[sizeof(Magic) + 1] = static_cast<char>(Op);
+  if (Error E = writeAll(FD, StringRef(Header, sizeof(Header))))
+    return E;
+  if (Op == Opcode::Shutdown)
+    return Error::success();
+  if (Error E = writeInt<uint32_t>(FD, Key.size()))
+    return E;
+  return writeAll(FD, Key);
+}
+
+Expected<Opcode> cacheserver::readRequest(int FD, std::string &Key) {
+  char Header[sizeof(Magic) + 2];
+  if (Error E = readAll(FD, Header, sizeof(Header)))
+    return std::move(E);
+  if (std::memcmp(Header, Magic, sizeof(Magic)))
+    return makeError("not a cache request");
+  if (Header[sizeof(Magic)] != ProtocolVersion)
+    return makeError("unsupported cache protocol version");
+
+  auto Op = static_cast<Opcode>(Header[sizeof(Magic) + 1]);
+  switch (Op) {
+  case Opcode::Shutdown:
+    return Op;
+  case Opcode::Get:
+  case Opcode::Put:
+    break;
+  default:
+    return makeError("unknown cache request");
+  }
+
+  Expected<uint32_t> KeySize = readInt<uint32_t>(FD);
+  if (!KeySize)
+    return KeySize.takeError();
+  if (*KeySize > 256)
+    return makeError("cache key too long");
+  Key.resize(*KeySize);
+  if (Error E = readAll(FD, &Key[0], Key.size()))
+    return std::move(E);
+  if (!isValidKey(Key))
+    return makeError("invalid cache key");
+  return Op;
+}
+
+Error cacheserver::writeStatus(int FD, Status S) {
+  char C = static_cast<char>(S);
+  return writeAll(FD, StringRef(&C, 1));
+}
+
+Expected<Status> cacheserver::readStatus(int FD) {
+  char C;
+  if (Error E = readAll(FD, &C, 1))
+    return std::move(E);
+  if (C != char(Status::Ok) && C != char(Status::Miss) &&
+      C != char(Status::Error))
+    return makeError("invalid cache response");
+  return static_cast<Status>(C);
+}
+
+Error cacheserver::writeObject(int FD, StringRef Object) {
+  std::array<uint8_t, 20> Hash = hashObject(Object);
+  if (Error E = writeAll(
+          FD, StringRef(reinterpret_cast<const char *>(Hash.data()),
+                        Hash.size())))
+    return E;
+  if (Error E = writeInt<uint64_t>(FD, Object.size()))
+    return E;
+  return writeAll(FD, Object);
+}
+
+Expected<std::unique_ptr<MemoryBuffer>>
+cacheserver::readObject(int FD, StringRef Key) {
+  std::array<uint8_t, 20> Hash;
+  if (Error E =
+          readAll(FD, reinterpret_cast<char *>(Hash.data()), Hash.size()))
+    return std::move(E);
+  Expected<uint64_t> Size = readInt<uint64_t>(FD);
+  if (!Size)
+    return Size.takeError();
+  if (*Size > MaxObjectSize)
+    return makeError("cached object too large");
+
+  std::unique_ptr<MemoryBuffer> MB =
+      MemoryBuffer::getNewUninitMemBuffer(*Size, "llvmcache-" + Key);
+  if (!MB)
+    return makeError("cannot allocate buffer for cached object");
+  char *Buf = const_cast<char *>(MB->getBufferStart());
+  if (Error E = readAll(FD, Buf, *Size))
+    return std::move(E);
+  if (hashObject(MB->getBuffer()) != Hash)
+    return makeError("cached object does not match its hash");
+  return std::move(MB);
+}
+
+namespace {
+/// A RemoteCache that talks to a cache server, using one connection per
+/// request so that it can be shared by all backend threads.
+class CacheServerClient : public RemoteCache {
+  std::string Address;
+
+public:
+  CacheServerClient(StringRef Address) : Address(Address) {}
+
+  Expected<std::unique_ptr<MemoryBuffer>> get(StringRef Key) override {
+    Expected<int> FD = cacheserver::connect(Address);
+    if (!FD)
+      return FD.takeError();
+    Expected<std::unique_ptr<MemoryBuffer>> Result = getImpl(*FD, Key);
+    cacheserver::close(*FD);
+    return Result;
+  }
+
+  Error put(StringRef Key, StringRef Object) override {
+    Expected<int> FD = cacheserver::connect(Address);
+    if (!FD)
+      return FD.takeError();
+    Error Result = putImpl(*FD, Key, Object);
+    cacheserver::close(*FD);
+    return Result;
+  }
+
+private:
+  Expected<std::unique_ptr<MemoryBuffer>> getImpl(int FD, StringRef Key) {
+    if (Error E = writeRequest(FD, Opcode::Get, Key))
+      return std::move(E);
+    Expected<Status> S = readStatus(FD);
+    if (!S)
+      return S.takeError();
+    if (*S == Status::Miss)
+      return nullptr;
+    if (*S != Status::Ok)
+      return makeError("cache server failed to look up " + Key);
+    return readObject(FD, Key);
+  }
+
+  Error putImpl(int FD, StringRef Key, StringRef Object) {
+    if (Error E = writeRequest(FD, Opcode::Put, Key))
+      return E;
+    if (Error E = writeObject(FD, Object))
+      return E;
+    Expected<Status> S = readStatus(FD);
+    if (!S)
+      return S.takeError();
+    if (*S != Status::Ok)
+      return makeError("cache server failed to store " + Key);
+    return Error::success();
+  }
+};
+} // end anonymous namespace
+
+RemoteCache::~RemoteCache() = default;
+
+Expected<std::unique_ptr<RemoteCache>>
+lto::createCacheServerClient(StringRef Address) {
+  if (!Address.startswith("unix:") && !Address.startswith("tcp:"))
+    return makeError("invalid cache server address '" + Address +
+                     "', expected unix:<path> or tcp:<host>:<port>");
+  return llvm::make_unique<CacheServerClient>(Address);
+}
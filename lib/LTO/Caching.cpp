@@ -13,17 +13,122 @@
 
 #include "llvm/LTO/Caching.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <cstring>
 
 using namespace llvm;
 using namespace llvm::lto;
 
-Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
-                                            AddBufferFn AddBuffer) {
+/// Create a temporary file in the cache directory to write an entry to.
+static void createTempCacheFile(StringRef CacheDirectoryPath, int &TempFD,
+                                SmallVectorImpl<char> &TempFilename) {
+  SmallString<64> TempFilenameModel;
+  sys::path::append(TempFilenameModel, CacheDirectoryPath, "Thin-%%%%%%.tmp.o");
+  std::error_code EC =
+      sys::fs::createUniqueFile(TempFilenameModel, TempFD, TempFilename,
+                                sys::fs::owner_read | sys::fs::owner_write);
+  if (EC) {
+    errs() << "Error: " << EC.message() << "\n";
+    report_fatal_error("ThinLTO: Can't get a temporary file");
+  }
+}
+
+// Compressed entries start with this magic, a format version and the size of
+// the uncompressed object as a little-endian u64, followed by the zlib stream.
+// Uncompressed entries are plain object files and never start with the magic.
+static const char CompressedMagic[] = {'L', 'L', 'V', 'M', 'C', 'Z'};
+enum : uint8_t { CompressedFormatVersion = 1 };
+static const size_t CompressedHeaderSize = sizeof(CompressedMagic) + 1 + 8;
+static const uint64_t MaxCompressionRatio = 1032;
+
+/// Write an entry to the cache through a temporary file, compressing it if
+/// requested and possible. Returns false if the entry could not be written.
+static bool writeCacheEntry(StringRef CacheDirectoryPath, StringRef EntryPath,
+                            StringRef Object, bool Compress) {
+  SmallString<0> Compressed;
+  if (Compress && zlib::isAvailable()) {
+    Compressed.resize(CompressedHeaderSize);
+    std::memcpy(Compressed.data(), CompressedMagic, sizeof(CompressedMagic));
+    Compressed[sizeof(CompressedMagic)] = CompressedFormatVersion;
+    support::endian::write64le(&Compressed[sizeof(CompressedMagic) + 1],
+                               Object.size());
+    SmallString<0> Stream;
+    if (Error E = zlib::compress(Object, Stream)) {
+      consumeError(std::move(E));
+      Compressed.clear();
+    } else {
+      Compressed.append(Stream.begin(), Stream.end());
+    }
+  }
+
+  int TempFD;
+  SmallString<64> TempFilename;
+  createTempCacheFile(CacheDirectoryPath, TempFD, TempFilename);
+  {
+    raw_fd_ostream OS(TempFD, /* ShouldClose */ true);
+    StringRef Entry = Compressed.empty() ? Object : StringRef(Compressed);
+    OS << Entry;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempFilename);
+      return false;
+    }
+  }
+  if (sys::fs::rename(TempFilename, EntryPath)) {
+    sys::fs::remove(TempFilename);
+    return false;
+  }
+  recordCacheAccess(CacheDirectoryPath, EntryPath,
+                    Compressed.empty() ? Object.size() : Compressed.size());
+  return true;
+}
+
+/// Return the object held by a cache entry, decompressing it if needed.
+/// Returns null if the entry is corrupt or has an unknown format.
+static std::unique_ptr<MemoryBuffer>
+readCacheEntry(std::unique_ptr<MemoryBuffer> Entry) {
+  StringRef Buffer = Entry->getBuffer();
+  if (!Buffer.startswith(StringRef(CompressedMagic, sizeof(CompressedMagic))))
+    return Entry;
+  if (Buffer.size() < CompressedHeaderSize ||
+      uint8_t(Buffer[sizeof(CompressedMagic)]) != CompressedFormatVersion ||
+      !zlib::isAvailable())
+    return nullptr;
+
+  // Deflate cannot compress by more than 1032:1, so a larger size comes from
+  // a corrupt header and must not be allocated.
+  uint64_t Size =
+      support::endian::read64le(Buffer.data() + sizeof(CompressedMagic) + 1);
+  uint64_t StreamSize = Buffer.size() - CompressedHeaderSize;
+  if (Size > StreamSize * MaxCompressionRatio || Size != size_t(Size))
+    return nullptr;
+  std::unique_ptr<MemoryBuffer> Object = MemoryBuffer::getNewUninitMemBuffer(
+      Size, Entry->getBufferIdentifier());
+  if (!Object)
+    return nullptr;
+  size_t UncompressedSize = Size;
+  if (Error E = zlib::uncompress(Buffer.drop_front(CompressedHeaderSize),
+                                 const_cast<char *>(Object->getBufferStart()),
+                                 UncompressedSize)) {
+    consumeError(std::move(E));
+    return nullptr;
+  }
+  if (UncompressedSize != Size)
+    return nullptr;
+  return Object;
+}
+
+Expected<NativeObjectCache>
+lto::localCache(StringRef CacheDirectoryPath, AddBufferFn AddBuffer,
+                std::shared_ptr<RemoteCache> Remote, bool CompressEntries) {
   if (std::error_code EC = sys::fs::create_directories(CacheDirectoryPath))
     return errorCodeToError(EC);
 
@@ -36,13 +141,39 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
     ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
         MemoryBuffer::getFile(EntryPath);
     if (MBOrErr) {
-      AddBuffer(Task, std::move(*MBOrErr));
-      return AddStreamFn();
-    }
-
-    if (MBOrErr.getError() != errc::no_such_file_or_directory)
+      // An entry that cannot be read back is treated as a miss, and will be
+      // replaced by the rebuilt object.
+      uint64_t EntrySize = (*MBOrErr)->getBufferSize();
+      if (std::unique_ptr<MemoryBuffer> MB =
+              readCacheEntry(std::move(*MBOrErr))) {
+        recordCacheAccess(CacheDirectoryPath, EntryPath, EntrySize);
+        AddBuffer(Task, std::move(MB));
+        return AddStreamFn();
+      }
+    } else if (MBOrErr.getError() != errc::no_such_file_or_directory) {
       report_fatal_error(Twine("Failed to open cache file ") + EntryPath +
                          ": " + MBOrErr.getError().message() + "\n");
+    }
+
+    // On a local miss, try the remote tier. Its failures are only misses.
+    if (Remote) {
+      Expected<std::unique_ptr<MemoryBuffer>> RemoteMB = Remote->get(Key);
+      if (!RemoteMB) {
+        consumeError(RemoteMB.takeError());
+      } else if (*RemoteMB &&
+                 writeCacheEntry(CacheDirectoryPath, EntryPath,
+                                 (*RemoteMB)->getBuffer(), CompressEntries)) {
+        // Prefer handing out the local copy, which is backed by a file,
+        // unless the local copy is compressed.
+        std::unique_ptr<MemoryBuffer> MB = std::move(*RemoteMB);
+        if (!CompressEntries)
+          if (ErrorOr<std::unique_ptr<MemoryBuffer>> LocalMB =
+                  MemoryBuffer::getFile(EntryPath))
+            MB = std::move(*LocalMB);
+        AddBuffer(Task, std::move(MB));
+        return AddStreamFn();
+      }
+    }
 
     // This native object stream is responsible for commiting the resulting
     // file to the cache and calling AddBuffer to add it to the link.
@@ -50,14 +181,42 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
       AddBufferFn AddBuffer;
       std::string TempFilename;
       std::string EntryPath;
+      std::string Key;
+      std::shared_ptr<RemoteCache> Remote;
+      std::string CacheDirectoryPath;
+      bool Compress;
       unsigned Task;
 
       CacheStream(std::unique_ptr<raw_pwrite_stream> OS, AddBufferFn AddBuffer,
                   std::string TempFilename, std::string EntryPath,
-                  unsigned Task)
+                  std::string Key, std::shared_ptr<RemoteCache> Remote,
+                  std::string CacheDirectoryPath, bool Compress, unsigned Task)
           : NativeObjectStream(std::move(OS)), AddBuffer(std::move(AddBuffer)),
             TempFilename(std::move(TempFilename)),
-            EntryPath(std::move(EntryPath)), Task(Task) {}
+            EntryPath(std::move(EntryPath)), Key(std::move(Key)),
+            Remote(std::move(Remote)),
+            CacheDirectoryPath(std::move(CacheDirectoryPath)),
+            Compress(Compress), Task(Task) {}
+
+      /// Replace the temporary file by a compressed entry, and return the
+      /// uncompressed object.
+      std::unique_ptr<MemoryBuffer> commitCompressed() {
+        // Read the object into memory rather than mapping it, as the file is
+        // removed below.
+        ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr = MemoryBuffer::getFile(
+            TempFilename, /*FileSize=*/-1, /*RequiresNullTerminator=*/true,
+            /*IsVolatile=*/true);
+        if (!MBOrErr)
+          report_fatal_error(Twine("Failed to open temporary file ") +
+                             TempFilename + ": " +
+                             MBOrErr.getError().message() + "\n");
+        if (!writeCacheEntry(CacheDirectoryPath, EntryPath,
+                             (*MBOrErr)->getBuffer(), /*Compress=*/true))
+          report_fatal_error(Twine("Failed to write cache file ") + EntryPath +
+                             "\n");
+        sys::fs::remove(TempFilename);
+        return std::move(*MBOrErr);
+      }
 
       ~CacheStream() {
         // FIXME: This code could race with the cache pruner, but it is unlikely
@@ -65,37 +224,45 @@ Expected<NativeObjectCache> lto::localCache(StringRef CacheDirectoryPath,
 
         // Make sure the file is closed before committing it.
         OS.reset();
-        // This is atomic on POSIX systems.
-        if (auto EC = sys::fs::rename(TempFilename, EntryPath))
-          report_fatal_error(Twine("Failed to rename temporary file ") +
-                             TempFilename + ": " + EC.message() + "\n");
 
-        ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
-            MemoryBuffer::getFile(EntryPath);
-        if (!MBOrErr)
-          report_fatal_error(Twine("Failed to open cache file ") + EntryPath +
-                             ": " + MBOrErr.getError().message() + "\n");
-        AddBuffer(Task, std::move(*MBOrErr));
+        std::unique_ptr<MemoryBuffer> MB;
+        if (Compress) {
+          MB = commitCompressed();
+        } else {
+          // This is atomic on POSIX systems.
+          if (auto EC = sys::fs::rename(TempFilename, EntryPath))
+            report_fatal_error(Twine("Failed to rename temporary file ") +
+                               TempFilename + ": " + EC.message() + "\n");
+
+          ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+              MemoryBuffer::getFile(EntryPath);
+          if (!MBOrErr)
+            report_fatal_error(Twine("Failed to open cache file ") +
+                               EntryPath + ": " +
+                               MBOrErr.getError().message() + "\n");
+          MB = std::move(*MBOrErr);
+          recordCacheAccess(CacheDirectoryPath, EntryPath,
+                            MB->getBufferSize());
+        }
+        // Share the new object. A failure here only costs a later miss.
+        if (Remote)
+          consumeError(Remote->put(Key, MB->getBuffer()));
+        AddBuffer(Task, std::move(MB));
       }
     };
 
+    std::string KeyStr = Key;
     return [=](size_t Task) -> std::unique_ptr<NativeObjectStream> {
       // Write to a temporary to avoid race condition
       int TempFD;
-      SmallString<64> TempFilenameModel, TempFilename;
-      sys::path::append(TempFilenameModel, CacheDirectoryPath, "Thin-%%%%%%.tmp.o");
-      std::error_code EC =
-          sys::fs::createUniqueFile(TempFilenameModel, TempFD, TempFilename,
-                                    sys::fs::owner_read | sys::fs::owner_write);
-      if (EC) {
-        errs() << "Error: " << EC.message() << "\n";
-        report_fatal_error("ThinLTO: Can't get a temporary file");
-      }
+      SmallString<64> TempFilename;
+      createTempCacheFile(CacheDirectoryPath, TempFD, TempFilename);
 
       // This CacheStream will move the temporary file into the cache when done.
       return llvm::make_unique<CacheStream>(
           llvm::make_unique<raw_fd_ostream>(TempFD, /* ShouldClose */ true),
-          AddBuffer, TempFilename.str(), EntryPath.str(), Task);
+          AddBuffer, TempFilename.str(), EntryPath.str(), KeyStr, Remote,
+          CacheDirectoryPath, CompressEntries, Task);
     };
   };
 }
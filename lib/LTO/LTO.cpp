@@ -25,15 +25,21 @@
 #include "llvm/LTO/LTOBackend.h"
 #include "llvm/Linker/IRMover.h"
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/VCSRevision.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -42,6 +48,8 @@
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Utils/SplitModule.h"
 
+#include <chrono>
+#include <deque>
 #include <set>
 
 using namespace llvm;
@@ -50,6 +58,19 @@ using namespace object;
 
 #define DEBUG_TYPE "lto"
 
+static cl::opt<unsigned> ThinLTOBytesPerInstruction(
+    "thinlto-bytes-per-inst", cl::init(2048), cl::Hidden,
+    cl::desc("Estimated peak memory of a ThinLTO backend per instruction of "
+             "its module and imports, in bytes"));
+
+static cl::opt<unsigned> ThinLTOMinJobs(
+    "thinlto-min-jobs", cl::init(2), cl::Hidden,
+    cl::desc("Number of ThinLTO backend jobs that may run at once whatever the "
+             "resident memory, if their estimates fit the memory budget"));
+
+static const char *const ThinLinkTimerGroupName = "thinlink";
+static const char *const ThinLinkTimerGroupDescription = "ThinLTO thin link";
+
 // The values are (type identifier, summary) pairs.
 typedef DenseMap<
     GlobalValue::GUID,
@@ -292,6 +313,24 @@ static void thinLTOResolveWeakForLinkerGUID(
   }
 }
 
+/// Split the values of \p Index in \p NumChunks ranges of about the same size,
+/// for the thin link analyses updating each value independently. Return the
+/// NumChunks + 1 bounds of the ranges.
+static std::vector<gvsummary_iterator> splitIndex(ModuleSummaryIndex &Index,
+                                                  size_t NumChunks) {
+  std::vector<gvsummary_iterator> Bounds;
+  Bounds.reserve(NumChunks + 1);
+  auto It = Index.begin();
+  size_t Pos = 0;
+  for (size_t Chunk = 0; Chunk <= NumChunks; ++Chunk) {
+    size_t Next = Index.size() * Chunk / NumChunks;
+    std::advance(It, Next - Pos);
+    Pos = Next;
+    Bounds.push_back(It);
+  }
+  return Bounds;
+}
+
 // Resolve Weak and LinkOnce values in the \p Index.
 //
 // We'd like to drop these functions if they are no longer referenced in the
@@ -303,7 +342,8 @@ void llvm::thinLTOResolveWeakForLinkerInIndex(
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
         isPrevailing,
     function_ref<void(StringRef, GlobalValue::GUID, GlobalValue::LinkageTypes)>
-        recordNewLinkage) {
+        recordNewLinkage,
+    unsigned Threads) {
   // We won't optimize the globals that are referenced by an alias for now
   // Ideally we should turn the alias into a global and duplicate the definition
   // when needed.
@@ -313,10 +353,38 @@ void llvm::thinLTOResolveWeakForLinkerInIndex(
       if (auto AS = dyn_cast<AliasSummary>(S.get()))
         GlobalInvolvedWithAlias.insert(&AS->getAliasee());
 
-  for (auto &I : Index)
-    thinLTOResolveWeakForLinkerGUID(I.second.SummaryList, I.first,
-                                    GlobalInvolvedWithAlias, isPrevailing,
-                                    recordNewLinkage);
+  if (Threads <= 1 || Index.size() <= 1) {
+    for (auto &I : Index)
+      thinLTOResolveWeakForLinkerGUID(I.second.SummaryList, I.first,
+                                      GlobalInvolvedWithAlias, isPrevailing,
+                                      recordNewLinkage);
+    return;
+  }
+
+  // Each value only updates its own summaries. The new linkages are buffered
+  // per range of values and recorded in index order once all are resolved.
+  using NewLinkage = std::tuple<StringRef, GlobalValue::GUID,
+                                GlobalValue::LinkageTypes>;
+  size_t NumChunks = std::min<size_t>(Index.size(), 4 * Threads);
+  auto Bounds = splitIndex(Index, NumChunks);
+  std::vector<std::vector<NewLinkage>> ChunkLinkages(NumChunks);
+  ThreadPool Pool(Threads);
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk)
+    Pool.async([&, Chunk] {
+      auto record = [&](StringRef ModuleIdentifier, GlobalValue::GUID GUID,
+                        GlobalValue::LinkageTypes Linkage) {
+        ChunkLinkages[Chunk].emplace_back(ModuleIdentifier, GUID, Linkage);
+      };
+      for (auto I = Bounds[Chunk]; I != Bounds[Chunk + 1]; ++I)
+        thinLTOResolveWeakForLinkerGUID(I->second.SummaryList, I->first,
+                                        GlobalInvolvedWithAlias, isPrevailing,
+                                        record);
+    });
+  Pool.wait();
+
+  for (auto &Linkages : ChunkLinkages)
+    for (auto &L : Linkages)
+      recordNewLinkage(std::get<0>(L), std::get<1>(L), std::get<2>(L));
 }
 
 static void thinLTOInternalizeAndPromoteGUID(
@@ -335,9 +403,26 @@ static void thinLTOInternalizeAndPromoteGUID(
 // as external and non-exported values as internal.
 void llvm::thinLTOInternalizeAndPromoteInIndex(
     ModuleSummaryIndex &Index,
-    function_ref<bool(StringRef, GlobalValue::GUID)> isExported) {
-  for (auto &I : Index)
-    thinLTOInternalizeAndPromoteGUID(I.second.SummaryList, I.first, isExported);
+    function_ref<bool(StringRef, GlobalValue::GUID)> isExported,
+    unsigned Threads) {
+  if (Threads <= 1 || Index.size() <= 1) {
+    for (auto &I : Index)
+      thinLTOInternalizeAndPromoteGUID(I.second.SummaryList, I.first,
+                                       isExported);
+    return;
+  }
+
+  // Each value only updates its own summaries.
+  size_t NumChunks = std::min<size_t>(Index.size(), 4 * Threads);
+  auto Bounds = splitIndex(Index, NumChunks);
+  ThreadPool Pool(Threads);
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk)
+    Pool.async([&, Chunk] {
+      for (auto I = Bounds[Chunk]; I != Bounds[Chunk + 1]; ++I)
+        thinLTOInternalizeAndPromoteGUID(I->second.SummaryList, I->first,
+                                         isExported);
+    });
+  Pool.wait();
 }
 
 // Requires a destructor for std::vector<InputModule>.
@@ -734,7 +819,13 @@ Error LTO::run(AddStreamFn AddStream, NativeObjectCache Cache) {
           GlobalValue::dropLLVMManglingEscape(Res.second.IRName)));
   }
 
-  computeDeadSymbols(ThinLTO.CombinedIndex, GUIDPreservedSymbols);
+  {
+    NamedRegionTimer T("dead-symbols", "Compute dead symbols",
+                       ThinLinkTimerGroupName, ThinLinkTimerGroupDescription,
+                       Conf.TimeThinLink);
+    computeDeadSymbols(ThinLTO.CombinedIndex, GUIDPreservedSymbols,
+                       Conf.ThinLinkThreads);
+  }
 
   // Save the status of having a regularLTO combined module, as
   // this is needed for generating the ThinLTO Task ID, and
@@ -845,6 +936,8 @@ class InProcessThinBackend : public ThinBackendProc {
   TypeIdSummariesByGuidTy TypeIdSummariesByGuid;
   std::set<GlobalValue::GUID> CfiFunctionDefs;
   std::set<GlobalValue::GUID> CfiFunctionDecls;
+  /// Indexes of the modules imported from, shared by the backend threads.
+  BitcodeLazyLoadCache LazyLoadCache;
 
   Optional<Error> Err;
   std::mutex ErrMu;
@@ -857,7 +950,10 @@ public:
       AddStreamFn AddStream, NativeObjectCache Cache)
       : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
         BackendThreadPool(ThinLTOParallelismLevel),
-        AddStream(std::move(AddStream)), Cache(std::move(Cache)) {
+        AddStream(std::move(AddStream)), Cache(std::move(Cache)),
+        ParallelismLevel(std::max(ThinLTOParallelismLevel, 1u)),
+        SchedulingStart(std::chrono::steady_clock::now()),
+        BaselineRSS(sys::Process::GetResidentSetSize()) {
     // Create a mapping from type identifier GUIDs to type identifier summaries.
     // This allows backends to use the type identifier GUIDs stored in the
     // function summaries to determine which type identifier summaries affect
@@ -872,6 +968,21 @@ public:
           GlobalValue::getGUID(GlobalValue::dropLLVMManglingEscape(Name)));
   }
 
+  /// Run the backend of module \p BM, adding its object to \p AddStream.
+  virtual Error runBackend(AddStreamFn AddStream, unsigned Task,
+                           BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
+                           const FunctionImporter::ImportMapTy &ImportList,
+                           const GVSummaryMapTy &DefinedGlobals,
+                           MapVector<StringRef, BitcodeModule> &ModuleMap) {
+    LTOLLVMContext BackendContext(Conf);
+    Expected<std::unique_ptr<Module>> MOrErr = BM.parseModule(BackendContext);
+    if (!MOrErr)
+      return MOrErr.takeError();
+
+    return thinBackend(Conf, Task, AddStream, **MOrErr, CombinedIndex,
+                       ImportList, DefinedGlobals, ModuleMap, &LazyLoadCache);
+  }
+
   Error runThinLTOBackendThread(
       AddStreamFn AddStream, NativeObjectCache Cache, unsigned Task,
       BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
@@ -882,13 +993,8 @@ public:
       MapVector<StringRef, BitcodeModule> &ModuleMap,
       const TypeIdSummariesByGuidTy &TypeIdSummariesByGuid) {
     auto RunThinBackend = [&](AddStreamFn AddStream) {
-      LTOLLVMContext BackendContext(Conf);
-      Expected<std::unique_ptr<Module>> MOrErr = BM.parseModule(BackendContext);
-      if (!MOrErr)
-        return MOrErr.takeError();
-
-      return thinBackend(Conf, Task, AddStream, **MOrErr, CombinedIndex,
-                         ImportList, DefinedGlobals, ModuleMap);
+      return runBackend(AddStream, Task, BM, CombinedIndex, ImportList,
+                        DefinedGlobals, ModuleMap);
     };
 
     auto ModuleID = BM.getModuleIdentifier();
@@ -921,39 +1027,171 @@ public:
     assert(ModuleToDefinedGVSummaries.count(ModulePath));
     const GVSummaryMapTy &DefinedGlobals =
         ModuleToDefinedGVSummaries.find(ModulePath)->second;
-    BackendThreadPool.async(
-        [=](BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
-            const FunctionImporter::ImportMapTy &ImportList,
-            const FunctionImporter::ExportSetTy &ExportList,
-            const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>
-                &ResolvedODR,
-            const GVSummaryMapTy &DefinedGlobals,
-            MapVector<StringRef, BitcodeModule> &ModuleMap,
-            const TypeIdSummariesByGuidTy &TypeIdSummariesByGuid) {
-          Error E = runThinLTOBackendThread(
-              AddStream, Cache, Task, BM, CombinedIndex, ImportList, ExportList,
-              ResolvedODR, DefinedGlobals, ModuleMap, TypeIdSummariesByGuid);
-          if (E) {
-            std::unique_lock<std::mutex> L(ErrMu);
-            if (Err)
-              Err = joinErrors(std::move(*Err), std::move(E));
-            else
-              Err = std::move(E);
-          }
-        },
-        BM, std::ref(CombinedIndex), std::ref(ImportList), std::ref(ExportList),
-        std::ref(ResolvedODR), std::ref(DefinedGlobals), std::ref(ModuleMap),
-        std::ref(TypeIdSummariesByGuid));
+    uint64_t Cost = estimateBackendCost(DefinedGlobals, ImportList);
+
+    std::lock_guard<std::mutex> L(SchedulingMu);
+    Jobs.push_back({Task, BM, &ImportList, &ExportList, &ResolvedODR,
+                    &DefinedGlobals, &ModuleMap, Cost, {}, {}});
+    // Keep the pending jobs largest first, in the order they were added for
+    // the same cost.
+    BackendJob *Job = &Jobs.back();
+    Pending.insert(std::upper_bound(Pending.begin(), Pending.end(), Job,
+                                    [](const BackendJob *A,
+                                       const BackendJob *B) {
+                                      return A->Cost > B->Cost;
+                                    }),
+                   Job);
+    // Without a memory budget, a job starts as soon as a thread is free. With
+    // one, which job fits depends on all of them, so wait() starts them.
+    if (!Conf.ThinLTOMemoryBudget)
+      startJobs();
     return Error::success();
   }
 
   Error wait() override {
+    {
+      std::lock_guard<std::mutex> L(SchedulingMu);
+      startJobs();
+    }
+    // The jobs left are started by the running ones as they complete.
     BackendThreadPool.wait();
+    assert(Pending.empty() && !Running && "ThinLTO backend jobs not run");
+
+    if (Conf.ReportThinLTOJobs)
+      printJobReport(errs());
+
     if (Err)
       return std::move(*Err);
     else
       return Error::success();
   }
+
+private:
+  struct BackendJob {
+    unsigned Task;
+    BitcodeModule BM;
+    const FunctionImporter::ImportMapTy *ImportList;
+    const FunctionImporter::ExportSetTy *ExportList;
+    const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes> *ResolvedODR;
+    const GVSummaryMapTy *DefinedGlobals;
+    MapVector<StringRef, BitcodeModule> *ModuleMap;
+    /// Instructions of the module and of the functions imported into it.
+    uint64_t Cost;
+    /// Start and end of the job, relative to SchedulingStart.
+    std::chrono::duration<double> Start, End;
+  };
+
+  unsigned ParallelismLevel;
+  std::chrono::steady_clock::time_point SchedulingStart;
+  /// Resident set size before any job, or 0 if it is not available.
+  size_t BaselineRSS;
+
+  /// Guards the members below. Jobs is a deque, so that adding a job does not
+  /// move the running ones.
+  std::mutex SchedulingMu;
+  std::deque<BackendJob> Jobs;
+  /// Jobs not started yet, largest first.
+  std::vector<BackendJob *> Pending;
+  /// Jobs in the order they were started.
+  std::vector<const BackendJob *> Started;
+  unsigned Running = 0;
+  unsigned MaxRunning = 0;
+  uint64_t RunningEstimate = 0;
+
+  uint64_t estimateBackendCost(const GVSummaryMapTy &DefinedGlobals,
+                               const FunctionImporter::ImportMapTy &ImportList) {
+    uint64_t Cost = 0;
+    for (auto &Def : DefinedGlobals)
+      if (auto *FS = dyn_cast<FunctionSummary>(Def.second))
+        Cost += FS->instCount();
+    for (auto &Src : ImportList)
+      for (auto &Import : Src.second)
+        if (auto *FS = dyn_cast_or_null<FunctionSummary>(
+                CombinedIndex.findSummaryInModule(Import.first, Src.first())))
+          Cost += FS->instCount();
+    return Cost;
+  }
+
+  static uint64_t estimateMemory(uint64_t Cost) {
+    return Cost * ThinLTOBytesPerInstruction;
+  }
+
+  /// Whether \p Job may start now. It must fit in the memory budget with the
+  /// estimates of the running jobs. Once ThinLTOMinJobs are running, it must
+  /// also fit with the resident memory gained since the backend was created.
+  /// That reading is only a hint: it covers the whole process, so it cannot
+  /// keep the backends from running ThinLTOMinJobs at once. A job is always
+  /// started when none is running.
+  bool mayStart(const BackendJob &Job) {
+    uint64_t Budget = Conf.ThinLTOMemoryBudget;
+    if (!Running || !Budget)
+      return true;
+    uint64_t Estimate = estimateMemory(Job.Cost);
+    if (RunningEstimate + Estimate > Budget)
+      return false;
+    if (Running < ThinLTOMinJobs || !BaselineRSS)
+      return true;
+    size_t RSS = sys::Process::GetResidentSetSize();
+    uint64_t Gained = RSS > BaselineRSS ? RSS - BaselineRSS : 0;
+    return Gained + Estimate <= Budget;
+  }
+
+  /// Start the largest pending jobs that may start, while a thread is free.
+  /// Called with SchedulingMu held.
+  void startJobs() {
+    while (Running < ParallelismLevel) {
+      auto I = std::find_if(Pending.begin(), Pending.end(),
+                            [&](const BackendJob *Job) {
+                              return mayStart(*Job);
+                            });
+      if (I == Pending.end())
+        return;
+      BackendJob *Job = *I;
+      Pending.erase(I);
+      Started.push_back(Job);
+      RunningEstimate += estimateMemory(Job->Cost);
+      MaxRunning = std::max(MaxRunning, ++Running);
+      BackendThreadPool.async([this, Job] { runJob(*Job); });
+    }
+  }
+
+  void runJob(BackendJob &Job) {
+    Job.Start = std::chrono::steady_clock::now() - SchedulingStart;
+    Error E = runThinLTOBackendThread(
+        AddStream, Cache, Job.Task, Job.BM, CombinedIndex, *Job.ImportList,
+        *Job.ExportList, *Job.ResolvedODR, *Job.DefinedGlobals, *Job.ModuleMap,
+        TypeIdSummariesByGuid);
+    Job.End = std::chrono::steady_clock::now() - SchedulingStart;
+    if (E) {
+      std::unique_lock<std::mutex> L(ErrMu);
+      if (Err)
+        Err = joinErrors(std::move(*Err), std::move(E));
+      else
+        Err = std::move(E);
+    }
+
+    std::lock_guard<std::mutex> L(SchedulingMu);
+    RunningEstimate -= estimateMemory(Job.Cost);
+    --Running;
+    startJobs();
+  }
+
+  /// Print the jobs in the order they were started.
+  void printJobReport(raw_ostream &OS) {
+    OS << "===" << std::string(73, '-') << "===\n"
+       << "                           ThinLTO backend jobs\n"
+       << "===" << std::string(73, '-') << "===\n";
+    OS << "  Task      Insts   Est. MiB   Start (s)   Wall (s)  Module\n";
+    for (const BackendJob *Job : Started)
+      OS << format("%6u %10llu %10.1f %11.3f %10.3f  ", Job->Task,
+                   (unsigned long long)Job->Cost,
+                   estimateMemory(Job->Cost) / (1024.0 * 1024.0),
+                   Job->Start.count(), (Job->End - Job->Start).count())
+         << Job->BM.getModuleIdentifier() << '\n';
+    OS << "Most jobs running at once: " << MaxRunning << "\n";
+    if (size_t Peak = sys::Process::GetPeakResidentSetSize())
+      OS << "Peak resident set size: " << Peak / (1024 * 1024) << " MiB\n";
+  }
 };
 } // end anonymous namespace
 
@@ -967,6 +1205,231 @@ ThinBackend lto::createInProcessThinBackend(unsigned ParallelismLevel) {
   };
 }
 
+namespace {
+/// Runs the backends like InProcessThinBackend, but each in a worker process
+/// which reads the module and its imports from files.
+class OutOfProcessThinBackend : public InProcessThinBackend {
+  std::vector<std::string> WorkerArgs;
+
+  /// Module identifier -> bitcode file holding the module alone, written the
+  /// first time a job needs the module.
+  StringMap<std::string> ModuleFiles;
+  std::mutex ModuleFilesMu;
+
+public:
+  OutOfProcessThinBackend(
+      Config &Conf, ModuleSummaryIndex &CombinedIndex,
+      unsigned ParallelismLevel,
+      const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+      AddStreamFn AddStream, NativeObjectCache Cache,
+      std::vector<std::string> WorkerArgs)
+      : InProcessThinBackend(Conf, CombinedIndex, ParallelismLevel,
+                             ModuleToDefinedGVSummaries, std::move(AddStream),
+                             std::move(Cache)),
+        WorkerArgs(std::move(WorkerArgs)) {}
+
+  ~OutOfProcessThinBackend() override {
+    for (auto &File : ModuleFiles)
+      if (!File.second.empty())
+        sys::fs::remove(File.second);
+  }
+
+  Expected<std::string> getModuleFile(BitcodeModule BM) {
+    std::lock_guard<std::mutex> Lock(ModuleFilesMu);
+    std::string &Path = ModuleFiles[BM.getModuleIdentifier()];
+    if (!Path.empty())
+      return Path;
+
+    // The module may be one of several in its file, or only exist in memory,
+    // so it is always copied to a file of its own, with its string table.
+    SmallString<128> NewPath;
+    int FD;
+    if (std::error_code EC =
+            sys::fs::createTemporaryFile("thinlto-module", "bc", FD, NewPath))
+      return errorCodeToError(EC);
+    SmallVector<char, 0> Buffer;
+    BitcodeWriter Writer(Buffer);
+    Buffer.append(BM.getBuffer().begin(), BM.getBuffer().end());
+    Writer.copyStrtab(BM.getStrtab());
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Buffer;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(NewPath);
+      return make_error<StringError>(Twine("could not write ") + NewPath,
+                                     inconvertibleErrorCode());
+    }
+    Path = NewPath.str();
+    return Path;
+  }
+
+  Error runBackend(AddStreamFn AddStream, unsigned Task, BitcodeModule BM,
+                   ModuleSummaryIndex &CombinedIndex,
+                   const FunctionImporter::ImportMapTy &ImportList,
+                   const GVSummaryMapTy &DefinedGlobals,
+                   MapVector<StringRef, BitcodeModule> &ModuleMap) override {
+    StringRef ModulePath = BM.getModuleIdentifier();
+
+    // The worker reads the index of the module rather than the combined one.
+    std::map<std::string, GVSummaryMapTy> ModuleToSummariesForIndex;
+    gatherImportedSummariesForModule(ModulePath, ModuleToDefinedGVSummaries,
+                                     ImportList, ModuleToSummariesForIndex);
+    SmallString<128> IndexPath;
+    int FD;
+    if (std::error_code EC = sys::fs::createTemporaryFile(
+            "thinlto-index", "thinlto.bc", FD, IndexPath))
+      return errorCodeToError(EC);
+    FileRemover IndexRemover(IndexPath);
+    {
+      raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      WriteIndexToFile(CombinedIndex, OS, &ModuleToSummariesForIndex);
+    }
+
+    // List the module identifiers and their files, the module first.
+    std::string ModuleList;
+    auto addModule = [&](BitcodeModule M) -> Error {
+      Expected<std::string> File = getModuleFile(M);
+      if (!File)
+        return File.takeError();
+      ModuleList += M.getModuleIdentifier();
+      ModuleList += '\n';
+      ModuleList += *File;
+      ModuleList += '\n';
+      return Error::success();
+    };
+    if (Error E = addModule(BM))
+      return E;
+    for (auto &Import : ImportList) {
+      auto I = ModuleMap.find(Import.first());
+      assert(I != ModuleMap.end() && "Importing from an unknown module");
+      if (Error E = addModule(I->second))
+        return E;
+    }
+    SmallString<128> ListPath;
+    if (std::error_code EC = sys::fs::createTemporaryFile(
+            "thinlto-modules", "txt", FD, ListPath))
+      return errorCodeToError(EC);
+    FileRemover ListRemover(ListPath);
+    {
+      raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      OS << ModuleList;
+    }
+
+    SmallString<128> ObjectPath;
+    if (std::error_code EC =
+            sys::fs::createTemporaryFile("thinlto-object", "o", ObjectPath))
+      return errorCodeToError(EC);
+    FileRemover ObjectRemover(ObjectPath);
+
+    std::vector<const char *> Args;
+    for (const std::string &Arg : WorkerArgs)
+      Args.push_back(Arg.c_str());
+    Args.push_back("-o");
+    Args.push_back(ObjectPath.c_str());
+    Args.push_back(IndexPath.c_str());
+    Args.push_back(ListPath.c_str());
+    Args.push_back(nullptr);
+    std::string ErrMsg;
+    bool ExecutionFailed;
+    int Status = sys::ExecuteAndWait(WorkerArgs[0], Args.data(),
+                                     /*env=*/nullptr, /*redirects=*/nullptr,
+                                     /*secondsToWait=*/0, /*memoryLimit=*/0,
+                                     &ErrMsg, &ExecutionFailed);
+    if (ExecutionFailed || Status != 0)
+      return make_error<StringError>(
+          Twine("ThinLTO backend process for ") + ModulePath + " failed" +
+              (ErrMsg.empty() ? "" : ": " + ErrMsg),
+          inconvertibleErrorCode());
+
+    ErrorOr<std::unique_ptr<MemoryBuffer>> ObjectOrErr =
+        MemoryBuffer::getFile(ObjectPath);
+    if (!ObjectOrErr)
+      return errorCodeToError(ObjectOrErr.getError());
+    *AddStream(Task)->OS << (*ObjectOrErr)->getBuffer();
+    return Error::success();
+  }
+};
+} // end anonymous namespace
+
+ThinBackend
+lto::createOutOfProcessThinBackend(unsigned ParallelismLevel,
+                                   std::vector<std::string> WorkerArgs) {
+  assert(!WorkerArgs.empty() && "No worker program");
+  return [=](Config &Conf, ModuleSummaryIndex &CombinedIndex,
+             const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+             AddStreamFn AddStream, NativeObjectCache Cache) {
+    return llvm::make_unique<OutOfProcessThinBackend>(
+        Conf, CombinedIndex, ParallelismLevel, ModuleToDefinedGVSummaries,
+        AddStream, Cache, WorkerArgs);
+  };
+}
+
+Error lto::runThinBackendJob(Config &Conf, StringRef IndexPath,
+                             StringRef ModuleListPath, AddStreamFn AddStream) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> IndexBufferOrErr =
+      MemoryBuffer::getFile(IndexPath);
+  if (!IndexBufferOrErr)
+    return errorCodeToError(IndexBufferOrErr.getError());
+  Expected<std::unique_ptr<ModuleSummaryIndex>> IndexOrErr =
+      getModuleSummaryIndex(**IndexBufferOrErr);
+  if (!IndexOrErr)
+    return IndexOrErr.takeError();
+  ModuleSummaryIndex &Index = **IndexOrErr;
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> ListOrErr =
+      MemoryBuffer::getFile(ModuleListPath);
+  if (!ListOrErr)
+    return errorCodeToError(ListOrErr.getError());
+  SmallVector<StringRef, 16> Lines;
+  (*ListOrErr)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                  /*KeepEmpty=*/false);
+  if (Lines.empty() || Lines.size() % 2)
+    return make_error<StringError>(
+        Twine("malformed module list ") + ModuleListPath,
+        inconvertibleErrorCode());
+
+  // Read the modules under their identifiers, the ones the index refers to.
+  std::vector<std::unique_ptr<MemoryBuffer>> Buffers;
+  MapVector<StringRef, BitcodeModule> ModuleMap;
+  for (size_t I = 0; I != Lines.size(); I += 2) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+        MemoryBuffer::getFile(Lines[I + 1]);
+    if (!MBOrErr)
+      return errorCodeToError(MBOrErr.getError());
+    Buffers.push_back(std::move(*MBOrErr));
+    Expected<std::vector<BitcodeModule>> ModsOrErr = getBitcodeModuleList(
+        MemoryBufferRef(Buffers.back()->getBuffer(), Lines[I]));
+    if (!ModsOrErr)
+      return ModsOrErr.takeError();
+    if (ModsOrErr->size() != 1)
+      return make_error<StringError>(
+          Twine("expected one module in ") + Lines[I + 1],
+          inconvertibleErrorCode());
+    ModuleMap.insert({Lines[I], ModsOrErr->front()});
+  }
+  StringRef ModulePath = Lines[0];
+
+  // The index only holds the summaries of the module and of the values it
+  // imports, so every value defined elsewhere is imported.
+  FunctionImporter::ImportMapTy ImportList;
+  for (auto &GlobalList : Index)
+    for (auto &Summary : GlobalList.second.SummaryList)
+      if (Summary->modulePath() != ModulePath)
+        ImportList[Summary->modulePath()][GlobalList.first] = 1;
+
+  StringMap<GVSummaryMapTy> ModuleToDefinedGVSummaries;
+  Index.collectDefinedGVSummariesPerModule(ModuleToDefinedGVSummaries);
+
+  LTOLLVMContext BackendContext(Conf);
+  Expected<std::unique_ptr<Module>> MOrErr =
+      ModuleMap.front().second.parseModule(BackendContext);
+  if (!MOrErr)
+    return MOrErr.takeError();
+  return thinBackend(Conf, /*Task=*/0, AddStream, **MOrErr, Index, ImportList,
+                     ModuleToDefinedGVSummaries[ModulePath], ModuleMap);
+}
+
 // Given the original \p Path to an output file, replace any path
 // prefix matching \p OldPrefix with \p NewPrefix. Also, create the
 // resulting directory if it does not yet exist.
@@ -1092,8 +1555,14 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
   StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>> ResolvedODR;
 
   if (Conf.OptLevel > 0) {
-    ComputeCrossModuleImport(ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
-                             ImportLists, ExportLists);
+    {
+      NamedRegionTimer T("import", "Compute cross-module imports",
+                         ThinLinkTimerGroupName, ThinLinkTimerGroupDescription,
+                         Conf.TimeThinLink);
+      ComputeCrossModuleImport(ThinLTO.CombinedIndex,
+                               ModuleToDefinedGVSummaries, ImportLists,
+                               ExportLists, Conf.ThinLinkThreads);
+    }
 
     std::set<GlobalValue::GUID> ExportedGUIDs;
     for (auto &Res : GlobalResolutions) {
@@ -1124,20 +1593,30 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
               ExportList->second.count(GUID)) ||
              ExportedGUIDs.count(GUID);
     };
-    thinLTOInternalizeAndPromoteInIndex(ThinLTO.CombinedIndex, isExported);
+    NamedRegionTimer T("promote", "Internalize and promote",
+                       ThinLinkTimerGroupName, ThinLinkTimerGroupDescription,
+                       Conf.TimeThinLink);
+    thinLTOInternalizeAndPromoteInIndex(ThinLTO.CombinedIndex, isExported,
+                                        Conf.ThinLinkThreads);
   }
 
+  // Called concurrently, so the map must not be updated.
   auto isPrevailing = [&](GlobalValue::GUID GUID,
                           const GlobalValueSummary *S) {
-    return ThinLTO.PrevailingModuleForGUID[GUID] == S->modulePath();
+    return ThinLTO.PrevailingModuleForGUID.lookup(GUID) == S->modulePath();
   };
   auto recordNewLinkage = [&](StringRef ModuleIdentifier,
                               GlobalValue::GUID GUID,
                               GlobalValue::LinkageTypes NewLinkage) {
     ResolvedODR[ModuleIdentifier][GUID] = NewLinkage;
   };
-  thinLTOResolveWeakForLinkerInIndex(ThinLTO.CombinedIndex, isPrevailing,
-                                     recordNewLinkage);
+  {
+    NamedRegionTimer T("resolve-weak", "Resolve weak for linker",
+                       ThinLinkTimerGroupName, ThinLinkTimerGroupDescription,
+                       Conf.TimeThinLink);
+    thinLTOResolveWeakForLinkerInIndex(ThinLTO.CombinedIndex, isPrevailing,
+                                       recordNewLinkage, Conf.ThinLinkThreads);
+  }
 
   std::unique_ptr<ThinBackendProc> BackendProc =
       ThinLTO.Backend(Conf, ThinLTO.CombinedIndex, ModuleToDefinedGVSummaries,
@@ -325,7 +325,7 @@ void splitCodeGen(Config &C, TargetMachine *TM, AddStreamFn AddStream,
             // copied into the thread's context.
             std::move(BC), ThreadCount++);
       },
-      false);
+      false, C.CodeGenPartitioning);
 
   // Because the inner lambda (which runs in a worker thread) captures our local
   // variables, we need to wait for the worker threads to terminate before we
@@ -397,7 +397,8 @@ Error lto::thinBackend(Config &Conf, unsigned Task, AddStreamFn AddStream,
                        Module &Mod, const ModuleSummaryIndex &CombinedIndex,
                        const FunctionImporter::ImportMapTy &ImportList,
                        const GVSummaryMapTy &DefinedGlobals,
-                       MapVector<StringRef, BitcodeModule> &ModuleMap) {
+                       MapVector<StringRef, BitcodeModule> &ModuleMap,
+                       BitcodeLazyLoadCache *LazyLoadCache) {
   Expected<const Target *> TOrErr = initAndLookupTarget(Conf, Mod);
   if (!TOrErr)
     return TOrErr.takeError();
@@ -433,7 +434,7 @@ Error lto::thinBackend(Config &Conf, unsigned Task, AddStreamFn AddStream,
     assert(I != ModuleMap.end());
     return I->second.getLazyModule(Mod.getContext(),
                                    /*ShouldLazyLoadMetadata=*/true,
-                                   /*IsImporting*/ true);
+                                   /*IsImporting*/ true, LazyLoadCache);
   };
 
   FunctionImporter Importer(CombinedIndex, ModuleLoader);
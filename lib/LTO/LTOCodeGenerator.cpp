@@ -589,9 +589,9 @@ bool LTOCodeGenerator::compileOptimized(ArrayRef<raw_pwrite_stream *> Out) {
   // parallelism level 1. This is achieved by having splitCodeGen return the
   // original module at parallelism level 1 which we then assign back to
   // MergedModule.
-  MergedModule = splitCodeGen(std::move(MergedModule), Out, {},
-                              [&]() { return createTargetMachine(); }, FileType,
-                              ShouldRestoreGlobalsLinkage);
+  MergedModule = splitCodeGen(
+      std::move(MergedModule), Out, {}, [&]() { return createTargetMachine(); },
+      FileType, ShouldRestoreGlobalsLinkage, CodeGenPartitioning);
 
   // If statistics were requested, print them out after codegen.
   if (llvm::AreStatisticsEnabled())
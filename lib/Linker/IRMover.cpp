@@ -222,6 +222,12 @@ void TypeMapTy::finishType(StructType *DTy, StructType *STy,
 }
 
 Type *TypeMapTy::get(Type *Ty) {
+  // Every type in a linked function body is looked up here, and nearly all of
+  // them have been mapped already.  Avoid setting up a visited set for those.
+  auto I = MappedTypes.find(Ty);
+  if (I != MappedTypes.end() && I->second)
+    return I->second;
+
   SmallPtrSet<StructType *, 8> Visited;
   return get(Ty, Visited);
 }
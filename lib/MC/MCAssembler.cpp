@@ -9,6 +9,7 @@
 
 #include "llvm/MC/MCAssembler.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
@@ -37,6 +38,7 @@
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -68,6 +70,8 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(SkippedRelaxationChecks,
+          "Number of relaxable fragments not rechecked in a layout step");
 
 } // end namespace stats
 } // end anonymous namespace
@@ -680,17 +684,22 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
   }
 
   // Assign layout order indices to sections and fragments.
+  std::vector<SectionRelaxState> RelaxStates(Layout.getSectionOrder().size());
   for (unsigned i = 0, e = Layout.getSectionOrder().size(); i != e; ++i) {
     MCSection *Sec = Layout.getSectionOrder()[i];
     Sec->setLayoutOrder(i);
 
     unsigned FragmentIndex = 0;
-    for (MCFragment &Frag : *Sec)
+    for (MCFragment &Frag : *Sec) {
+      if (isa<MCAlignFragment>(Frag) || isa<MCOrgFragment>(Frag))
+        RelaxStates[i].OffsetDependent.push_back(FragmentIndex);
       Frag.setLayoutOrder(FragmentIndex++);
+    }
+    RelaxStates[i].LastChecked.resize(FragmentIndex);
   }
 
   // Layout until everything fits.
-  while (layoutOnce(Layout))
+  while (layoutOnce(Layout, RelaxStates))
     if (getContext().hadError())
       return;
 
@@ -885,13 +894,88 @@ bool MCAssembler::relaxCVDefRange(MCAsmLayout &Layout,
   return OldSize != F.getContents().size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
+/// Return the layout order of the fragment a PC-relative fixup of a fragment
+/// in \p Sec is resolved against, or None if its value may depend on anything
+/// but the sizes of the fragments between the two.
+static Optional<unsigned> getFixupTargetOrder(const MCAsmBackend &Backend,
+                                              const MCFixup &Fixup,
+                                              const MCSection &Sec) {
+  const MCFixupKindInfo &Info = Backend.getFixupKindInfo(Fixup.getKind());
+  if (!(Info.Flags & MCFixupKindInfo::FKF_IsPCRel) ||
+      (Info.Flags & MCFixupKindInfo::FKF_IsAlignedDownTo32Bits))
+    return None;
+
+  const MCExpr *Expr = Fixup.getValue();
+  if (const auto *BE = dyn_cast<MCBinaryExpr>(Expr))
+    if (BE->getOpcode() == MCBinaryExpr::Add &&
+        isa<MCConstantExpr>(BE->getRHS()))
+      Expr = BE->getLHS();
+  const auto *Ref = dyn_cast<MCSymbolRefExpr>(Expr);
+  if (!Ref || Ref->getKind() != MCSymbolRefExpr::VK_None)
+    return None;
+
+  const MCSymbol &Sym = Ref->getSymbol();
+  if (Sym.isVariable() || !Sym.getFragment() ||
+      Sym.getFragment()->getParent() != &Sec)
+    return None;
+  return Sym.getFragment()->getLayoutOrder();
+}
+
+bool MCAssembler::isRelaxationUnchanged(
+    const MCRelaxableFragment &F, const SectionRelaxState &RelaxState) const {
+  unsigned Order = F.getLayoutOrder();
+  if (!RelaxState.LastChecked[Order])
+    return false;
+
+  // With bundling, the padding of any fragment depends on its offset.
+  if (isBundlingEnabled())
+    return false;
+
+  // The value of a PC-relative fixup changes only with the size of the
+  // fragments between the fixup and its target, and of the fragment itself.
+  unsigned Lo = Order, Hi = Order;
+  for (const MCFixup &Fixup : F.getFixups()) {
+    Optional<unsigned> Target =
+        getFixupTargetOrder(getBackend(), Fixup, *F.getParent());
+    if (!Target)
+      return false;
+    Lo = std::min(Lo, *Target);
+    Hi = std::max(Hi, *Target);
+  }
+
+  // Check the iterations since the last check, including the current one.
+  const std::vector<unsigned> &OffsetDependent = RelaxState.OffsetDependent;
+  for (unsigned I = RelaxState.LastChecked[Order] - 1,
+                E = RelaxState.Changed.size();
+       I != E; ++I) {
+    unsigned First = RelaxState.Changed[I].first;
+    unsigned Last = RelaxState.Changed[I].second;
+    if (First > Last)
+      continue;
+    if (First <= Hi && Last >= Lo)
+      return false;
+    // Alignment and org fragments after a size change may change size too.
+    auto It = std::lower_bound(OffsetDependent.begin(), OffsetDependent.end(),
+                               std::max(Lo, First));
+    if (It != OffsetDependent.end() && *It <= Hi)
+      return false;
+  }
+  return true;
+}
+
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec,
+                                    SectionRelaxState &RelaxState) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = nullptr;
 
+  // Record the fragments that change size in this iteration, so that the next
+  // ones only recheck the relaxable fragments whose fixups they may affect.
+  unsigned Iteration = RelaxState.Changed.size();
+  RelaxState.Changed.push_back({~0u, 0});
+
   // Attempt to relax all the fragments in the section.
   for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
     // Check if this is a fragment that needs relaxation.
@@ -899,11 +983,18 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
     switch(I->getKind()) {
     default:
       break;
-    case MCFragment::FT_Relaxable:
+    case MCFragment::FT_Relaxable: {
       assert(!getRelaxAll() &&
              "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
+      auto &RF = *cast<MCRelaxableFragment>(I);
+      if (isRelaxationUnchanged(RF, RelaxState)) {
+        ++stats::SkippedRelaxationChecks;
+        break;
+      }
+      RelaxState.LastChecked[RF.getLayoutOrder()] = Iteration + 1;
+      RelaxedFrag = relaxInstruction(Layout, RF);
       break;
+    }
     case MCFragment::FT_Dwarf:
       RelaxedFrag = relaxDwarfLineAddr(Layout,
                                        *cast<MCDwarfLineAddrFragment>(I));
@@ -926,6 +1017,11 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
     }
     if (RelaxedFrag && !FirstRelaxedFragment)
       FirstRelaxedFragment = &*I;
+    if (RelaxedFrag) {
+      auto &Changed = RelaxState.Changed[Iteration];
+      Changed.first = std::min(Changed.first, I->getLayoutOrder());
+      Changed.second = std::max(Changed.second, I->getLayoutOrder());
+    }
   }
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
@@ -934,13 +1030,14 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
   return false;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             MutableArrayRef<SectionRelaxState> RelaxStates) {
   ++stats::RelaxationSteps;
 
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
     MCSection &Sec = *it;
-    while (layoutSectionOnce(Layout, Sec))
+    while (layoutSectionOnce(Layout, Sec, RelaxStates[Sec.getLayoutOrder()]))
       WasRelaxed = true;
   }
 
@@ -13,10 +13,15 @@
 
 #include "llvm/Support/CachePruning.h"
 
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Chrono.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -24,9 +29,24 @@
 
 #include <set>
 #include <system_error>
+#include <vector>
 
 using namespace llvm;
 
+/// Name of the index of cache accesses, relative to the cache directory. It
+/// does not match "llvmcache-*" so that pruning never removes it.
+static const char IndexFileName[] = "llvmcache.index";
+static const char IndexHeader[] = "llvmcache-index v1";
+
+namespace {
+/// A file considered for pruning.
+struct CacheEntryInfo {
+  std::string Path;
+  uint64_t Size = 0;
+  sys::TimePoint<> LastAccess;
+};
+} // end anonymous namespace
+
 /// Write a new timestamp file with the given path. This is used for the pruning
 /// interval option.
 static void writeTimestampFile(StringRef TimestampFile) {
@@ -113,6 +133,15 @@ llvm::parseCachePruningPolicy(StringRef PolicyStr) {
         return make_error<StringError>("'" + Value + "' not an integer",
                                        inconvertibleErrorCode());
       Policy.MaxSizeBytes = Size * Mult;
+    } else if (Key == "use_index") {
+      if (Value == "true")
+        Policy.UseIndex = true;
+      else if (Value == "false")
+        Policy.UseIndex = false;
+      else
+        return make_error<StringError>("'" + Value +
+                                           "' must be 'true' or 'false'",
+                                       inconvertibleErrorCode());
     } else {
       return make_error<StringError>("Unknown key: '" + Key + "'",
                                      inconvertibleErrorCode());
@@ -122,6 +151,181 @@ llvm::parseCachePruningPolicy(StringRef PolicyStr) {
   return Policy;
 }
 
+/// Collect every file of the cache directory that may be pruned.
+static void scanCacheDirectory(StringRef Path,
+                               std::vector<CacheEntryInfo> &Entries) {
+  // Walk the entire directory cache, looking for unused files.
+  std::error_code EC;
+  SmallString<128> CachePathNative;
+  sys::path::native(Path, CachePathNative);
+  // Walk all of the files within this directory.
+  for (sys::fs::directory_iterator File(CachePathNative, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC)) {
+    // Ignore any files not beginning with the string "llvmcache-". This
+    // includes the timestamp file as well as any files created by the user.
+    // This acts as a safeguard against data loss if the user specifies the
+    // wrong directory as their cache directory.
+    if (!sys::path::filename(File->path()).startswith("llvmcache-"))
+      continue;
+
+    // Look at this file. If we can't stat it, there's nothing interesting
+    // there.
+    sys::fs::file_status FileStatus;
+    if (sys::fs::status(File->path(), FileStatus)) {
+      DEBUG(dbgs() << "Ignore " << File->path() << " (can't stat)\n");
+      continue;
+    }
+
+    CacheEntryInfo Entry;
+    Entry.Path = File->path();
+    Entry.Size = FileStatus.getSize();
+    Entry.LastAccess = FileStatus.getLastAccessedTime();
+    Entries.push_back(std::move(Entry));
+  }
+}
+
+/// Return true if Name may appear in the index, i.e. if it names a file
+/// directly inside the cache directory that pruning is allowed to remove.
+static bool isValidIndexName(StringRef Name) {
+  return Name.startswith("llvmcache-") &&
+         Name.find_first_of("/\\") == StringRef::npos && Name != "." &&
+         Name != "..";
+}
+
+/// Read the index at IndexFile into Entries, one entry per file with its most
+/// recent recorded access. IndexSize is set to the number of bytes read and
+/// ScanTime to the time of the full scan the index was built from. Returns
+/// false if the index is missing or corrupt, or if the last full scan
+/// of the directory is older than RescanAfter.
+static bool readIndex(StringRef IndexFile, std::vector<CacheEntryInfo> &Entries,
+                      uint64_t &IndexSize, uint64_t &ScanTime,
+                      sys::TimePoint<> CurrentTime,
+                      std::chrono::seconds RescanAfter) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(IndexFile, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false,
+                            /*IsVolatile=*/true);
+  if (!BufOrErr)
+    return false;
+  StringRef Buf = (*BufOrErr)->getBuffer();
+  // Records are appended concurrently, so ignore a trailing partial line; it
+  // is carried over when the index is rewritten.
+  size_t End = Buf.rfind('\n');
+  if (End == StringRef::npos)
+    return false;
+  Buf = Buf.take_front(End + 1);
+  IndexSize = Buf.size();
+
+  StringRef Line;
+  std::tie(Line, Buf) = Buf.split('\n');
+  if (!Line.consume_front(IndexHeader) || !Line.consume_front(" "))
+    return false;
+  if (Line.getAsInteger(10, ScanTime))
+    return false;
+  if (RescanAfter != std::chrono::seconds(0) &&
+      CurrentTime - sys::toTimePoint(ScanTime) > RescanAfter)
+    return false;
+
+  StringRef CacheDir = sys::path::parent_path(IndexFile);
+  StringMap<CacheEntryInfo> ByName;
+  while (!Buf.empty()) {
+    std::tie(Line, Buf) = Buf.split('\n');
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, ' ');
+    uint64_t Size, Time;
+    if (Fields.size() != 3 || !isValidIndexName(Fields[0]) ||
+        Fields[1].getAsInteger(10, Size) || Fields[2].getAsInteger(10, Time))
+      return false;
+
+    auto Inserted = ByName.insert(std::make_pair(Fields[0], CacheEntryInfo()));
+    CacheEntryInfo &Entry = Inserted.first->second;
+    if (Inserted.second) {
+      SmallString<128> EntryPath(CacheDir);
+      sys::path::append(EntryPath, Fields[0]);
+      Entry.Path = EntryPath.str();
+    }
+    // The latest record has the current size; the accesses themselves may be
+    // recorded out of order by concurrent clients.
+    Entry.Size = Size;
+    Entry.LastAccess =
+        std::max<sys::TimePoint<>>(Entry.LastAccess, sys::toTimePoint(Time));
+  }
+
+  for (auto &I : ByName)
+    Entries.push_back(std::move(I.second));
+  return true;
+}
+
+static void writeIndexRecord(raw_ostream &OS, StringRef EntryPath,
+                             uint64_t Size, sys::TimePoint<> Time) {
+  OS << sys::path::filename(EntryPath) << ' ' << Size << ' '
+     << uint64_t(sys::toTimeT(Time)) << '\n';
+}
+
+/// Replace the index at IndexFile with the entries in Entries that were not
+/// pruned. Records appended past OldIndexSize since the index was read are
+/// kept. ScanTime is the time of the full scan the entries come from.
+static void writeIndex(StringRef CacheDir, StringRef IndexFile,
+                       ArrayRef<CacheEntryInfo> Entries, uint64_t OldIndexSize,
+                       uint64_t ScanTime) {
+  int TempFD;
+  SmallString<128> TempPath;
+  SmallString<128> Model(CacheDir);
+  sys::path::append(Model, "llvmcache.index.tmp-%%%%%%");
+  if (sys::fs::createUniqueFile(Model, TempFD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(TempFD, /*shouldClose=*/true);
+    OS << IndexHeader << ' ' << ScanTime << '\n';
+    for (const CacheEntryInfo &Entry : Entries)
+      if (!Entry.Path.empty())
+        writeIndexRecord(OS, Entry.Path, Entry.Size, Entry.LastAccess);
+
+    // Carry over the accesses recorded while we were pruning.
+    if (OldIndexSize) {
+      ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+          MemoryBuffer::getFile(IndexFile, /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false,
+                                /*IsVolatile=*/true);
+      if (BufOrErr && (*BufOrErr)->getBufferSize() > OldIndexSize)
+        OS << (*BufOrErr)->getBuffer().drop_front(OldIndexSize);
+    }
+
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(TempPath, IndexFile))
+    sys::fs::remove(TempPath);
+}
+
+void llvm::recordCacheAccess(StringRef CacheDir, StringRef EntryPath,
+                             uint64_t Size) {
+  SmallString<128> IndexFile(CacheDir);
+  sys::path::append(IndexFile, IndexFileName);
+  // Only caches pruned with an index have one; never create it here.
+  if (!sys::fs::exists(IndexFile))
+    return;
+
+  // Format the record up front so that it is appended with a single write,
+  // which keeps records from concurrent clients from interleaving.
+  SmallString<128> Record;
+  raw_svector_ostream RecordOS(Record);
+  writeIndexRecord(RecordOS, EntryPath, Size, std::chrono::system_clock::now());
+
+  int FD;
+  if (sys::fs::openFileForWrite(IndexFile, FD, sys::fs::F_Append))
+    return;
+  raw_fd_ostream OS(FD, /*shouldClose=*/true, /*unbuffered=*/true);
+  OS << Record;
+  OS.close();
+  if (OS.has_error())
+    OS.clear_error();
+}
+
 /// Prune the cache of files that haven't been accessed in a long time.
 bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
   using namespace std::chrono;
@@ -182,57 +386,64 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
   bool ShouldComputeSize =
       (Policy.MaxSizePercentageOfAvailableSpace > 0 || Policy.MaxSizeBytes > 0);
 
-  // Keep track of space
-  std::set<std::pair<uint64_t, std::string>> FileSizes;
-  uint64_t TotalSize = 0;
-  // Helper to add a path to the set of files to consider for size-based
-  // pruning, sorted by size.
-  auto AddToFileListForSizePruning =
-      [&](StringRef Path) {
-        if (!ShouldComputeSize)
-          return;
-        TotalSize += FileStatus.getSize();
-        FileSizes.insert(
-            std::make_pair(FileStatus.getSize(), std::string(Path)));
-      };
-
-  // Walk the entire directory cache, looking for unused files.
-  std::error_code EC;
-  SmallString<128> CachePathNative;
-  sys::path::native(Path, CachePathNative);
-  // Walk all of the files within this directory.
-  for (sys::fs::directory_iterator File(CachePathNative, EC), FileEnd;
-       File != FileEnd && !EC; File.increment(EC)) {
-    // Ignore any files not beginning with the string "llvmcache-". This
-    // includes the timestamp file as well as any files created by the user.
-    // This acts as a safeguard against data loss if the user specifies the
-    // wrong directory as their cache directory.
-    if (!sys::path::filename(File->path()).startswith("llvmcache-"))
-      continue;
-
-    // Look at this file. If we can't stat it, there's nothing interesting
-    // there.
-    if (sys::fs::status(File->path(), FileStatus)) {
-      DEBUG(dbgs() << "Ignore " << File->path() << " (can't stat)\n");
-      continue;
+  // Only one process maintains the index at a time. If someone else is already
+  // pruning with it, leave the work to them.
+  SmallString<128> IndexFile(Path);
+  sys::path::append(IndexFile, IndexFileName);
+  Optional<LockFileManager> IndexLock;
+  if (Policy.UseIndex) {
+    IndexLock.emplace(IndexFile);
+    switch (IndexLock->getState()) {
+    case LockFileManager::LFS_Owned:
+      break;
+    case LockFileManager::LFS_Shared:
+      return false;
+    case LockFileManager::LFS_Error:
+      // Prune without maintaining the index.
+      DEBUG(dbgs() << "Can't lock the index, ignore it\n");
+      Policy.UseIndex = false;
+      break;
     }
+  }
+
+  std::vector<CacheEntryInfo> Entries;
+  uint64_t IndexSize = 0;
+  uint64_t ScanTime = 0;
+  bool FromIndex = Policy.UseIndex &&
+                   readIndex(IndexFile, Entries, IndexSize, ScanTime,
+                             CurrentTime, Policy.Expiration);
+  if (!FromIndex) {
+    DEBUG(if (Policy.UseIndex) dbgs()
+          << "Index missing, corrupt or stale, scan the cache directory\n");
+    Entries.clear();
+    IndexSize = 0;
+    ScanTime = sys::toTimeT(CurrentTime);
+    scanCacheDirectory(Path, Entries);
+  }
 
-    // If the file hasn't been used recently enough, delete it
-    const auto FileAccessTime = FileStatus.getLastAccessedTime();
-    auto FileAge = CurrentTime - FileAccessTime;
+  // Remove the files that haven't been used recently enough.
+  std::vector<CacheEntryInfo> Live;
+  for (CacheEntryInfo &Entry : Entries) {
+    auto FileAge = CurrentTime - Entry.LastAccess;
     if (FileAge > Policy.Expiration) {
-      DEBUG(dbgs() << "Remove " << File->path() << " ("
+      DEBUG(dbgs() << "Remove " << Entry.Path << " ("
                    << duration_cast<seconds>(FileAge).count() << "s old)\n");
-      sys::fs::remove(File->path());
+      sys::fs::remove(Entry.Path);
       continue;
     }
-
-    // Leave it here for now, but add it to the list of size-based pruning.
-    AddToFileListForSizePruning(File->path());
+    Live.push_back(std::move(Entry));
   }
 
   // Prune for size now if needed
   if (ShouldComputeSize) {
+    // Keep track of space
+    std::set<std::pair<uint64_t, size_t>> FileSizes;
+    uint64_t TotalSize = 0;
+    for (size_t I = 0, E = Live.size(); I != E; ++I) {
+      TotalSize += Live[I].Size;
+      FileSizes.insert(std::make_pair(Live[I].Size, I));
+    }
+
     auto ErrOrSpaceInfo = sys::fs::disk_space(Path);
     if (!ErrOrSpaceInfo) {
       report_fatal_error("Can't get available size");
@@ -255,15 +466,21 @@ bool llvm::pruneCache(StringRef Path, CachePruningPolicy Policy) {
     auto FileAndSize = FileSizes.rbegin();
     // Remove the oldest accessed files first, till we get below the threshold
     while (TotalSize > TotalSizeTarget && FileAndSize != FileSizes.rend()) {
+      CacheEntryInfo &Entry = Live[FileAndSize->second];
       // Remove the file.
-      sys::fs::remove(FileAndSize->second);
+      sys::fs::remove(Entry.Path);
       // Update size
       TotalSize -= FileAndSize->first;
-      DEBUG(dbgs() << " - Remove " << FileAndSize->second << " (size "
+      DEBUG(dbgs() << " - Remove " << Entry.Path << " (size "
                    << FileAndSize->first << "), new occupancy is " << TotalSize
                    << "%\n");
+      // Keep it out of the index.
+      Entry.Path.clear();
       ++FileAndSize;
     }
   }
+
+  if (Policy.UseIndex)
+    writeIndex(Path, IndexFile, Live, IndexSize, ScanTime);
   return true;
 }
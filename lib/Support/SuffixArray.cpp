@@ -0,0 +1,213 @@
+//===-- SuffixArray.cpp - Suffix and LCP arrays of integer strings --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/SuffixArray.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace llvm;
+
+static const unsigned Empty = ~0u;
+
+/// Build the suffix array of \p S, whose characters are in [0, Upper].
+///
+/// Suffixes are S-type if they are smaller than the suffix following them and
+/// L-type otherwise, and an S-type suffix following an L-type one is a
+/// left-most S-type (LMS) suffix. Sorting the LMS suffixes is enough to sort
+/// all the suffixes by induction, and the LMS substrings are sorted by a first
+/// induction, named, and their order refined by sorting the string of names
+/// recursively. The string is at most half as long at each level.
+static std::vector<unsigned> suffixArrayIS(ArrayRef<unsigned> S,
+                                           unsigned Upper) {
+  unsigned N = S.size();
+  if (N == 0)
+    return {};
+  if (N == 1)
+    return {0};
+  if (N == 2)
+    return S[0] < S[1] ? std::vector<unsigned>{0, 1}
+                       : std::vector<unsigned>{1, 0};
+
+  std::vector<unsigned> SA(N);
+  std::vector<bool> IsS(N);
+  for (unsigned I = N - 1; I-- > 0;)
+    IsS[I] = S[I] == S[I + 1] ? IsS[I + 1] : S[I] < S[I + 1];
+
+  // Buckets of each character hold its L-type suffixes, then its S-type ones.
+  // BucketL[C] and BucketS[C] are where they start.
+  std::vector<unsigned> BucketL(Upper + 2), BucketS(Upper + 2);
+  for (unsigned I = 0; I != N; ++I) {
+    if (!IsS[I])
+      ++BucketS[S[I]];
+    else
+      ++BucketL[S[I] + 1];
+  }
+  for (unsigned C = 0; C <= Upper; ++C) {
+    BucketS[C] += BucketL[C];
+    BucketL[C + 1] += BucketS[C];
+  }
+
+  // Place the LMS suffixes at the start of their S buckets in the given order,
+  // then induce the L-type suffixes left to right and the S-type suffixes
+  // right to left.
+  std::vector<unsigned> Bucket(Upper + 2);
+  auto Induce = [&](ArrayRef<unsigned> LMS) {
+    std::fill(SA.begin(), SA.end(), Empty);
+    std::copy(BucketS.begin(), BucketS.end(), Bucket.begin());
+    for (unsigned I : LMS)
+      SA[Bucket[S[I]]++] = I;
+    std::copy(BucketL.begin(), BucketL.end(), Bucket.begin());
+    SA[Bucket[S[N - 1]]++] = N - 1;
+    for (unsigned I = 0; I != N; ++I) {
+      unsigned V = SA[I];
+      if (V != Empty && V >= 1 && !IsS[V - 1])
+        SA[Bucket[S[V - 1]]++] = V - 1;
+    }
+    std::copy(BucketL.begin(), BucketL.end(), Bucket.begin());
+    for (unsigned I = N; I-- > 0;) {
+      unsigned V = SA[I];
+      if (V != Empty && V >= 1 && IsS[V - 1])
+        SA[--Bucket[S[V - 1] + 1]] = V - 1;
+    }
+  };
+
+  std::vector<unsigned> LMSIndex(N, Empty);
+  std::vector<unsigned> LMS;
+  for (unsigned I = 1; I != N; ++I)
+    if (!IsS[I - 1] && IsS[I]) {
+      LMSIndex[I] = LMS.size();
+      LMS.push_back(I);
+    }
+  unsigned M = LMS.size();
+
+  Induce(LMS);
+  if (M == 0)
+    return SA;
+
+  // Name the LMS substrings in sorted order, equal substrings getting equal
+  // names.
+  std::vector<unsigned> SortedLMS;
+  SortedLMS.reserve(M);
+  for (unsigned V : SA)
+    if (LMSIndex[V] != Empty)
+      SortedLMS.push_back(V);
+  std::vector<unsigned> Names(M);
+  unsigned Name = 0;
+  Names[LMSIndex[SortedLMS[0]]] = 0;
+  for (unsigned I = 1; I != M; ++I) {
+    unsigned L = SortedLMS[I - 1], R = SortedLMS[I];
+    unsigned EndL = LMSIndex[L] + 1 < M ? LMS[LMSIndex[L] + 1] : N;
+    unsigned EndR = LMSIndex[R] + 1 < M ? LMS[LMSIndex[R] + 1] : N;
+    bool Same = EndL - L == EndR - R;
+    if (Same) {
+      while (L < EndL && S[L] == S[R]) {
+        ++L;
+        ++R;
+      }
+      if (L == N || S[L] != S[R])
+        Same = false;
+    }
+    if (!Same)
+      ++Name;
+    Names[LMSIndex[SortedLMS[I]]] = Name;
+  }
+
+  // Sort the LMS suffixes by the suffix array of the names, and induce the
+  // final order from them.
+  std::vector<unsigned> NamesSA = suffixArrayIS(Names, Name);
+  for (unsigned I = 0; I != M; ++I)
+    SortedLMS[I] = LMS[NamesSA[I]];
+  Induce(SortedLMS);
+  return SA;
+}
+
+std::vector<unsigned> llvm::buildSuffixArray(ArrayRef<unsigned> Str) {
+  // Number the characters densely, in the same order.
+  std::vector<unsigned> Alphabet(Str.begin(), Str.end());
+  std::sort(Alphabet.begin(), Alphabet.end());
+  Alphabet.erase(std::unique(Alphabet.begin(), Alphabet.end()),
+                 Alphabet.end());
+  std::vector<unsigned> S;
+  S.reserve(Str.size());
+  for (unsigned C : Str)
+    S.push_back(std::lower_bound(Alphabet.begin(), Alphabet.end(), C) -
+                Alphabet.begin());
+  return suffixArrayIS(S, Alphabet.empty() ? 0 : Alphabet.size() - 1);
+}
+
+std::vector<unsigned> llvm::buildLCPArray(ArrayRef<unsigned> Str,
+                                          ArrayRef<unsigned> SA) {
+  unsigned N = Str.size();
+  assert(SA.size() == N && "Suffix array of another string");
+  std::vector<unsigned> Rank(N);
+  for (unsigned I = 0; I != N; ++I)
+    Rank[SA[I]] = I;
+
+  // The common prefix of a suffix with its predecessor in the suffix array is
+  // at most one shorter than the previous suffix's in the string.
+  std::vector<unsigned> LCP(N);
+  unsigned H = 0;
+  for (unsigned I = 0; I != N; ++I) {
+    if (Rank[I] == 0) {
+      H = 0;
+      continue;
+    }
+    unsigned J = SA[Rank[I] - 1];
+    while (I + H < N && J + H < N && Str[I + H] == Str[J + H])
+      ++H;
+    LCP[Rank[I]] = H;
+    if (H)
+      --H;
+  }
+  return LCP;
+}
+
+std::vector<RepeatedSubstring>
+llvm::findRepeatedSubstrings(ArrayRef<unsigned> Str, unsigned MinLength) {
+  std::vector<unsigned> SA = buildSuffixArray(Str);
+  std::vector<unsigned> LCP = buildLCPArray(Str, SA);
+  unsigned N = Str.size();
+
+  // Walk the LCP intervals bottom-up: an interval of suffixes sharing a
+  // prefix of length Length is an internal node of the suffix tree, and the
+  // suffixes whose longest common prefix with their neighbours is Length are
+  // its leaf children. The stack holds the open intervals by increasing
+  // length, starting with the root.
+  std::vector<RepeatedSubstring> Result;
+  std::vector<RepeatedSubstring> Stack;
+  Stack.push_back({0, {}});
+  for (unsigned I = 1; I <= N; ++I) {
+    unsigned Length = I < N ? LCP[I] : 0;
+    // The suffix before the boundary is a leaf of the deeper of the intervals
+    // ending or starting here.
+    unsigned Leaf = SA[I - 1];
+    bool LeafAdded = Length <= Stack.back().Length;
+    if (LeafAdded)
+      Stack.back().StartIndices.push_back(Leaf);
+    while (Length < Stack.back().Length) {
+      RepeatedSubstring RS = std::move(Stack.back());
+      Stack.pop_back();
+      if (RS.Length >= MinLength && RS.StartIndices.size() >= 2) {
+        std::sort(RS.StartIndices.begin(), RS.StartIndices.end());
+        Result.push_back(std::move(RS));
+      }
+    }
+    if (Length > Stack.back().Length) {
+      Stack.push_back({Length, {}});
+      if (!LeafAdded)
+        Stack.back().StartIndices.push_back(Leaf);
+    }
+  }
+
+  std::sort(Result.begin(), Result.end(),
+            [](const RepeatedSubstring &A, const RepeatedSubstring &B) {
+              return A.StartIndices[0] < B.StartIndices[0];
+            });
+  return Result;
+}
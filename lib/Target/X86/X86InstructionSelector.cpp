@@ -70,6 +70,8 @@ private:
                    MachineFunction &MF) const;
   bool selectZext(MachineInstr &I, MachineRegisterInfo &MRI,
                   MachineFunction &MF) const;
+  bool selectAnyext(MachineInstr &I, MachineRegisterInfo &MRI,
+                    MachineFunction &MF) const;
   bool selectCmp(MachineInstr &I, MachineRegisterInfo &MRI,
                  MachineFunction &MF) const;
   bool selectUadde(MachineInstr &I, MachineRegisterInfo &MRI,
@@ -86,6 +88,9 @@ private:
   bool selectCondBranch(MachineInstr &I, MachineRegisterInfo &MRI,
                         MachineFunction &MF) const;
   bool selectImplicitDef(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectPhi(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectShift(MachineInstr &I, MachineRegisterInfo &MRI,
+                   MachineFunction &MF) const;
 
   // emit insert subreg instruction and insert it before MachineInstr &I
   bool emitInsertSubreg(unsigned DstReg, unsigned SrcReg, MachineInstr &I,
@@ -321,6 +326,8 @@ bool X86InstructionSelector::select(MachineInstr &I) const {
     return true;
   if (selectZext(I, MRI, MF))
     return true;
+  if (selectAnyext(I, MRI, MF))
+    return true;
   if (selectCmp(I, MRI, MF))
     return true;
   if (selectUadde(I, MRI, MF))
@@ -337,6 +344,10 @@ bool X86InstructionSelector::select(MachineInstr &I) const {
     return true;
   if (selectImplicitDef(I, MRI))
     return true;
+  if (selectPhi(I, MRI))
+    return true;
+  if (selectShift(I, MRI, MF))
+    return true;
 
   return false;
 }
@@ -723,6 +734,39 @@ bool X86InstructionSelector::selectZext(MachineInstr &I,
   return true;
 }
 
+bool X86InstructionSelector::selectAnyext(MachineInstr &I,
+                                          MachineRegisterInfo &MRI,
+                                          MachineFunction &MF) const {
+  if (I.getOpcode() != TargetOpcode::G_ANYEXT)
+    return false;
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned SrcReg = I.getOperand(1).getReg();
+
+  const LLT DstTy = MRI.getType(DstReg);
+  const LLT SrcTy = MRI.getType(SrcReg);
+
+  // Only the extensions of s1 to s8 made by widening are supported. Both live
+  // in GR8, so the extension is a copy.
+  if (SrcTy != LLT::scalar(1) || DstTy != LLT::scalar(8))
+    return false;
+
+  const RegisterBank &DstRB = *RBI.getRegBank(DstReg, MRI, TRI);
+  const RegisterBank &SrcRB = *RBI.getRegBank(SrcReg, MRI, TRI);
+  if (DstRB.getID() != X86::GPRRegBankID ||
+      SrcRB.getID() != X86::GPRRegBankID)
+    return false;
+
+  if (!RBI.constrainGenericRegister(SrcReg, X86::GR8RegClass, MRI) ||
+      !RBI.constrainGenericRegister(DstReg, X86::GR8RegClass, MRI)) {
+    DEBUG(dbgs() << "Failed to constrain G_ANYEXT\n");
+    return false;
+  }
+
+  I.setDesc(TII.get(X86::COPY));
+  return true;
+}
+
 bool X86InstructionSelector::selectCmp(MachineInstr &I,
                                        MachineRegisterInfo &MRI,
                                        MachineFunction &MF) const {
@@ -1154,6 +1198,102 @@ bool X86InstructionSelector::selectImplicitDef(MachineInstr &I,
   return true;
 }
 
+bool X86InstructionSelector::selectPhi(MachineInstr &I,
+                                       MachineRegisterInfo &MRI) const {
+
+  if (I.getOpcode() != TargetOpcode::G_PHI)
+    return false;
+
+  unsigned DstReg = I.getOperand(0).getReg();
+
+  if (!MRI.getRegClassOrNull(DstReg)) {
+    const LLT DstTy = MRI.getType(DstReg);
+    const TargetRegisterClass *RC = getRegClass(DstTy, DstReg, MRI);
+
+    if (!RBI.constrainGenericRegister(DstReg, *RC, MRI)) {
+      DEBUG(dbgs() << "Failed to constrain " << TII.getName(I.getOpcode())
+                   << " operand\n");
+      return false;
+    }
+  }
+
+  I.setDesc(TII.get(TargetOpcode::PHI));
+  return true;
+}
+
+bool X86InstructionSelector::selectShift(MachineInstr &I,
+                                         MachineRegisterInfo &MRI,
+                                         MachineFunction &MF) const {
+
+  unsigned Opc = I.getOpcode();
+  if (Opc != TargetOpcode::G_SHL && Opc != TargetOpcode::G_LSHR &&
+      Opc != TargetOpcode::G_ASHR)
+    return false;
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned SrcReg = I.getOperand(1).getReg();
+  const unsigned AmtReg = I.getOperand(2).getReg();
+
+  const LLT DstTy = MRI.getType(DstReg);
+  const RegisterBank &DstRB = *RBI.getRegBank(DstReg, MRI, TRI);
+  if (DstRB.getID() != X86::GPRRegBankID)
+    return false;
+
+  // The variable shifts take their amount in CL, as in X86FastISel.
+  static const struct ShiftEntry {
+    unsigned SizeInBits;
+    unsigned CReg;
+    unsigned ShlOp;
+    unsigned LShrOp;
+    unsigned AShrOp;
+  } ShiftTable[] = {
+      {8, X86::CL, X86::SHL8rCL, X86::SHR8rCL, X86::SAR8rCL},
+      {16, X86::CX, X86::SHL16rCL, X86::SHR16rCL, X86::SAR16rCL},
+      {32, X86::ECX, X86::SHL32rCL, X86::SHR32rCL, X86::SAR32rCL},
+      {64, X86::RCX, X86::SHL64rCL, X86::SHR64rCL, X86::SAR64rCL},
+  };
+
+  auto Entry = std::find_if(std::begin(ShiftTable), std::end(ShiftTable),
+                            [&](const ShiftEntry &El) {
+                              return El.SizeInBits == DstTy.getSizeInBits();
+                            });
+  if (Entry == std::end(ShiftTable))
+    return false;
+
+  unsigned ShiftOp = Opc == TargetOpcode::G_SHL
+                         ? Entry->ShlOp
+                         : Opc == TargetOpcode::G_LSHR ? Entry->LShrOp
+                                                       : Entry->AShrOp;
+
+  // The amount is copied to a physical register, so give it a class here.
+  const TargetRegisterClass *RC = getRegClass(DstTy, DstRB);
+  if (!RBI.constrainGenericRegister(AmtReg, *RC, MRI)) {
+    DEBUG(dbgs() << "Failed to constrain " << TII.getName(Opc)
+                 << " operand\n");
+    return false;
+  }
+
+  BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(TargetOpcode::COPY),
+          Entry->CReg)
+      .addReg(AmtReg);
+
+  // The shift instruction uses X86::CL. If we defined a super-register
+  // of X86::CL, emit a subreg KILL to precisely describe what we're doing here.
+  if (Entry->CReg != X86::CL)
+    BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(TargetOpcode::KILL),
+            X86::CL)
+        .addReg(Entry->CReg, RegState::Kill);
+
+  MachineInstr &ShiftInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(ShiftOp), DstReg)
+           .addReg(SrcReg);
+
+  constrainSelectedInstRegOperands(ShiftInst, TII, TRI, RBI);
+
+  I.eraseFromParent();
+  return true;
+}
+
 InstructionSelector *
 llvm::createX86InstructionSelector(const X86TargetMachine &TM,
                                    X86Subtarget &Subtarget,
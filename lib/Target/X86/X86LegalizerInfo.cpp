@@ -55,10 +55,19 @@ void X86LegalizerInfo::setLegalizerInfo32bit() {
   for (auto Ty : {p0, s1, s8, s16, s32})
     setAction({G_IMPLICIT_DEF, Ty}, Legal);
 
+  for (auto Ty : {s8, s16, s32, p0})
+    setAction({G_PHI, Ty}, Legal);
+
+  setAction({G_PHI, s1}, WidenScalar);
+
   for (unsigned BinOp : {G_ADD, G_SUB, G_MUL, G_AND, G_OR, G_XOR})
     for (auto Ty : {s8, s16, s32})
       setAction({BinOp, Ty}, Legal);
 
+  for (unsigned Shift : {G_SHL, G_LSHR, G_ASHR})
+    for (auto Ty : {s8, s16, s32})
+      setAction({Shift, Ty}, Legal);
+
   for (unsigned Op : {G_UADDE}) {
     setAction({Op, s32}, Legal);
     setAction({Op, 1, s1}, Legal);
@@ -126,10 +135,19 @@ void X86LegalizerInfo::setLegalizerInfo64bit() {
   for (auto Ty : {p0, s1, s8, s16, s32, s64})
     setAction({G_IMPLICIT_DEF, Ty}, Legal);
 
+  for (auto Ty : {s8, s16, s32, s64, p0})
+    setAction({G_PHI, Ty}, Legal);
+
+  setAction({G_PHI, s1}, WidenScalar);
+
   for (unsigned BinOp : {G_ADD, G_SUB, G_MUL, G_AND, G_OR, G_XOR})
     for (auto Ty : {s8, s16, s32, s64})
       setAction({BinOp, Ty}, Legal);
 
+  for (unsigned Shift : {G_SHL, G_LSHR, G_ASHR})
+    for (auto Ty : {s8, s16, s32, s64})
+      setAction({Shift, Ty}, Legal);
+
   for (unsigned MemOp : {G_LOAD, G_STORE}) {
     for (auto Ty : {s8, s16, s32, s64, p0})
       setAction({MemOp, Ty}, Legal);
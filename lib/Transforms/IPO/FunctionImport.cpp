@@ -12,7 +12,6 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/IPO/FunctionImport.h"
-
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringSet.h"
@@ -28,9 +27,12 @@
 #include "llvm/Object/IRObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Transforms/IPO/Internalize.h"
 #include "llvm/Transforms/Utils/FunctionImportUtils.h"
+#include <queue>
 
 #define DEBUG_TYPE "function-import"
 
@@ -40,6 +42,8 @@ STATISTIC(NumImportedFunctions, "Number of functions imported");
 STATISTIC(NumImportedModules, "Number of modules imported from");
 STATISTIC(NumDeadSymbols, "Number of dead stripped symbols in index");
 STATISTIC(NumLiveSymbols, "Number of live symbols in index");
+STATISTIC(NumOverBudget,
+          "Number of import candidates rejected by the import budget");
 
 /// Limit on instruction count of imported functions.
 static cl::opt<unsigned> ImportInstrLimit(
@@ -75,6 +79,12 @@ static cl::opt<float> ImportColdMultiplier(
     "import-cold-multiplier", cl::init(0), cl::Hidden, cl::value_desc("N"),
     cl::desc("Multiply the `import-instr-limit` threshold for cold callsites"));
 
+static cl::opt<unsigned> ImportBudget(
+    "import-budget", cl::init(0), cl::Hidden, cl::value_desc("N"),
+    cl::desc("Select the functions imported into each module by expected "
+             "benefit per instruction, up to a total of N instructions, "
+             "instead of using `import-instr-limit` evolution factors"));
+
 static cl::opt<bool> PrintImports("print-imports", cl::init(false), cl::Hidden,
                                   cl::desc("Print imported functions"));
 
@@ -187,6 +197,53 @@ selectCallee(const ModuleSummaryIndex &Index,
 using EdgeInfo = std::tuple<const FunctionSummary *, unsigned /* Threshold */,
                             GlobalValue::GUID>;
 
+static float getHotnessMultiplier(CalleeInfo::HotnessType Hotness) {
+  if (Hotness == CalleeInfo::HotnessType::Hot)
+    return ImportHotMultiplier;
+  if (Hotness == CalleeInfo::HotnessType::Cold)
+    return ImportColdMultiplier;
+  if (Hotness == CalleeInfo::HotnessType::Critical)
+    return ImportCriticalMultiplier;
+  return 1.0;
+}
+
+/// Return the value whose summaries may be imported for a call to \p VI, or
+/// an empty ValueInfo.
+static ValueInfo resolveCallee(const ModuleSummaryIndex &Index, ValueInfo VI) {
+  if (!VI.getSummaryList().empty())
+    return VI;
+  // For SamplePGO, the indirect call targets for local functions will
+  // have its original name annotated in profile. We try to find the
+  // corresponding PGOFuncName as the GUID.
+  auto GUID = Index.getGUIDFromOriginalID(VI.getGUID());
+  if (GUID == 0)
+    return ValueInfo();
+  return Index.getValueInfo(GUID);
+}
+
+/// Mark the function \p CalleeSummary imported from \p ExportModulePath as
+/// exported from it. The first time it is exported, also mark everything it
+/// references.
+static void exportImportedFunction(
+    const FunctionSummary &CalleeSummary, GlobalValue::GUID CalleeGUID,
+    StringRef ExportModulePath, bool PreviouslyImported,
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
+  auto &ExportList = ExportLists[ExportModulePath];
+  ExportList.insert(CalleeGUID);
+  if (PreviouslyImported)
+    return;
+  // This is the first time this function was exported from its source
+  // module, so mark all functions and globals it references as exported
+  // to the outside if they are defined in the same source module.
+  // For efficiency, we unconditionally add all the referenced GUIDs
+  // to the ExportList for this module, and will prune out any not
+  // defined in the module later in a single pass.
+  for (auto &Edge : CalleeSummary.calls())
+    ExportList.insert(Edge.first.getGUID());
+  for (auto &Ref : CalleeSummary.refs())
+    ExportList.insert(Ref.getGUID());
+}
+
 /// Compute the list of functions to import for a given caller. Mark these
 /// imported functions and the symbols they reference in their source module as
 /// exported from their source module.
@@ -197,39 +254,20 @@ static void computeImportForFunction(
     FunctionImporter::ImportMapTy &ImportList,
     StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr) {
   for (auto &Edge : Summary.calls()) {
-    ValueInfo VI = Edge.first;
-    DEBUG(dbgs() << " edge -> " << VI.getGUID() << " Threshold:" << Threshold
-                 << "\n");
-
-    if (VI.getSummaryList().empty()) {
-      // For SamplePGO, the indirect call targets for local functions will
-      // have its original name annotated in profile. We try to find the
-      // corresponding PGOFuncName as the GUID.
-      auto GUID = Index.getGUIDFromOriginalID(VI.getGUID());
-      if (GUID == 0)
-        continue;
-      VI = Index.getValueInfo(GUID);
-      if (!VI)
-        continue;
-    }
+    DEBUG(dbgs() << " edge -> " << Edge.first.getGUID()
+                 << " Threshold:" << Threshold << "\n");
+
+    ValueInfo VI = resolveCallee(Index, Edge.first);
+    if (!VI)
+      continue;
 
     if (DefinedGVSummaries.count(VI.getGUID())) {
       DEBUG(dbgs() << "ignored! Target already in destination module.\n");
       continue;
     }
 
-    auto GetBonusMultiplier = [](CalleeInfo::HotnessType Hotness) -> float {
-      if (Hotness == CalleeInfo::HotnessType::Hot)
-        return ImportHotMultiplier;
-      if (Hotness == CalleeInfo::HotnessType::Cold)
-        return ImportColdMultiplier;
-      if (Hotness == CalleeInfo::HotnessType::Critical)
-        return ImportCriticalMultiplier;
-      return 1.0;
-    };
-
     const auto NewThreshold =
-        Threshold * GetBonusMultiplier(Edge.second.Hotness);
+        Threshold * getHotnessMultiplier(Edge.second.Hotness);
 
     auto *CalleeSummary = selectCallee(Index, VI.getSummaryList(), NewThreshold,
                                        Summary.modulePath());
@@ -273,38 +311,145 @@ static void computeImportForFunction(
     ProcessedThreshold = AdjThreshold;
 
     // Make exports in the source module.
-    if (ExportLists) {
-      auto &ExportList = (*ExportLists)[ExportModulePath];
-      ExportList.insert(VI.getGUID());
-      if (!PreviouslyImported) {
-        // This is the first time this function was exported from its source
-        // module, so mark all functions and globals it references as exported
-        // to the outside if they are defined in the same source module.
-        // For efficiency, we unconditionally add all the referenced GUIDs
-        // to the ExportList for this module, and will prune out any not
-        // defined in the module later in a single pass.
-        for (auto &Edge : ResolvedCalleeSummary->calls()) {
-          auto CalleeGUID = Edge.first.getGUID();
-          ExportList.insert(CalleeGUID);
-        }
-        for (auto &Ref : ResolvedCalleeSummary->refs()) {
-          auto GUID = Ref.getGUID();
-          ExportList.insert(GUID);
-        }
-      }
-    }
+    if (ExportLists)
+      exportImportedFunction(*ResolvedCalleeSummary, VI.getGUID(),
+                             ExportModulePath, PreviouslyImported,
+                             *ExportLists);
 
     // Insert the newly imported function to the worklist.
     Worklist.emplace_back(ResolvedCalleeSummary, AdjThreshold, VI.getGUID());
   }
 }
 
+/// Return the expected number of calls through \p Edge per call of its caller:
+/// the relative frequency of the call sites if the summary has it, weighted by
+/// the profile hotness of the edge.
+static float getEdgeWeight(const CalleeInfo &Edge) {
+  float Freq = 1.0;
+  if (Edge.RelBlockFreq)
+    Freq = float(Edge.RelBlockFreq) / (1u << CalleeInfo::ScaleShift);
+  return Freq * getHotnessMultiplier(Edge.Hotness);
+}
+
+/// Compute the imports of the module defining \p DefinedGVSummaries as a
+/// knapsack problem: every function that may be imported, i.e. that is called
+/// from the module or from an already selected import and fits the
+/// `import-instr-limit` threshold of the call, is a candidate. Its benefit is
+/// the expected number of calls to it per call of a function of the module,
+/// its cost is its instruction count. Candidates are selected greedily by
+/// benefit per instruction until the budget of the module is spent.
+static void computeImportForModuleWithBudget(
+    const GVSummaryMapTy &DefinedGVSummaries, const ModuleSummaryIndex &Index,
+    StringRef ModulePath, ArrayRef<const FunctionSummary *> Roots,
+    FunctionImporter::ImportMapTy &ImportList,
+    StringMap<FunctionImporter::ExportSetTy> *ExportLists) {
+  struct Candidate {
+    const FunctionSummary *Summary = nullptr;
+    GlobalValue::GUID GUID = 0;
+    float Benefit = 0;
+    unsigned Threshold = 0;
+    bool Selected = false;
+  };
+  // Candidates in the order they are found, which does not depend on the
+  // addresses of the summaries.
+  std::vector<Candidate> Candidates;
+  DenseMap<const FunctionSummary *, unsigned> CandidateIds;
+  // Candidates by benefit per instruction. A candidate is pushed again when
+  // its benefit grows, the outdated entries are skipped.
+  std::priority_queue<std::pair<float, unsigned>> Queue;
+
+  auto getCost = [](const FunctionSummary *S) {
+    return std::max(S->instCount(), 1u);
+  };
+  auto addCalls = [&](const FunctionSummary *Caller, float CallerWeight) {
+    for (auto &Edge : Caller->calls()) {
+      float Benefit = CallerWeight * getEdgeWeight(Edge.second);
+      if (Benefit <= 0)
+        continue;
+      ValueInfo VI = resolveCallee(Index, Edge.first);
+      if (!VI || DefinedGVSummaries.count(VI.getGUID()))
+        continue;
+      unsigned Threshold =
+          ImportInstrLimit * getHotnessMultiplier(Edge.second.Hotness);
+      auto *CalleeSummary = selectCallee(Index, VI.getSummaryList(), Threshold,
+                                         Caller->modulePath());
+      if (!CalleeSummary)
+        continue;
+      auto *FS = cast<FunctionSummary>(CalleeSummary);
+      auto Id = CandidateIds.insert({FS, Candidates.size()});
+      if (Id.second)
+        Candidates.emplace_back();
+      Candidate &C = Candidates[Id.first->second];
+      C.Summary = FS;
+      C.GUID = VI.getGUID();
+      C.Threshold = std::max(C.Threshold, Threshold);
+      if (C.Selected)
+        continue;
+      C.Benefit += Benefit;
+      Queue.push({C.Benefit / getCost(FS), Id.first->second});
+    }
+  };
+
+  for (const FunctionSummary *Root : Roots)
+    addCalls(Root, 1.0);
+
+  std::string Report;
+  raw_string_ostream ReportOS(Report);
+  unsigned Remaining = ImportBudget;
+  float TotalBenefit = 0;
+  while (!Queue.empty()) {
+    Candidate &C = Candidates[Queue.top().second];
+    float Density = Queue.top().first;
+    Queue.pop();
+    if (C.Selected || Density != C.Benefit / getCost(C.Summary))
+      continue;
+    unsigned Cost = getCost(C.Summary);
+    if (Cost > Remaining) {
+      DEBUG(dbgs() << "ignored! " << C.GUID
+                   << " does not fit the remaining budget of " << Remaining
+                   << "\n");
+      ++NumOverBudget;
+      continue;
+    }
+    C.Selected = true;
+    Remaining -= Cost;
+    TotalBenefit += C.Benefit;
+
+    GlobalValue::GUID GUID = C.GUID;
+    StringRef ExportModulePath = C.Summary->modulePath();
+    auto &ProcessedThreshold = ImportList[ExportModulePath][GUID];
+    bool PreviouslyImported = ProcessedThreshold != 0;
+    ProcessedThreshold = std::max(ProcessedThreshold, C.Threshold);
+    if (ExportLists)
+      exportImportedFunction(*C.Summary, GUID, ExportModulePath,
+                             PreviouslyImported, *ExportLists);
+    if (PrintImports)
+      ReportOS << ModulePath << ": Select " << GUID << " from "
+               << ExportModulePath << " (cost " << Cost << ", benefit "
+               << format("%.2f", C.Benefit) << ")\n";
+
+    // Calls from the imported function are as frequent as calls to it. The
+    // reference to C is not used past this point, addCalls may grow the
+    // vector.
+    addCalls(C.Summary, C.Benefit);
+  }
+
+  if (PrintImports) {
+    ReportOS << ModulePath << ": Selected imports cost "
+             << ImportBudget - Remaining << " of " << ImportBudget
+             << " instructions, expected benefit "
+             << format("%.2f", TotalBenefit) << "\n";
+    // Print the report at once, modules may be processed in parallel.
+    dbgs() << ReportOS.str();
+  }
+}
+
 /// Given the list of globals defined in a module, compute the list of imports
 /// as well as the list of "exports", i.e. the list of symbols referenced from
 /// another module (that may require promotion).
 static void ComputeImportForModule(
     const GVSummaryMapTy &DefinedGVSummaries, const ModuleSummaryIndex &Index,
-    FunctionImporter::ImportMapTy &ImportList,
+    StringRef ModulePath, FunctionImporter::ImportMapTy &ImportList,
     StringMap<FunctionImporter::ExportSetTy> *ExportLists = nullptr) {
   // Worklist contains the list of function imported in this module, for which
   // we will analyse the callees and may import further down the callgraph.
@@ -312,6 +457,7 @@ static void ComputeImportForModule(
 
   // Populate the worklist with the import for the functions in the current
   // module
+  SmallVector<const FunctionSummary *, 128> Roots;
   for (auto &GVSummary : DefinedGVSummaries) {
     if (!Index.isGlobalValueLive(GVSummary.second)) {
       DEBUG(dbgs() << "Ignores Dead GUID: " << GVSummary.first << "\n");
@@ -325,11 +471,21 @@ static void ComputeImportForModule(
       // Skip import for global variables
       continue;
     DEBUG(dbgs() << "Initialize import for " << GVSummary.first << "\n");
+    if (ImportBudget) {
+      Roots.push_back(FuncSummary);
+      continue;
+    }
     computeImportForFunction(*FuncSummary, Index, ImportInstrLimit,
                              DefinedGVSummaries, Worklist, ImportList,
                              ExportLists);
   }
 
+  if (ImportBudget) {
+    computeImportForModuleWithBudget(DefinedGVSummaries, Index, ModulePath,
+                                     Roots, ImportList, ExportLists);
+    return;
+  }
+
   // Process the newly imported functions and add callees to the worklist.
   while (!Worklist.empty()) {
     auto FuncInfo = Worklist.pop_back_val();
@@ -349,6 +505,45 @@ static void ComputeImportForModule(
   }
 }
 
+/// Compute the import lists of the modules of \p ModuleToDefinedGVSummaries
+/// on \p Threads threads. A module's import list only depends on the index,
+/// so each is computed by a single task. The exports found by the modules of a
+/// chunk are collected separately, then merged in chunk order.
+static void computeImportsInParallel(
+    const ModuleSummaryIndex &Index,
+    const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
+    StringMap<FunctionImporter::ImportMapTy> &ImportLists,
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists, unsigned Threads) {
+  // Create the import lists up front, the map must not change under the tasks.
+  std::vector<std::pair<const StringMapEntry<GVSummaryMapTy> *,
+                        FunctionImporter::ImportMapTy *>>
+      Modules;
+  Modules.reserve(ModuleToDefinedGVSummaries.size());
+  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries)
+    Modules.emplace_back(&DefinedGVSummaries,
+                         &ImportLists[DefinedGVSummaries.first()]);
+
+  // Use a few more chunks than threads for load balancing.
+  size_t NumChunks = std::min<size_t>(Modules.size(), 4 * Threads);
+  std::vector<StringMap<FunctionImporter::ExportSetTy>> ChunkExportLists(
+      NumChunks);
+  ThreadPool Pool(Threads);
+  for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk)
+    Pool.async([&, Chunk] {
+      size_t Begin = Modules.size() * Chunk / NumChunks;
+      size_t End = Modules.size() * (Chunk + 1) / NumChunks;
+      for (size_t I = Begin; I != End; ++I)
+        ComputeImportForModule(Modules[I].first->second, Index,
+                               Modules[I].first->first(), *Modules[I].second,
+                               &ChunkExportLists[Chunk]);
+    });
+  Pool.wait();
+
+  for (auto &ChunkExports : ChunkExportLists)
+    for (auto &ELI : ChunkExports)
+      ExportLists[ELI.first()].insert(ELI.second.begin(), ELI.second.end());
+}
+
 } // anonymous namespace
 
 /// Compute all the import and export for every module using the Index.
@@ -356,15 +551,21 @@ void llvm::ComputeCrossModuleImport(
     const ModuleSummaryIndex &Index,
     const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
     StringMap<FunctionImporter::ImportMapTy> &ImportLists,
-    StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
-  // For each module that has function defined, compute the import/export lists.
-  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
-    auto &ImportList = ImportLists[DefinedGVSummaries.first()];
-    DEBUG(dbgs() << "Computing import for Module '"
-                 << DefinedGVSummaries.first() << "'\n");
-    ComputeImportForModule(DefinedGVSummaries.second, Index, ImportList,
-                           &ExportLists);
-  }
+    StringMap<FunctionImporter::ExportSetTy> &ExportLists, unsigned Threads) {
+  if (Threads > 1 && ModuleToDefinedGVSummaries.size() > 1)
+    computeImportsInParallel(Index, ModuleToDefinedGVSummaries, ImportLists,
+                             ExportLists, Threads);
+  else
+    // For each module that has function defined, compute the import/export
+    // lists.
+    for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
+      auto &ImportList = ImportLists[DefinedGVSummaries.first()];
+      DEBUG(dbgs() << "Computing import for Module '"
+                   << DefinedGVSummaries.first() << "'\n");
+      ComputeImportForModule(DefinedGVSummaries.second, Index,
+                             DefinedGVSummaries.first(), ImportList,
+                             &ExportLists);
+    }
 
   // When computing imports we added all GUIDs referenced by anything
   // imported from the module to its ExportList. Now we prune each ExportList
@@ -412,7 +613,7 @@ void llvm::ComputeCrossModuleImportForModule(
 
   // Compute the import list for this module.
   DEBUG(dbgs() << "Computing import for Module '" << ModulePath << "'\n");
-  ComputeImportForModule(FunctionSummaryMap, Index, ImportList);
+  ComputeImportForModule(FunctionSummaryMap, Index, ModulePath, ImportList);
 
 #ifndef NDEBUG
   DEBUG(dbgs() << "* Module " << ModulePath << " imports from "
@@ -425,15 +626,84 @@ void llvm::ComputeCrossModuleImportForModule(
 #endif
 }
 
+/// Call \p Visit on every value referenced, called or aliased by a summary of
+/// \p VI.
+static void forEachSuccessor(const ModuleSummaryIndex &Index, ValueInfo VI,
+                             function_ref<void(ValueInfo)> Visit) {
+  for (auto &Summary : VI.getSummaryList()) {
+    for (auto Ref : Summary->refs())
+      Visit(Ref);
+    if (auto *FS = dyn_cast<FunctionSummary>(Summary.get()))
+      for (auto Call : FS->calls())
+        Visit(Call.first);
+    if (auto *AS = dyn_cast<AliasSummary>(Summary.get())) {
+      auto AliaseeGUID = AS->getAliasee().getOriginalName();
+      ValueInfo AliaseeVI = Index.getValueInfo(AliaseeGUID);
+      if (AliaseeVI)
+        Visit(AliaseeVI);
+    }
+  }
+}
+
+/// Mark live every value reachable from the values of \p Roots, walking the
+/// graph one level at a time on \p Threads threads. The tasks only read the
+/// live flags, through \p isLive: they collect the successors of the level
+/// that are not live yet, then the calling thread marks them and removes the
+/// duplicates. The result does not depend on scheduling. Return the number of
+/// values made live.
+static unsigned
+propagateLivenessInParallel(const ModuleSummaryIndex &Index,
+                            ArrayRef<ValueInfo> Roots, unsigned Threads,
+                            function_ref<bool(ValueInfo)> isLive) {
+  unsigned LiveSymbols = 0;
+  std::vector<ValueInfo> Level(Roots.begin(), Roots.end());
+  ThreadPool Pool(Threads);
+  while (!Level.empty()) {
+    size_t NumChunks = std::min<size_t>(Level.size(), 4 * Threads);
+    std::vector<std::vector<ValueInfo>> Found(NumChunks);
+    for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk)
+      Pool.async([&, Chunk] {
+        size_t Begin = Level.size() * Chunk / NumChunks;
+        size_t End = Level.size() * (Chunk + 1) / NumChunks;
+        for (size_t I = Begin; I != End; ++I)
+          forEachSuccessor(Index, Level[I], [&](ValueInfo VI) {
+            if (!isLive(VI))
+              Found[Chunk].push_back(VI);
+          });
+      });
+    Pool.wait();
+
+    Level.clear();
+    for (auto &Values : Found)
+      for (ValueInfo VI : Values) {
+        if (isLive(VI))
+          continue;
+        for (auto &S : VI.getSummaryList())
+          S->setLive(true);
+        Level.push_back(VI);
+      }
+    LiveSymbols += Level.size();
+  }
+  return LiveSymbols;
+}
+
 void llvm::computeDeadSymbols(
     ModuleSummaryIndex &Index,
-    const DenseSet<GlobalValue::GUID> &GUIDPreservedSymbols) {
+    const DenseSet<GlobalValue::GUID> &GUIDPreservedSymbols, unsigned Threads) {
   assert(!Index.withGlobalValueDeadStripping());
   if (!ComputeDead)
     return;
   if (GUIDPreservedSymbols.empty())
     // Don't do anything when nothing is live, this is friendly with tests.
     return;
+  // A value is live if any of its summaries is.
+  auto isLive = [](ValueInfo VI) {
+    for (auto &S : VI.getSummaryList())
+      if (S->isLive())
+        return true;
+    return false;
+  };
+
   unsigned LiveSymbols = 0;
   SmallVector<ValueInfo, 128> Worklist;
   Worklist.reserve(GUIDPreservedSymbols.size() * 2);
@@ -455,34 +725,25 @@ void llvm::computeDeadSymbols(
         break;
       }
 
+  if (Threads > 1) {
+    LiveSymbols +=
+        propagateLivenessInParallel(Index, Worklist, Threads, isLive);
+    Worklist.clear();
+  }
+
   // Make value live and add it to the worklist if it was not live before.
   // FIXME: we should only make the prevailing copy live here
   auto visit = [&](ValueInfo VI) {
-    for (auto &S : VI.getSummaryList())
-      if (S->isLive())
-        return;
+    if (isLive(VI))
+      return;
     for (auto &S : VI.getSummaryList())
       S->setLive(true);
     ++LiveSymbols;
     Worklist.push_back(VI);
   };
 
-  while (!Worklist.empty()) {
-    auto VI = Worklist.pop_back_val();
-    for (auto &Summary : VI.getSummaryList()) {
-      for (auto Ref : Summary->refs())
-        visit(Ref);
-      if (auto *FS = dyn_cast<FunctionSummary>(Summary.get()))
-        for (auto Call : FS->calls())
-          visit(Call.first);
-      if (auto *AS = dyn_cast<AliasSummary>(Summary.get())) {
-        auto AliaseeGUID = AS->getAliasee().getOriginalName();
-        ValueInfo AliaseeVI = Index.getValueInfo(AliaseeGUID);
-        if (AliaseeVI)
-          visit(AliaseeVI);
-      }
-    }
-  }
+  while (!Worklist.empty())
+    forEachSuccessor(Index, Worklist.pop_back_val(), visit);
   Index.setWithGlobalValueDeadStripping();
 
   unsigned DeadSymbols = Index.size() - LiveSymbols;
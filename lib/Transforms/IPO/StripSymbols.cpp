@@ -14,25 +14,39 @@
 //   * symbols for internal globals and functions
 //   * debug information
 //
+// It also provides a pass that compacts the debug information of a module,
+// which is mostly useful after many modules have been linked together.
+//
 // Note that this transformation makes code much less readable, so it should
 // only be used in situations where the 'strip' utility would be used, such as
 // reducing code size or making it harder to reverse engineer code.
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/TypeFinder.h"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Pass.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 using namespace llvm;
 
+#define DEBUG_TYPE "strip"
+
+STATISTIC(NumODRTypesMerged,
+          "Number of duplicate identified debug info types merged");
+STATISTIC(NumRetainedNodesDropped,
+          "Number of dead subprograms whose retained variables were dropped");
+
 namespace {
   class StripSymbols : public ModulePass {
     bool OnlyDebugInfo;
@@ -94,6 +108,21 @@ namespace {
       AU.setPreservesAll();
     }
   };
+
+  class CompactDebugInfo : public ModulePass {
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    explicit CompactDebugInfo()
+      : ModulePass(ID) {
+        initializeCompactDebugInfoPass(*PassRegistry::getPassRegistry());
+      }
+
+    bool runOnModule(Module &M) override;
+
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+      AU.setPreservesAll();
+    }
+  };
 }
 
 char StripSymbols::ID = 0;
@@ -129,6 +158,14 @@ ModulePass *llvm::createStripDeadDebugInfoPass() {
   return new StripDeadDebugInfo();
 }
 
+char CompactDebugInfo::ID = 0;
+INITIALIZE_PASS(CompactDebugInfo, "compact-debug-info",
+                "Deduplicate and compact debug info", false, false)
+
+ModulePass *llvm::createCompactDebugInfoPass() {
+  return new CompactDebugInfo();
+}
+
 /// OnlyUsedBy - Return true if V is only used by Usr.
 static bool OnlyUsedBy(Value *V, Value *Usr) {
   for (User *U : V->users())
@@ -294,10 +331,7 @@ bool StripDebugDeclare::runOnModule(Module &M) {
 /// such a way that debug info for symbols preserved even if symbols are
 /// optimized away by the optimizer. This special pass removes debug info for
 /// such symbols.
-bool StripDeadDebugInfo::runOnModule(Module &M) {
-  if (skipModule(M))
-    return false;
-
+static bool stripDeadDebugInfoImpl(Module &M) {
   bool Changed = false;
 
   LLVMContext &C = M.getContext();
@@ -378,3 +412,135 @@ bool StripDeadDebugInfo::runOnModule(Module &M) {
 
   return Changed;
 }
+
+bool StripDeadDebugInfo::runOnModule(Module &M) {
+  if (skipModule(M))
+    return false;
+
+  return stripDeadDebugInfoImpl(M);
+}
+
+/// Remap the metadata attached to a global object or an instruction.
+template <typename T>
+static void remapMetadataAttachments(T &Object, ValueMapper &Mapper) {
+  SmallVector<std::pair<unsigned, MDNode *>, 8> MDs;
+  Object.getAllMetadata(MDs);
+  for (const auto &Attachment : MDs) {
+    MDNode *New = Mapper.mapMDNode(*Attachment.second);
+    if (New != Attachment.second)
+      Object.setMetadata(Attachment.first, New);
+  }
+}
+
+/// Redirect all references to an identified DICompositeType definition to the
+/// first definition in the module with the same identifier.
+///
+/// The ODR type map of the context does this while modules are loaded, but
+/// modules linked without it carry one copy of each type per input module.
+static bool canonicalizeODRTypes(Module &M) {
+  DebugInfoFinder Finder;
+  Finder.processModule(M);
+
+  ValueToValueMapTy VM;
+  DenseMap<MDString *, DICompositeType *> Canonical;
+  unsigned NumMerged = 0;
+  for (DIType *Ty : Finder.types()) {
+    auto *CT = dyn_cast<DICompositeType>(Ty);
+    if (!CT || !CT->getRawIdentifier() || CT->isForwardDecl())
+      continue;
+    auto Insertion = Canonical.insert({CT->getRawIdentifier(), CT});
+    if (Insertion.second || Insertion.first->second == CT)
+      continue;
+    VM.MD()[CT].reset(Insertion.first->second);
+    ++NumMerged;
+  }
+  if (!NumMerged)
+    return false;
+  NumODRTypesMerged += NumMerged;
+
+  // Only metadata is remapped; distinct nodes are updated in place and uniqued
+  // nodes that reference a duplicate are rebuilt around the canonical type.
+  ValueMapper Mapper(VM, RF_MoveDistinctMDs | RF_IgnoreMissingLocals);
+  for (GlobalVariable &GV : M.globals())
+    remapMetadataAttachments(GV, Mapper);
+  for (Function &F : M) {
+    remapMetadataAttachments(F, Mapper);
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB) {
+        remapMetadataAttachments(I, Mapper);
+        auto *DII = dyn_cast<DbgInfoIntrinsic>(&I);
+        if (!DII)
+          continue;
+        for (unsigned Op = 0, E = DII->getNumArgOperands(); Op != E; ++Op) {
+          auto *MAV = dyn_cast<MetadataAsValue>(DII->getArgOperand(Op));
+          auto *N = MAV ? dyn_cast<MDNode>(MAV->getMetadata()) : nullptr;
+          if (!N)
+            continue;
+          MDNode *New = Mapper.mapMDNode(*N);
+          if (New != N)
+            DII->setArgOperand(Op, MetadataAsValue::get(M.getContext(), New));
+        }
+      }
+  }
+  for (NamedMDNode &NMD : M.named_metadata())
+    for (unsigned I = 0, E = NMD.getNumOperands(); I != E; ++I) {
+      MDNode *Op = NMD.getOperand(I);
+      MDNode *New = Mapper.mapMDNode(*Op);
+      if (New != Op)
+        NMD.setOperand(I, New);
+    }
+  return true;
+}
+
+/// Drop the retained variables of subprogram definitions that neither own a
+/// function nor appear in the scope chain of any remaining instruction.
+static bool dropDeadRetainedNodes(Module &M) {
+  SmallPtrSet<const DISubprogram *, 32> LiveSPs;
+  for (Function &F : M) {
+    if (DISubprogram *SP = F.getSubprogram())
+      LiveSPs.insert(SP);
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB) {
+        for (const DILocation *DL = I.getDebugLoc().get(); DL;
+             DL = DL->getInlinedAt())
+          LiveSPs.insert(DL->getScope()->getSubprogram());
+        if (auto *DVI = dyn_cast<DbgValueInst>(&I))
+          LiveSPs.insert(DVI->getVariable()->getScope()->getSubprogram());
+        else if (auto *DDI = dyn_cast<DbgDeclareInst>(&I))
+          LiveSPs.insert(DDI->getVariable()->getScope()->getSubprogram());
+      }
+  }
+
+  DebugInfoFinder Finder;
+  Finder.processModule(M);
+
+  bool Changed = false;
+  for (DISubprogram *SP : Finder.subprograms()) {
+    if (!SP->isDistinct() || LiveSPs.count(SP))
+      continue;
+    MDTuple *Variables = SP->getVariables().get();
+    if (!Variables || !Variables->getNumOperands())
+      continue;
+    SP->replaceVariables(DILocalVariableArray());
+    ++NumRetainedNodesDropped;
+    Changed = true;
+  }
+  return Changed;
+}
+
+/// Compact the debug info of a module: merge duplicate identified types, drop
+/// the retained nodes of dead subprograms and then remove the debug info of
+/// dead globals and compile units.
+///
+/// This is intended to run on the result of linking many modules together,
+/// before the module is written out or split for code generation, so that
+/// metadata that no longer describes anything is not carried further.
+bool CompactDebugInfo::runOnModule(Module &M) {
+  if (skipModule(M))
+    return false;
+
+  bool Changed = canonicalizeODRTypes(M);
+  Changed |= dropDeadRetainedNodes(M);
+  Changed |= stripDeadDebugInfoImpl(M);
+  return Changed;
+}
@@ -20,7 +20,12 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalObject.h"
@@ -30,6 +35,7 @@
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
 #include <queue>
 
 using namespace llvm;
@@ -73,17 +79,9 @@ static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
   }
 }
 
-// Find partitions for module in the way that no locals need to be
-// globalized.
-// Try to balance pack those partitions into N files since this roughly equals
-// thread balancing for the backend codegen step.
-static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
-                           unsigned N) {
-  // At this point module should have the proper mix of globals and locals.
-  // As we attempt to partition this module, we must not change any
-  // locals to globals.
-  DEBUG(dbgs() << "Partition module with (" << M->size() << ")functions\n");
-  ClusterMapType GVtoClusterMap;
+// Group the globals of the module that must end up in the same partition:
+// locals and their users, comdat members and aliases with their aliasees.
+static void findForcedClusters(Module *M, ClusterMapType &GVtoClusterMap) {
   ComdatMembersType ComdatMembers;
 
   auto recordGVSet = [&GVtoClusterMap, &ComdatMembers](GlobalValue &GV) {
@@ -128,6 +126,20 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   std::for_each(M->begin(), M->end(), recordGVSet);
   std::for_each(M->global_begin(), M->global_end(), recordGVSet);
   std::for_each(M->alias_begin(), M->alias_end(), recordGVSet);
+}
+
+// Find partitions for module in the way that no locals need to be
+// globalized.
+// Try to balance pack those partitions into N files since this roughly equals
+// thread balancing for the backend codegen step.
+static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
+                           unsigned N) {
+  // At this point module should have the proper mix of globals and locals.
+  // As we attempt to partition this module, we must not change any
+  // locals to globals.
+  DEBUG(dbgs() << "Partition module with (" << M->size() << ")functions\n");
+  ClusterMapType GVtoClusterMap;
+  findForcedClusters(M, GVtoClusterMap);
 
   // Assigned all GVs to merged clusters while balancing number of objects in
   // each.
@@ -191,6 +203,149 @@ static void findPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
   }
 }
 
+// Returns the number of instructions of GV, at least 1, which is what the call
+// graph partitioning balances.
+static uint64_t getGlobalSize(const GlobalValue *GV) {
+  uint64_t Size = 0;
+  if (auto *F = dyn_cast<Function>(GV))
+    for (const BasicBlock &BB : *F)
+      Size += BB.size();
+  return std::max<uint64_t>(Size, 1);
+}
+
+typedef std::pair<const Function *, const Function *> CallerCalleeType;
+typedef MapVector<CallerCalleeType, double> CallEdgesType;
+
+// Collect the direct calls between the functions defined in M, weighted by the
+// number of times they are executed: the profile count of the call block if
+// the caller has an entry count, or its frequency relative to the entry block.
+static void findCallEdges(Module *M, CallEdgesType &CallEdges) {
+  for (const Function &F : *M) {
+    if (F.isDeclaration())
+      continue;
+    LoopInfo LI{DominatorTree(const_cast<Function &>(F))};
+    BranchProbabilityInfo BPI{F, LI};
+    BlockFrequencyInfo BFI{F, BPI, LI};
+    bool HasProfile = F.getEntryCount().hasValue();
+    double EntryFreq = BFI.getEntryFreq();
+
+    for (const BasicBlock &BB : F) {
+      double Weight = 0;
+      for (const Instruction &I : BB) {
+        ImmutableCallSite CS(&I);
+        if (!CS)
+          continue;
+        auto *Callee =
+            dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+        if (!Callee || Callee->isDeclaration() || Callee == &F)
+          continue;
+        // Compute the weight of the block once it is known to have a call.
+        if (!Weight) {
+          if (HasProfile)
+            Weight = BFI.getBlockProfileCount(&BB).getValueOr(0);
+          else
+            Weight = BFI.getBlockFreq(&BB).getFrequency() / EntryFreq;
+        }
+        CallEdges[std::make_pair(&F, Callee)] += Weight;
+      }
+    }
+  }
+}
+
+// Find partitions for the module by clustering the functions along their
+// heaviest call edges, so that callers and callees end up in the same
+// partition, and packing the clusters into N partitions of about the same
+// number of instructions. The clusters of findForcedClusters are kept
+// together, so that no locals need to be globalized.
+static void findCallGraphPartitions(Module *M, ClusterIDMapType &ClusterIDMap,
+                                    unsigned N) {
+  DEBUG(dbgs() << "Partition module with (" << M->size()
+               << ")functions by call graph\n");
+  ClusterMapType GVtoClusterMap;
+  findForcedClusters(M, GVtoClusterMap);
+
+  std::vector<const GlobalValue *> Globals;
+  for (const Function &F : *M)
+    Globals.push_back(&F);
+  for (const GlobalVariable &GV : M->globals())
+    Globals.push_back(&GV);
+  for (const GlobalAlias &GA : M->aliases())
+    Globals.push_back(&GA);
+
+  // Track the size of each cluster by its leader.
+  DenseMap<const GlobalValue *, uint64_t> ClusterSize;
+  uint64_t TotalSize = 0;
+  for (const GlobalValue *GV : Globals) {
+    if (GV->isDeclaration())
+      continue;
+    GVtoClusterMap.insert(GV);
+    uint64_t Size = getGlobalSize(GV);
+    ClusterSize[GVtoClusterMap.getLeaderValue(GV)] += Size;
+    TotalSize += Size;
+  }
+
+  // Merge the clusters along the call edges, heaviest first, as long as the
+  // result fits in a partition. Ties are broken by the order of the module.
+  CallEdgesType CallEdges;
+  findCallEdges(M, CallEdges);
+  std::vector<std::pair<CallerCalleeType, double>> SortedEdges(
+      CallEdges.begin(), CallEdges.end());
+  std::stable_sort(SortedEdges.begin(), SortedEdges.end(),
+                   [](const std::pair<CallerCalleeType, double> &A,
+                      const std::pair<CallerCalleeType, double> &B) {
+                     return A.second > B.second;
+                   });
+  uint64_t MaxClusterSize = std::max<uint64_t>(TotalSize / N, 1);
+  for (auto &Edge : SortedEdges) {
+    const GlobalValue *Caller =
+        GVtoClusterMap.getLeaderValue(Edge.first.first);
+    const GlobalValue *Callee =
+        GVtoClusterMap.getLeaderValue(Edge.first.second);
+    if (Caller == Callee)
+      continue;
+    uint64_t Size = ClusterSize[Caller] + ClusterSize[Callee];
+    if (Size > MaxClusterSize)
+      continue;
+    DEBUG(dbgs() << "Merge " << Edge.first.first->getName() << " -> "
+                 << Edge.first.second->getName() << " (" << Edge.second
+                 << ")\n");
+    ClusterSize[*GVtoClusterMap.unionSets(Caller, Callee)] = Size;
+  }
+
+  // Assign the clusters, largest first, to the partition with the fewest
+  // instructions so far. As in findPartitions, leaders' names break ties.
+  typedef std::pair<uint64_t, const GlobalValue *> SortType;
+  std::vector<SortType> Sets;
+  for (ClusterMapType::iterator I = GVtoClusterMap.begin(),
+                                E = GVtoClusterMap.end();
+       I != E; ++I)
+    if (I->isLeader())
+      Sets.push_back(std::make_pair(ClusterSize[I->getData()], I->getData()));
+  std::sort(Sets.begin(), Sets.end(), [](const SortType &A, const SortType &B) {
+    if (A.first == B.first)
+      return A.second->getName() > B.second->getName();
+    return A.first > B.first;
+  });
+
+  typedef std::pair<uint64_t, unsigned> LoadType;
+  std::priority_queue<LoadType, std::vector<LoadType>, std::greater<LoadType>>
+      Partitions;
+  for (unsigned I = 0; I < N; ++I)
+    Partitions.push(std::make_pair(0, I));
+  for (auto &Set : Sets) {
+    LoadType Partition = Partitions.top();
+    Partitions.pop();
+    DEBUG(dbgs() << "Root[" << Partition.second << "] cluster_size("
+                 << Set.first << ") ----> " << Set.second->getName() << "\n");
+    for (ClusterMapType::member_iterator MI =
+             GVtoClusterMap.findLeader(Set.second);
+         MI != GVtoClusterMap.member_end(); ++MI)
+      ClusterIDMap[*MI] = Partition.second;
+    Partitions.push(std::make_pair(Partition.first + Set.first,
+                                   Partition.second));
+  }
+}
+
 static void externalize(GlobalValue *GV) {
   if (GV->hasLocalLinkage()) {
     GV->setLinkage(GlobalValue::ExternalLinkage);
@@ -228,7 +383,7 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
 void llvm::SplitModule(
     std::unique_ptr<Module> M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals) {
+    bool PreserveLocals, SplitModulePartitioning Partitioning) {
   if (!PreserveLocals) {
     for (Function &F : *M)
       externalize(&F);
@@ -243,7 +398,10 @@ void llvm::SplitModule(
   // This performs splitting without a need for externalization, which might not
   // always be possible.
   ClusterIDMapType ClusterIDMap;
-  findPartitions(M.get(), ClusterIDMap, N);
+  if (Partitioning == SplitModulePartitioning::CallGraph)
+    findCallGraphPartitions(M.get(), ClusterIDMap, N);
+  else
+    findPartitions(M.get(), ClusterIDMap, N);
 
   // FIXME: We should be able to reuse M as the last partition instead of
   // cloning it.
@@ -840,9 +840,12 @@ void Mapper::remapInstruction(Instruction *I) {
   for (Use &Op : I->operands()) {
     Value *V = mapValue(Op);
     // If we aren't ignoring missing entries, assert that something happened.
-    if (V)
-      Op = V;
-    else
+    // Values that map to themselves are left alone; re-setting the use would
+    // only unlink and relink it in the value's use list.
+    if (V) {
+      if (V != Op)
+        Op = V;
+    } else
       assert((Flags & RF_IgnoreMissingLocals) &&
              "Referenced value not in value map!");
   }
@@ -877,11 +880,16 @@ void Mapper::remapInstruction(Instruction *I) {
   if (auto CS = CallSite(I)) {
     SmallVector<Type *, 3> Tys;
     FunctionType *FTy = CS.getFunctionType();
+    Type *RetTy = TypeMapper->remapType(I->getType());
+    bool AnyChange = RetTy != FTy->getReturnType();
     Tys.reserve(FTy->getNumParams());
-    for (Type *Ty : FTy->params())
+    for (Type *Ty : FTy->params()) {
       Tys.push_back(TypeMapper->remapType(Ty));
-    CS.mutateFunctionType(FunctionType::get(
-        TypeMapper->remapType(I->getType()), Tys, FTy->isVarArg()));
+      AnyChange |= Tys.back() != Ty;
+    }
+    // Most call sites keep their type; don't re-unique it in the context.
+    if (AnyChange)
+      CS.mutateFunctionType(FunctionType::get(RetTy, Tys, FTy->isVarArg()));
     return;
   }
   if (auto *AI = dyn_cast<AllocaInst>(I))
@@ -906,8 +914,11 @@ void Mapper::remapGlobalObjectMetadata(GlobalObject &GO) {
 void Mapper::remapFunction(Function &F) {
   // Remap the operands.
   for (Use &Op : F.operands())
-    if (Op)
-      Op = mapValue(Op);
+    if (Op) {
+      Value *V = mapValue(Op);
+      if (V != Op)
+        Op = V;
+    }
 
   // Remap the metadata attachments.
   remapGlobalObjectMetadata(F);
@@ -0,0 +1,65 @@
+; Printing function bodies on several threads must produce exactly the same
+; module as printing them serially, including the numbering of unnamed
+; values, metadata and attribute groups.
+;
+; RUN: llvm-as < %s | llvm-dis -print-module-threads=1 > %t.serial
+; RUN: llvm-as < %s | llvm-dis -print-module-threads=4 > %t.parallel
+; RUN: diff %t.serial %t.parallel
+; RUN: FileCheck %s < %t.parallel
+
+%0 = type { i32, float }
+%named = type { %0, <4 x i8> }
+
+@0 = private global %0 { i32 1, float 2.5 }
+@vec = global <4 x i16> <i16 -1, i16 0, i16 1, i16 32767>
+@arr = global [3 x double] [double 1.0, double 0x7FF8000000000001, double -0.0]
+
+; CHECK: @vec = global <4 x i16> <i16 -1, i16 0, i16 1, i16 32767>
+; CHECK: @arr = global [3 x double] [double 1.000000e+00, double 0x7FF8000000000001, double -0.000000e+00]
+
+declare void @ext(i32) nounwind readnone
+
+; CHECK: define i32 @a(i32)
+define i32 @a(i32) !dbg !4 {
+; CHECK: %2 = add i32 %0, 1
+  %2 = add i32 %0, 1, !md !7
+  call void @ext(i32 %2) #0
+  ret i32 %2
+}
+
+; CHECK: define <4 x float> @b(<4 x float>, %named*)
+define <4 x float> @b(<4 x float>, %named*) {
+  br label %3
+
+; <label>:3:
+; CHECK: fadd <4 x float> %0, <float 1.000000e+00, float -2.000000e+00, float 5.000000e-01, float 0x36A0000000000000>
+  %4 = fadd <4 x float> %0, <float 1.0, float -2.0, float 0.5, float 0x36A0000000000000>
+  %5 = getelementptr %named, %named* %1, i32 0, i32 1, i32 2
+  %6 = load i8, i8* %5, !md !8
+  ret <4 x float> %4
+}
+
+define void @c() !md !9 {
+  call void @ext(i32 ptrtoint (%0* @0 to i32)) #1
+  ret void
+}
+
+; CHECK: attributes #0 = { nounwind readnone }
+; CHECK: attributes #1 = { cold }
+; CHECK: attributes #2 = { noinline }
+attributes #0 = { cold }
+attributes #1 = { noinline }
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "t.c", directory: "/")
+!2 = !{}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = distinct !DISubprogram(name: "a", scope: !1, file: !1, line: 1, type: !5, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: false, unit: !0, variables: !2)
+!5 = !DISubroutineType(types: !6)
+!6 = !{null}
+!7 = !{!"first"}
+!8 = !{!"second", !7}
+!9 = !{!"third"}
@@ -0,0 +1,39 @@
+; Test to check the relative block frequency of the call edges in the summary.
+; RUN: opt -module-summary -write-relbf-to-summary %s -o %t.o
+; RUN: llvm-bcanalyzer -dump %t.o | FileCheck %s
+
+; Without the option, the summary has no block frequency.
+; RUN: opt -module-summary %s -o %t2.o
+; RUN: llvm-bcanalyzer -dump %t2.o | FileCheck %s --check-prefix=NORELBF
+
+; CHECK:       <GLOBALVAL_SUMMARY_BLOCK
+; CHECK-NEXT:    <VERSION
+; func is called twice per call of main: 2 << 8 with unknown hotness. coldfunc
+; is called too rarely for 8 fractional bits, but still gets the smallest
+; known frequency rather than 0, which means unknown.
+; CHECK-NEXT:    <PERMODULE_RELBF {{.*}} op6=0 op7=512 op8={{[0-9]+}} op9=0 op10=1/>
+; CHECK-NEXT:  </GLOBALVAL_SUMMARY_BLOCK>
+
+; NORELBF:       <PERMODULE {{.*}}/>
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define i32 @main(i1 %c) {
+entry:
+  call void @func()
+  call void @func()
+  br i1 %c, label %cold, label %exit, !prof !0
+
+cold:
+  call void @coldfunc()
+  br label %exit
+
+exit:
+  ret i32 0
+}
+
+declare void @func()
+declare void @coldfunc()
+
+!0 = !{!"branch_weights", i32 1, i32 1000000}
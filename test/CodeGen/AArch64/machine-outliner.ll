@@ -1,4 +1,6 @@
 ; RUN: llc -enable-machine-outliner -mtriple=aarch64-apple-darwin < %s | FileCheck %s
+; RUN: llc -enable-machine-outliner -outliner-repeat-finder=suffix-array \
+; RUN:   -mtriple=aarch64-apple-darwin < %s | FileCheck %s
 
 define void @cat() #0 {
 ; CHECK-LABEL: _cat:
@@ -0,0 +1,21 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -global-isel-abort=2 \
+; RUN:   -stats -o /dev/null %s 2>&1 | FileCheck %s
+; REQUIRES: asserts
+
+; The fallback rate of GlobalISel is the functions reset over those reset and
+; kept, and the failures are counted by the phase they happened in.
+
+; CHECK: warning: Instruction selection used fallback path for test_udiv
+; CHECK-DAG: 1 globalisel-utils - Number of functions that fell back in the Legalizer
+; CHECK-DAG: 1 reset-machine-function - Number of functions kept after selection
+; CHECK-DAG: 1 reset-machine-function - Number of functions reset
+
+define i32 @test_udiv(i32 %a, i32 %b) {
+  %r = udiv i32 %a, %b
+  ret i32 %r
+}
+
+define i32 @test_add(i32 %a, i32 %b) {
+  %r = add i32 %a, %b
+  ret i32 %r
+}
@@ -0,0 +1,119 @@
+; NOTE: Assertions have been autogenerated by utils/update_llc_test_checks.py
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -global-isel-abort=1 -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X64
+; RUN: llc -mtriple=i386-linux-gnu   -global-isel -global-isel-abort=1 -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X32
+
+define i32 @test_phi_loop(i32 %n) {
+; X64-LABEL: test_phi_loop:
+; X64:       # BB#0: # %entry
+; X64-NEXT:    xorl %ecx, %ecx
+; X64-NEXT:    xorl %eax, %eax
+; X64-NEXT:  .LBB0_1: # %loop
+; X64-NEXT:    # =>This Inner Loop Header: Depth=1
+; X64-NEXT:    addl %ecx, %eax
+; X64-NEXT:    incl %ecx
+; X64-NEXT:    cmpl %ecx, %edi
+; X64-NEXT:    sete %dl
+; X64-NEXT:    testb $1, %dl
+; X64-NEXT:    je .LBB0_1
+; X64-NEXT:  # BB#2: # %exit
+; X64-NEXT:    retq
+;
+; X32-LABEL: test_phi_loop:
+; X32:       # BB#0: # %entry
+; X32-NEXT:    pushl %ebx
+; X32-NEXT:  .Lcfi0:
+; X32-NEXT:    .cfi_def_cfa_offset 8
+; X32-NEXT:  .Lcfi1:
+; X32-NEXT:    .cfi_offset %ebx, -8
+; X32-NEXT:    movl {{[0-9]+}}(%esp), %ecx
+; X32-NEXT:    xorl %edx, %edx
+; X32-NEXT:    xorl %eax, %eax
+; X32-NEXT:  .LBB0_1: # %loop
+; X32-NEXT:    # =>This Inner Loop Header: Depth=1
+; X32-NEXT:    addl %edx, %eax
+; X32-NEXT:    incl %edx
+; X32-NEXT:    cmpl %edx, %ecx
+; X32-NEXT:    sete %bl
+; X32-NEXT:    testb $1, %bl
+; X32-NEXT:    je .LBB0_1
+; X32-NEXT:  # BB#2: # %exit
+; X32-NEXT:    popl %ebx
+; X32-NEXT:    retl
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %sum.next, %loop ]
+  %sum.next = add i32 %sum, %i
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %sum.next
+}
+
+define i8* @test_phi_ptr(i1 %c, i8* %a, i8* %b) {
+; X64-LABEL: test_phi_ptr:
+; X64:       # BB#0: # %entry
+; X64-NEXT:    testb $1, %dil
+; X64-NEXT:    je .LBB1_2
+; X64-NEXT:  # BB#1: # %then
+; X64-NEXT:    movq %rdx, %rsi
+; X64-NEXT:  .LBB1_2: # %exit
+; X64-NEXT:    movq %rsi, %rax
+; X64-NEXT:    retq
+;
+; X32-LABEL: test_phi_ptr:
+; X32:       # BB#0: # %entry
+; X32-NEXT:    testb $1, {{[0-9]+}}(%esp)
+; X32-NEXT:    je .LBB1_1
+; X32-NEXT:  # BB#2: # %then
+; X32-NEXT:    movl {{[0-9]+}}(%esp), %eax
+; X32-NEXT:    retl
+; X32-NEXT:  .LBB1_1:
+; X32-NEXT:    movl {{[0-9]+}}(%esp), %eax
+; X32-NEXT:    retl
+entry:
+  br i1 %c, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %p = phi i8* [ %a, %entry ], [ %b, %then ]
+  ret i8* %p
+}
+
+define i1 @test_phi_i1(i1 %c, i1 %a, i1 %b) {
+; X64-LABEL: test_phi_i1:
+; X64:       # BB#0: # %entry
+; X64-NEXT:    testb $1, %dil
+; X64-NEXT:    je .LBB2_2
+; X64-NEXT:  # BB#1: # %then
+; X64-NEXT:    movl %edx, %esi
+; X64-NEXT:  .LBB2_2: # %exit
+; X64-NEXT:    movl %esi, %eax
+; X64-NEXT:    retq
+;
+; X32-LABEL: test_phi_i1:
+; X32:       # BB#0: # %entry
+; X32-NEXT:    testb $1, {{[0-9]+}}(%esp)
+; X32-NEXT:    je .LBB2_1
+; X32-NEXT:  # BB#2: # %then
+; X32-NEXT:    movb {{[0-9]+}}(%esp), %al
+; X32-NEXT:    retl
+; X32-NEXT:  .LBB2_1:
+; X32-NEXT:    movb {{[0-9]+}}(%esp), %al
+; X32-NEXT:    retl
+entry:
+  br i1 %c, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %r = phi i1 [ %a, %entry ], [ %b, %then ]
+  ret i1 %r
+}
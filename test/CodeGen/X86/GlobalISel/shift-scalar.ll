@@ -0,0 +1,56 @@
+; RUN: llc -mtriple=x86_64-linux-gnu -global-isel -global-isel-abort=1 -verify-machineinstrs < %s -o - | FileCheck %s --check-prefix=ALL --check-prefix=X64
+; The 64-bit shift is not legal on i386, so only that function may fall back
+; there, and its checks only run for x86_64.
+; RUN: llc -mtriple=i386-linux-gnu -global-isel -global-isel-abort=2 -verify-machineinstrs < %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=X32-FALLBACK
+; RUN: llc -mtriple=i386-linux-gnu -global-isel -global-isel-abort=2 -verify-machineinstrs < %s -o - 2>/dev/null | FileCheck %s --check-prefix=ALL
+
+; X32-FALLBACK: warning: Instruction selection used fallback path for test_shl_i64
+; X32-FALLBACK-NOT: fallback path
+
+define i64 @test_shl_i64(i64 %arg1, i64 %arg2) {
+; X64-LABEL: test_shl_i64:
+; X64:         shlq %cl, %{{[a-z]+}}
+; X64:         retq
+  %res = shl i64 %arg1, %arg2
+  ret i64 %res
+}
+
+define i32 @test_shl_i32(i32 %arg1, i32 %arg2) {
+; ALL-LABEL: test_shl_i32:
+; ALL:         shll %cl, %{{[a-z]+}}
+; ALL:         ret
+  %res = shl i32 %arg1, %arg2
+  ret i32 %res
+}
+
+define i32 @test_lshr_i32(i32 %arg1, i32 %arg2) {
+; ALL-LABEL: test_lshr_i32:
+; ALL:         shrl %cl, %{{[a-z]+}}
+; ALL:         ret
+  %res = lshr i32 %arg1, %arg2
+  ret i32 %res
+}
+
+define i32 @test_ashr_i32_imm(i32 %arg1) {
+; ALL-LABEL: test_ashr_i32_imm:
+; ALL:         sarl %cl, %{{[a-z]+}}
+; ALL:         ret
+  %res = ashr i32 %arg1, 5
+  ret i32 %res
+}
+
+define i16 @test_ashr_i16(i16 %arg1, i16 %arg2) {
+; ALL-LABEL: test_ashr_i16:
+; ALL:         sarw %cl, %{{[a-z]+}}
+; ALL:         ret
+  %res = ashr i16 %arg1, %arg2
+  ret i16 %res
+}
+
+define i8 @test_lshr_i8(i8 %arg1, i8 %arg2) {
+; ALL-LABEL: test_lshr_i8:
+; ALL:         shrb %cl, %{{[a-z]+}}
+; ALL:         ret
+  %res = lshr i8 %arg1, %arg2
+  ret i8 %res
+}
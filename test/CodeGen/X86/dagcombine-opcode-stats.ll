@@ -0,0 +1,13 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -combiner-opcode-stats \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s
+
+; CHECK: DAG combines by opcode
+; CHECK: Hits{{ +}}Visits{{ +}}Opcode
+; The multiplication is combined into a shift, which is visited in turn.
+; CHECK-NEXT: {{^ +}}1{{ +}}1{{ +}}mul
+; CHECK: {{^ +}}0{{ +}}{{[0-9]+}}{{ +}}shl
+
+define i32 @f(i32 %x) {
+  %b = mul i32 %x, 8
+  ret i32 %b
+}
@@ -0,0 +1,25 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -stats < %s -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s
+; REQUIRES: asserts
+
+; The nodes created by each phase of DAG instruction selection are counted
+; over the blocks of the function.
+
+; CHECK-DAG: {{[0-9]+}} isel{{ +}}- Number of DAG nodes built from IR
+; CHECK-DAG: {{[0-9]+}} isel{{ +}}- Number of DAG nodes created by instruction selection
+
+define i32 @f(i32* %p, i32 %x) {
+entry:
+  %v = load i32, i32* %p
+  %c = icmp eq i32 %v, 0
+  br i1 %c, label %a, label %b
+
+a:
+  %m = mul i32 %v, %x
+  ret i32 %m
+
+b:
+  %s = shl i32 %v, 3
+  %t = add i32 %s, %x
+  ret i32 %t
+}
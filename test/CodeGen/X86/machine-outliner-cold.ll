@@ -0,0 +1,87 @@
+; RUN: llc -enable-machine-outliner -mtriple=x86_64-apple-darwin < %s \
+; RUN:   | FileCheck %s
+; RUN: llc -enable-machine-outliner -outliner-cold-only \
+; RUN:   -mtriple=x86_64-apple-darwin < %s | FileCheck %s --check-prefix=COLD
+
+; Without a profile, -outliner-cold-only only outlines from blocks that are
+; much less frequent than their function's entry, and leaves the loops alone.
+
+; CHECK-LABEL: _f:
+; CHECK-NOT: movl $1, (%rdi)
+; CHECK-NOT: movl $5, (%rdi)
+; CHECK-LABEL: _g:
+; CHECK-NOT: movl $1, (%rdi)
+; CHECK-NOT: movl $5, (%rdi)
+; CHECK: l_OUTLINED_FUNCTION_{{[0-9]+}}:
+
+; COLD-LABEL: _f:
+; COLD-NOT: movl $1, (%rdi)
+; COLD: movl $5, (%rdi)
+; COLD-NOT: movl $1, (%rdi)
+; COLD-LABEL: _g:
+; COLD-NOT: movl $1, (%rdi)
+; COLD: movl $5, (%rdi)
+; COLD-NOT: movl $1, (%rdi)
+; COLD-LABEL: l_OUTLINED_FUNCTION_0:
+; COLD: movl $1, (%rdi)
+; COLD-NOT: movl $5, (%rdi)
+
+define void @f(i32* %a, i32 %n, i1 %rare) #0 {
+entry:
+  %b = getelementptr i32, i32* %a, i64 1
+  %c = getelementptr i32, i32* %a, i64 2
+  %d = getelementptr i32, i32* %a, i64 3
+  br i1 %rare, label %cold, label %loop, !prof !0
+
+cold:
+  store volatile i32 1, i32* %a, align 4
+  store volatile i32 2, i32* %b, align 4
+  store volatile i32 3, i32* %c, align 4
+  store volatile i32 4, i32* %d, align 4
+  ret void
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  store volatile i32 5, i32* %a, align 4
+  store volatile i32 6, i32* %b, align 4
+  store volatile i32 7, i32* %c, align 4
+  store volatile i32 8, i32* %d, align 4
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+define void @g(i32* %a, i32 %n, i1 %rare) #0 {
+entry:
+  %b = getelementptr i32, i32* %a, i64 1
+  %c = getelementptr i32, i32* %a, i64 2
+  %d = getelementptr i32, i32* %a, i64 3
+  br i1 %rare, label %cold, label %loop, !prof !0
+
+cold:
+  store volatile i32 1, i32* %a, align 4
+  store volatile i32 2, i32* %b, align 4
+  store volatile i32 3, i32* %c, align 4
+  store volatile i32 4, i32* %d, align 4
+  ret void
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  store volatile i32 5, i32* %a, align 4
+  store volatile i32 6, i32* %b, align 4
+  store volatile i32 7, i32* %c, align 4
+  store volatile i32 8, i32* %d, align 4
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+attributes #0 = { noredzone nounwind ssp uwtable "no-frame-pointer-elim"="false" }
+
+!0 = !{!"branch_weights", i32 1, i32 1000}
@@ -0,0 +1,95 @@
+; RUN: llc -enable-machine-outliner -mtriple=x86_64-apple-darwin < %s \
+; RUN:   | FileCheck %s
+
+; With a profile, blocks with a hot count are never outlined from, so only the
+; rarely taken paths are outlined and the loops keep their stores.
+
+; CHECK-LABEL: _f:
+; CHECK-NOT: movl $1, (%rdi)
+; CHECK: movl $5, (%rdi)
+; CHECK-NOT: movl $1, (%rdi)
+; CHECK-LABEL: _g:
+; CHECK-NOT: movl $1, (%rdi)
+; CHECK: movl $5, (%rdi)
+; CHECK-NOT: movl $1, (%rdi)
+; CHECK-LABEL: l_OUTLINED_FUNCTION_0:
+; CHECK: movl $1, (%rdi)
+; CHECK-NOT: movl $5, (%rdi)
+
+define void @f(i32* %a, i32 %n, i1 %rare) #0 !prof !1 {
+entry:
+  %b = getelementptr i32, i32* %a, i64 1
+  %c = getelementptr i32, i32* %a, i64 2
+  %d = getelementptr i32, i32* %a, i64 3
+  br i1 %rare, label %cold, label %loop, !prof !0
+
+cold:
+  store volatile i32 1, i32* %a, align 4
+  store volatile i32 2, i32* %b, align 4
+  store volatile i32 3, i32* %c, align 4
+  store volatile i32 4, i32* %d, align 4
+  ret void
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  store volatile i32 5, i32* %a, align 4
+  store volatile i32 6, i32* %b, align 4
+  store volatile i32 7, i32* %c, align 4
+  store volatile i32 8, i32* %d, align 4
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit, !prof !2
+
+exit:
+  ret void
+}
+
+define void @g(i32* %a, i32 %n, i1 %rare) #0 !prof !1 {
+entry:
+  %b = getelementptr i32, i32* %a, i64 1
+  %c = getelementptr i32, i32* %a, i64 2
+  %d = getelementptr i32, i32* %a, i64 3
+  br i1 %rare, label %cold, label %loop, !prof !0
+
+cold:
+  store volatile i32 1, i32* %a, align 4
+  store volatile i32 2, i32* %b, align 4
+  store volatile i32 3, i32* %c, align 4
+  store volatile i32 4, i32* %d, align 4
+  ret void
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  store volatile i32 5, i32* %a, align 4
+  store volatile i32 6, i32* %b, align 4
+  store volatile i32 7, i32* %c, align 4
+  store volatile i32 8, i32* %d, align 4
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit, !prof !2
+
+exit:
+  ret void
+}
+
+attributes #0 = { noredzone nounwind ssp uwtable "no-frame-pointer-elim"="false" }
+
+!0 = !{!"branch_weights", i32 1, i32 1000}
+!1 = !{!"function_entry_count", i64 1000}
+!2 = !{!"branch_weights", i32 1000, i32 1}
+
+!llvm.module.flags = !{!3}
+!3 = !{i32 1, !"ProfileSummary", !4}
+!4 = !{!5, !6, !7, !8, !9, !10, !11, !12}
+!5 = !{!"ProfileFormat", !"InstrProf"}
+!6 = !{!"TotalCount", i64 2000000}
+!7 = !{!"MaxCount", i64 1000000}
+!8 = !{!"MaxInternalCount", i64 1000000}
+!9 = !{!"MaxFunctionCount", i64 1000}
+!10 = !{!"NumCounts", i64 6}
+!11 = !{!"NumFunctions", i64 2}
+!12 = !{!"DetailedSummary", !13}
+!13 = !{!14, !15, !16}
+!14 = !{i32 10000, i64 1000000, i32 2}
+!15 = !{i32 999000, i64 1000, i32 4}
+!16 = !{i32 999999, i64 1000, i32 4}
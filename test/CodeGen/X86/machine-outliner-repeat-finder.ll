@@ -0,0 +1,13 @@
+; The suffix tree and the suffix array find the same candidates.
+; RUN: llc -enable-machine-outliner -mtriple=x86_64-apple-darwin \
+; RUN:   < %S/machine-outliner.ll > %t.tree.s
+; RUN: llc -enable-machine-outliner -mtriple=x86_64-apple-darwin \
+; RUN:   -outliner-repeat-finder=suffix-array < %S/machine-outliner.ll \
+; RUN:   > %t.array.s
+; RUN: diff %t.tree.s %t.array.s
+; RUN: llc -enable-machine-outliner -mtriple=x86_64-apple-darwin \
+; RUN:   < %S/machine-outliner-tailcalls.ll > %t.tree.s
+; RUN: llc -enable-machine-outliner -mtriple=x86_64-apple-darwin \
+; RUN:   -outliner-repeat-finder=suffix-array \
+; RUN:   < %S/machine-outliner-tailcalls.ll > %t.array.s
+; RUN: diff %t.tree.s %t.array.s
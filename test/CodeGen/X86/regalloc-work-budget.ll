@@ -0,0 +1,126 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -verify-machineinstrs \
+; RUN:   -pass-remarks-missed=regalloc < %s -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=NOBUDGET
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -verify-machineinstrs \
+; RUN:   -regalloc-work-budget=1000000 -pass-remarks-missed=regalloc < %s \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=NOBUDGET
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -verify-machineinstrs \
+; RUN:   -regalloc-work-budget=1 -pass-remarks-missed=regalloc < %s \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s
+
+; A function that is over its work budget is still allocated correctly, with
+; its spillable ranges spilled instead of split, and is reported.
+
+; CHECK: remark: {{.*}}register allocation used {{[0-9]+}} work units, over its budget of 1
+; NOBUDGET-NOT: work units
+
+define i32 @pressure(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %sum0, %loop ]
+  %a0.p = getelementptr inbounds i32, i32* %p, i32 0
+  %a0 = load volatile i32, i32* %a0.p, align 4
+  %a1.p = getelementptr inbounds i32, i32* %p, i32 1
+  %a1 = load volatile i32, i32* %a1.p, align 4
+  %a2.p = getelementptr inbounds i32, i32* %p, i32 2
+  %a2 = load volatile i32, i32* %a2.p, align 4
+  %a3.p = getelementptr inbounds i32, i32* %p, i32 3
+  %a3 = load volatile i32, i32* %a3.p, align 4
+  %a4.p = getelementptr inbounds i32, i32* %p, i32 4
+  %a4 = load volatile i32, i32* %a4.p, align 4
+  %a5.p = getelementptr inbounds i32, i32* %p, i32 5
+  %a5 = load volatile i32, i32* %a5.p, align 4
+  %a6.p = getelementptr inbounds i32, i32* %p, i32 6
+  %a6 = load volatile i32, i32* %a6.p, align 4
+  %a7.p = getelementptr inbounds i32, i32* %p, i32 7
+  %a7 = load volatile i32, i32* %a7.p, align 4
+  %a8.p = getelementptr inbounds i32, i32* %p, i32 8
+  %a8 = load volatile i32, i32* %a8.p, align 4
+  %a9.p = getelementptr inbounds i32, i32* %p, i32 9
+  %a9 = load volatile i32, i32* %a9.p, align 4
+  %a10.p = getelementptr inbounds i32, i32* %p, i32 10
+  %a10 = load volatile i32, i32* %a10.p, align 4
+  %a11.p = getelementptr inbounds i32, i32* %p, i32 11
+  %a11 = load volatile i32, i32* %a11.p, align 4
+  %a12.p = getelementptr inbounds i32, i32* %p, i32 12
+  %a12 = load volatile i32, i32* %a12.p, align 4
+  %a13.p = getelementptr inbounds i32, i32* %p, i32 13
+  %a13 = load volatile i32, i32* %a13.p, align 4
+  %a14.p = getelementptr inbounds i32, i32* %p, i32 14
+  %a14 = load volatile i32, i32* %a14.p, align 4
+  %a15.p = getelementptr inbounds i32, i32* %p, i32 15
+  %a15 = load volatile i32, i32* %a15.p, align 4
+  %a16.p = getelementptr inbounds i32, i32* %p, i32 16
+  %a16 = load volatile i32, i32* %a16.p, align 4
+  %a17.p = getelementptr inbounds i32, i32* %p, i32 17
+  %a17 = load volatile i32, i32* %a17.p, align 4
+  %a18.p = getelementptr inbounds i32, i32* %p, i32 18
+  %a18 = load volatile i32, i32* %a18.p, align 4
+  %a19.p = getelementptr inbounds i32, i32* %p, i32 19
+  %a19 = load volatile i32, i32* %a19.p, align 4
+  %a20.p = getelementptr inbounds i32, i32* %p, i32 20
+  %a20 = load volatile i32, i32* %a20.p, align 4
+  %a21.p = getelementptr inbounds i32, i32* %p, i32 21
+  %a21 = load volatile i32, i32* %a21.p, align 4
+  %a22.p = getelementptr inbounds i32, i32* %p, i32 22
+  %a22 = load volatile i32, i32* %a22.p, align 4
+  %a23.p = getelementptr inbounds i32, i32* %p, i32 23
+  %a23 = load volatile i32, i32* %a23.p, align 4
+  %m23 = mul i32 %a23, %acc
+  %sum23 = add i32 %m23, %a0
+  %m22 = mul i32 %a22, %sum23
+  %sum22 = add i32 %m22, %a23
+  %m21 = mul i32 %a21, %sum22
+  %sum21 = add i32 %m21, %a22
+  %m20 = mul i32 %a20, %sum21
+  %sum20 = add i32 %m20, %a21
+  %m19 = mul i32 %a19, %sum20
+  %sum19 = add i32 %m19, %a20
+  %m18 = mul i32 %a18, %sum19
+  %sum18 = add i32 %m18, %a19
+  %m17 = mul i32 %a17, %sum18
+  %sum17 = add i32 %m17, %a18
+  %m16 = mul i32 %a16, %sum17
+  %sum16 = add i32 %m16, %a17
+  %m15 = mul i32 %a15, %sum16
+  %sum15 = add i32 %m15, %a16
+  %m14 = mul i32 %a14, %sum15
+  %sum14 = add i32 %m14, %a15
+  %m13 = mul i32 %a13, %sum14
+  %sum13 = add i32 %m13, %a14
+  %m12 = mul i32 %a12, %sum13
+  %sum12 = add i32 %m12, %a13
+  %m11 = mul i32 %a11, %sum12
+  %sum11 = add i32 %m11, %a12
+  %m10 = mul i32 %a10, %sum11
+  %sum10 = add i32 %m10, %a11
+  %m9 = mul i32 %a9, %sum10
+  %sum9 = add i32 %m9, %a10
+  %m8 = mul i32 %a8, %sum9
+  %sum8 = add i32 %m8, %a9
+  %m7 = mul i32 %a7, %sum8
+  %sum7 = add i32 %m7, %a8
+  %m6 = mul i32 %a6, %sum7
+  %sum6 = add i32 %m6, %a7
+  %m5 = mul i32 %a5, %sum6
+  %sum5 = add i32 %m5, %a6
+  %m4 = mul i32 %a4, %sum5
+  %sum4 = add i32 %m4, %a5
+  %m3 = mul i32 %a3, %sum4
+  %sum3 = add i32 %m3, %a4
+  %m2 = mul i32 %a2, %sum3
+  %sum2 = add i32 %m2, %a3
+  %m1 = mul i32 %a1, %sum2
+  %sum1 = add i32 %m1, %a2
+  %m0 = mul i32 %a0, %sum1
+  %sum0 = add i32 %m0, %a1
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %sum0
+}
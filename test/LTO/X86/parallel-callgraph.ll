@@ -0,0 +1,49 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: llvm-lto -exported-symbol=foo -exported-symbol=bar -exported-symbol=baz \
+; RUN:   -j2 -callgraph-partitioning -o %t.o %t.bc
+; RUN: llvm-nm %t.o.0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t.o.1 | FileCheck --check-prefix=CHECK1 %s
+
+; RUN: llvm-lto2 run -o %t2.o %t.bc -lto-partitions=2 \
+; RUN:   -lto-partitioning=callgraph \
+; RUN:   -r=%t.bc,foo,plx -r=%t.bc,bar,plx -r=%t.bc,baz,plx \
+; RUN:   -r=%t.bc,ext1,x -r=%t.bc,ext2,x -r=%t.bc,ext3,x \
+; RUN:   -r=%t.bc,ext4,x
+; RUN: llvm-nm %t2.o.0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t2.o.1 | FileCheck --check-prefix=CHECK1 %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Unlike with the default partitioning (see parallel.ll), foo and bar, which
+; call each other, are code generated together, and baz, which is larger than
+; both and so placed first, separately.
+
+; CHECK1: T bar
+; CHECK1-NOT: baz
+; CHECK1: T foo
+define void @foo() noinline {
+  call void @bar()
+  ret void
+}
+
+define void @bar() noinline {
+  call void @foo()
+  ret void
+}
+
+; CHECK0-NOT: foo
+; CHECK0: T baz
+; CHECK0-NOT: foo
+define void @baz() noinline {
+  call void @ext1()
+  call void @ext2()
+  call void @ext3()
+  call void @ext4()
+  ret void
+}
+
+declare void @ext1()
+declare void @ext2()
+declare void @ext3()
+declare void @ext4()
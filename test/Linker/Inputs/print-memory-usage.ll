@@ -0,0 +1,6 @@
+declare i32 @f()
+
+define i32 @h() {
+  %x = call i32 @f()
+  ret i32 %x
+}
@@ -0,0 +1,44 @@
+; RUN: llvm-link -disable-debug-info-type-map %s \
+; RUN:   %p/Inputs/compact-debug-info.ll -S -o - \
+; RUN:   | FileCheck %s --check-prefix=NOCOMPACT
+; RUN: llvm-link -disable-debug-info-type-map -compact-debug-info %s \
+; RUN:   %p/Inputs/compact-debug-info.ll -S -o - | FileCheck %s
+
+; Both modules describe struct A. Without ODR uniquing the linked module keeps
+; a copy from each, and -compact-debug-info merges them into the first one.
+
+; NOCOMPACT: identifier: "_ZTS1A"
+; NOCOMPACT: identifier: "_ZTS1A"
+
+; CHECK: define void @f(%struct.A* %a) !dbg [[F:![0-9]+]]
+; CHECK: define void @g(%struct.A* %a) !dbg [[G:![0-9]+]]
+; CHECK: [[F]] = distinct !DISubprogram(name: "f", {{.*}}type: [[FTY:![0-9]+]]
+; CHECK: [[FTY]] = !DISubroutineType(types: [[TYPES:![0-9]+]])
+; CHECK: [[TYPES]] = !{null, [[PTR:![0-9]+]]}
+; CHECK: [[PTR]] = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: [[A:![0-9]+]]
+; CHECK: [[A]] = distinct !DICompositeType(tag: DW_TAG_structure_type, name: "A", {{.*}}identifier: "_ZTS1A")
+; CHECK: [[G]] = distinct !DISubprogram(name: "g", {{.*}}type: [[FTY]]
+; CHECK-NOT: identifier: "_ZTS1A"
+
+%struct.A = type { i32 }
+
+define void @f(%struct.A* %a) !dbg !6 {
+  ret void, !dbg !14
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "f.cpp", directory: "/tmp")
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !DIFile(filename: "a.h", directory: "/tmp")
+!6 = distinct !DISubprogram(name: "f", linkageName: "_Z1fP1A", scope: !1, file: !1, line: 2, type: !7, isLocal: false, isDefinition: true, scopeLine: 2, isOptimized: false, unit: !0)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null, !9}
+!9 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !10, size: 64)
+!10 = distinct !DICompositeType(tag: DW_TAG_structure_type, name: "A", file: !5, line: 1, size: 32, elements: !11, identifier: "_ZTS1A")
+!11 = !{!12}
+!12 = !DIDerivedType(tag: DW_TAG_member, name: "x", scope: !10, file: !5, line: 1, baseType: !13, size: 32)
+!13 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!14 = !DILocation(line: 2, scope: !6)
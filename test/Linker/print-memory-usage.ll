@@ -0,0 +1,14 @@
+; RUN: llvm-link %s %S/Inputs/print-memory-usage.ll -print-memory-usage \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s
+
+; The linked module has five operands: the initializer of @g, the pointer of
+; the load and the value of each return, and the callee of the call.
+; CHECK: llvm-link{{[^:]*}}: 5 operands, 0 KiB of Use storage
+; CHECK-NEXT: llvm-link{{[^:]*}}: peak resident set size {{[0-9]+}} KiB
+
+@g = global i32 1
+
+define i32 @f() {
+  %v = load i32, i32* @g
+  ret i32 %v
+}
@@ -0,0 +1,31 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-unknown %s -o %t
+# RUN: llvm-objdump -d %t | FileCheck %s
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-unknown -stats %s \
+# RUN:   -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+# REQUIRES: asserts
+
+# Relaxing the second jump pushes the target of the first one out of range,
+# so the first one is relaxed in the next layout step. The last jump only
+# spans fragments that never change size, so it is not rechecked after the
+# first step.
+
+# CHECK-LABEL: cascade:
+# CHECK-NEXT: e9 80 00 00 00 jmp 128
+# CHECK-NEXT: e9 43 01 00 00 jmp 323
+# CHECK:      eb 00 jmp 0
+# CHECK-NEXT: c3 retq
+
+# STATS-DAG: 6 assembler - Number of relaxable fragments not rechecked in a layout step
+# STATS-DAG: 2 assembler - Number of relaxed instructions
+
+	.text
+cascade:
+	jmp .La
+	jmp .Lb
+	.fill 123, 1, 0x90
+.La:
+	.fill 200, 1, 0x90
+.Lb:
+	jmp .Lc
+.Lc:
+	retq
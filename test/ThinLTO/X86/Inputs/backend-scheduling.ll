@@ -0,0 +1,10 @@
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define i32 @medium(i32 %a) {
+entry:
+  %b = mul i32 %a, %a
+  %c = add i32 %b, %a
+  %d = mul i32 %c, %b
+  ret i32 %d
+}
@@ -0,0 +1,14 @@
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @frequent() {
+  ret void
+}
+
+define void @rare() {
+  ret void
+}
+
+define void @cold() {
+  ret void
+}
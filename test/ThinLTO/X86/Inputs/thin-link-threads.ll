@@ -0,0 +1,23 @@
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+declare void @dead_func()
+
+define linkonce_odr void @linkonce_func() {
+  ret void
+}
+
+define void @baz() {
+  call void @linkonce_func()
+  ret void
+}
+
+define void @bar() {
+  call void @baz()
+  ret void
+}
+
+define void @another_dead_func() {
+  call void @dead_func()
+  ret void
+}
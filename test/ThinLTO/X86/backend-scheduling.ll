@@ -0,0 +1,91 @@
+; RUN: opt -module-summary %s -o %t.bc
+; RUN: opt -module-summary %p/Inputs/cache.ll -o %t2.bc
+; RUN: opt -module-summary %p/Inputs/backend-scheduling.ll -o %t3.bc
+
+; RUN: llvm-lto2 run -o %t.ref.o %t2.bc %t.bc %t3.bc \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx \
+; RUN:  -r=%t.bc,_big,plx \
+; RUN:  -r=%t3.bc,_medium,plx
+
+; With 1 MiB per instruction, the jobs of %t.bc, %t3.bc and %t2.bc are
+; estimated at 10, 4 and 3 MiB. A budget of 14 MiB runs the two largest at
+; once, and the last one when a thread and enough of the budget are free.
+; RUN: llvm-lto2 run -o %t.sched.o %t2.bc %t.bc %t3.bc -thinlto-threads=4 \
+; RUN:  -thinlto-bytes-per-inst=1048576 -thinlto-memory-budget=14 \
+; RUN:  -thinlto-job-report \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx \
+; RUN:  -r=%t.bc,_big,plx \
+; RUN:  -r=%t3.bc,_medium,plx 2>&1 | FileCheck %s --check-prefixes=CHECK,TWO
+; RUN: cmp %t.ref.o.0 %t.sched.o.0
+; RUN: cmp %t.ref.o.1 %t.sched.o.1
+; RUN: cmp %t.ref.o.2 %t.sched.o.2
+
+; A budget for all the jobs runs them all at once.
+; RUN: llvm-lto2 run -o %t.sched.o %t2.bc %t.bc %t3.bc -thinlto-threads=4 \
+; RUN:  -thinlto-bytes-per-inst=1048576 -thinlto-memory-budget=1024 \
+; RUN:  -thinlto-job-report \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx \
+; RUN:  -r=%t.bc,_big,plx \
+; RUN:  -r=%t3.bc,_medium,plx 2>&1 | FileCheck %s --check-prefixes=CHECK,THREE
+
+; The threads still limit the jobs running at once.
+; RUN: llvm-lto2 run -o %t.sched.o %t2.bc %t.bc %t3.bc -thinlto-threads=2 \
+; RUN:  -thinlto-bytes-per-inst=1048576 -thinlto-memory-budget=1024 \
+; RUN:  -thinlto-job-report \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx \
+; RUN:  -r=%t.bc,_big,plx \
+; RUN:  -r=%t3.bc,_medium,plx 2>&1 | FileCheck %s --check-prefixes=CHECK,TWO
+
+; The jobs only run one at a time when no two fit in the budget. Jobs too
+; large for the budget still run.
+; RUN: llvm-lto2 run -o %t.sched.o %t2.bc %t.bc %t3.bc -thinlto-threads=4 \
+; RUN:  -thinlto-bytes-per-inst=1048576 -thinlto-memory-budget=6 \
+; RUN:  -thinlto-job-report \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx \
+; RUN:  -r=%t.bc,_big,plx \
+; RUN:  -r=%t3.bc,_medium,plx 2>&1 | FileCheck %s --check-prefixes=CHECK,ONE
+; RUN: cmp %t.ref.o.0 %t.sched.o.0
+; RUN: cmp %t.ref.o.1 %t.sched.o.1
+; RUN: cmp %t.ref.o.2 %t.sched.o.2
+
+; The module with the most instructions is started first, although it was
+; added second.
+; CHECK: ThinLTO backend jobs
+; CHECK: Task Insts Est. MiB Start (s) Wall (s) Module
+; CHECK-NEXT: 1 10 10.0 {{.*}}.tmp.bc{{$}}
+; CHECK-NEXT: 2 4 4.0 {{.*}}.tmp3.bc{{$}}
+; CHECK-NEXT: 0 3 3.0 {{.*}}.tmp2.bc{{$}}
+; ONE-NEXT: Most jobs running at once: 1
+; TWO-NEXT: Most jobs running at once: 2
+; THREE-NEXT: Most jobs running at once: 3
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() {
+entry:
+  ret void
+}
+
+define i32 @big(i32 %a) {
+entry:
+  %b = mul i32 %a, %a
+  %c = add i32 %b, %a
+  %d = mul i32 %c, %b
+  %e = add i32 %d, %c
+  %f = mul i32 %e, %d
+  %g = add i32 %f, %e
+  %h = mul i32 %g, %f
+  %i = add i32 %h, %g
+  ret i32 %i
+}
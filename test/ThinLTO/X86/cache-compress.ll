@@ -0,0 +1,56 @@
+; REQUIRES: zlib
+
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; Build without a cache for reference.
+; RUN: llvm-lto2 run -o %t.ref.o %t2.bc %t.bc \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+
+; Entries are stored compressed, and objects are handed out uncompressed both
+; when they are built and when they are hit.
+; RUN: rm -Rf %t.cache
+; RUN: llvm-lto2 run -o %t.miss.o %t2.bc %t.bc -cache-dir %t.cache \
+; RUN:  -compress-cache-entries \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache | count 2
+; RUN: cat %t.cache/llvmcache-* | FileCheck %s
+; RUN: cmp %t.ref.o.0 %t.miss.o.0
+; RUN: cmp %t.ref.o.1 %t.miss.o.1
+; RUN: llvm-lto2 run -o %t.hit.o %t2.bc %t.bc -cache-dir %t.cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.ref.o.0 %t.hit.o.0
+; RUN: cmp %t.ref.o.1 %t.hit.o.1
+
+; CHECK: LLVMCZ
+; CHECK: LLVMCZ
+
+; An entry whose header claims an object too large for its stream, here 2^64-1
+; bytes for a stream of 256 zero bytes, is treated as a miss and replaced.
+; RUN: rm -Rf %t.cache
+; RUN: llvm-lto2 run -o %t.one.o %t.bc -cache-dir %t.cache \
+; RUN:  -compress-cache-entries \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache | count 1
+; RUN: printf 'LLVMCZ\001\377\377\377\377\377\377\377\377' > %t.forged
+; RUN: printf '\170\332\143\140\030\331\000\000\001\000\000\001' >> %t.forged
+; RUN: cp %t.forged %t.cache/llvmcache-*
+; RUN: llvm-lto2 run -o %t.forged.o %t.bc -cache-dir %t.cache \
+; RUN:  -compress-cache-entries \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.one.o.0 %t.forged.o.0
+; RUN: not cmp %t.forged %t.cache/llvmcache-*
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() {
+entry:
+  ret void
+}
@@ -0,0 +1,50 @@
+; UNSUPPORTED: windows
+
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/cache.ll -o %t2.bc
+; RUN: rm -Rf %t.cache1 %t.cache2 %t.server %t.log
+
+; The server returns once it is listening. The socket path is relative to keep
+; it short enough for sockaddr_un.
+; RUN: llvm-lto-cache-server -address=unix:%basename_t.sock \
+; RUN:   -cache-dir=%t.server -log-file=%t.log -daemonize -idle-timeout=60
+
+; A first link misses in both tiers and stores its objects in both.
+; RUN: llvm-lto2 run -o %t1.o %t2.bc %t.bc -thinlto-threads=1 \
+; RUN:   -cache-dir %t.cache1 -cache-server unix:%basename_t.sock \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache1 | count 2
+; RUN: ls %t.server/keys | count 2
+; RUN: ls %t.server/objects | count 2
+
+; A link with an empty local cache is served by the server, and the objects it
+; receives are added to the local cache.
+; RUN: llvm-lto2 run -o %t2.o %t2.bc %t.bc -thinlto-threads=1 \
+; RUN:   -cache-dir %t.cache2 -cache-server unix:%basename_t.sock \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache2 | count 2
+; RUN: cmp %t1.o.0 %t2.o.0
+; RUN: cmp %t1.o.1 %t2.o.1
+
+; RUN: llvm-lto-cache-server -address=unix:%basename_t.sock -shutdown
+; RUN: FileCheck %s < %t.log
+
+; CHECK: get [[KEY1:[0-9A-F]+]] miss
+; CHECK-NEXT: put [[KEY1]]
+; CHECK-NEXT: get [[KEY2:[0-9A-F]+]] miss
+; CHECK-NEXT: put [[KEY2]]
+; CHECK-NEXT: get [[KEY1]] hit
+; CHECK-NEXT: get [[KEY2]] hit
+; CHECK-NEXT: shutdown
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() {
+entry:
+  ret void
+}
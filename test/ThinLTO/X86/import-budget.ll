@@ -0,0 +1,87 @@
+; Check that with an import budget, the functions imported are those with the
+; best expected benefit per instruction.
+
+; RUN: opt -module-summary -write-relbf-to-summary %s -o %t1.bc
+; RUN: opt -module-summary -write-relbf-to-summary %p/Inputs/import-budget.ll \
+; RUN:   -o %t2.bc
+
+; All callees fit the import threshold.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -print-imports \
+; RUN:   -r %t1.bc,_main,plx \
+; RUN:   -r %t1.bc,_frequent, \
+; RUN:   -r %t1.bc,_rare, \
+; RUN:   -r %t1.bc,_cold, \
+; RUN:   -r %t2.bc,_frequent,pl \
+; RUN:   -r %t2.bc,_rare,pl \
+; RUN:   -r %t2.bc,_cold,pl 2>&1 | FileCheck %s --check-prefix=NOBUDGET
+; NOBUDGET-DAG: Import frequent
+; NOBUDGET-DAG: Import rare
+; NOBUDGET-DAG: Import cold
+
+; Only one of them fits a budget of one instruction: @frequent, called in a
+; loop, is expected to be called more often than @rare.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -print-imports -import-budget=1 \
+; RUN:   -r %t1.bc,_main,plx \
+; RUN:   -r %t1.bc,_frequent, \
+; RUN:   -r %t1.bc,_rare, \
+; RUN:   -r %t1.bc,_cold, \
+; RUN:   -r %t2.bc,_frequent,pl \
+; RUN:   -r %t2.bc,_rare,pl \
+; RUN:   -r %t2.bc,_cold,pl 2>&1 | FileCheck %s --check-prefix=BUDGET
+; BUDGET: 1.bc: Select {{[0-9]+}} from {{.*}}2.bc (cost 1, benefit {{[0-9]+}}.{{[0-9]+}})
+; BUDGET-NEXT: 1.bc: Selected imports cost 1 of 1 instructions, expected benefit
+; BUDGET-NOT: Import rare
+; BUDGET: Import frequent
+; BUDGET-NOT: Import rare
+
+; A budget of two instructions takes @rare, called on half of the calls of
+; @main, over @cold, whose call site is too cold to have a frequency other
+; than the smallest one, and must not be taken for an unknown frequency.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.o -print-imports -import-budget=2 \
+; RUN:   -r %t1.bc,_main,plx \
+; RUN:   -r %t1.bc,_frequent, \
+; RUN:   -r %t1.bc,_rare, \
+; RUN:   -r %t1.bc,_cold, \
+; RUN:   -r %t2.bc,_frequent,pl \
+; RUN:   -r %t2.bc,_rare,pl \
+; RUN:   -r %t2.bc,_cold,pl 2>&1 | FileCheck %s --check-prefix=BUDGET2
+; BUDGET2: 1.bc: Selected imports cost 2 of 2 instructions, expected benefit
+; BUDGET2-NOT: Import cold
+; BUDGET2-DAG: Import frequent
+; BUDGET2-DAG: Import rare
+; BUDGET2-NOT: Import cold
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define i32 @main(i32 %n, i1 %r, i1 %c) {
+entry:
+  br i1 %r, label %then, label %cond
+
+then:
+  call void @rare()
+  br label %cond
+
+cond:
+  br i1 %c, label %cold, label %loop, !prof !0
+
+cold:
+  call void @cold()
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %cond ], [ 0, %cold ], [ %inc, %loop ]
+  call void @frequent()
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 0
+}
+
+declare void @frequent()
+declare void @rare()
+declare void @cold()
+
+!0 = !{!"branch_weights", i32 1, i32 1000000}
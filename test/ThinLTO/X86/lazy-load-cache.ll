@@ -0,0 +1,45 @@
+; Check that the backends importing from the same module share the indexes
+; built when loading it.
+; REQUIRES: asserts
+
+; RUN: opt -module-summary %s -o %t.bc -bitcode-mdindex-threshold=0
+; RUN: opt -module-summary %p/Inputs/lazy-load-cache1.ll -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/lazy-load-cache2.ll -o %t2.bc
+
+; Both backends import @foo. The first one to load this module indexes its
+; function bodies and metadata, the second one finds them in the cache.
+; RUN: llvm-lto2 run %t.bc %t1.bc %t2.bc -o %t.o -save-temps \
+; RUN:   -thinlto-threads=1 -stats \
+; RUN:   -r %t.bc,_foo,pl \
+; RUN:   -r %t1.bc,_main,plx \
+; RUN:   -r %t1.bc,_foo, \
+; RUN:   -r %t2.bc,_bar,plx \
+; RUN:   -r %t2.bc,_foo, 2>&1 | FileCheck %s --check-prefix=STATS
+; STATS: 2 bitcode-reader - Number of lazy load cache hits
+; STATS: 2 bitcode-reader - Number of lazy load cache misses
+
+; The metadata of @foo is imported from the cached indexes.
+; RUN: llvm-dis %t.o.2.3.import.bc -o - | FileCheck %s --check-prefix=IMPORT
+; IMPORT: define available_externally void @foo() !dbg ![[SP:[0-9]+]]
+; IMPORT: ![[SP]] = distinct !DISubprogram(name: "foo"
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @foo() !dbg !6 {
+  ret void, !dbg !8
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+!llvm.ident = !{!5}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "foo.c", directory: "/tmp")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !{!"clang"}
+!6 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 1, type: !7, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, variables: !2)
+!7 = !DISubroutineType(types: !2)
+!8 = !DILocation(line: 1, column: 1, scope: !6)
@@ -0,0 +1,27 @@
+; RUN: opt -module-summary %s -o %t.bc
+
+; The worker processes get the code generation options of the link, so they
+; give the same output as the in-process backend.
+; RUN: llvm-lto2 run -o %t.threads %t.bc -thinlto-threads=2 \
+; RUN:  -relocation-model=static -filetype=asm \
+; RUN:  -r=%t.bc,f,px \
+; RUN:  -r=%t.bc,g,
+; RUN: llvm-lto2 run -o %t.proc %t.bc -thinlto-processes=2 \
+; RUN:  -relocation-model=static -filetype=asm \
+; RUN:  -r=%t.bc,f,px \
+; RUN:  -r=%t.bc,g,
+; RUN: cmp %t.threads.0 %t.proc.0
+; RUN: FileCheck %s < %t.proc.0
+
+; CHECK-LABEL: f:
+; CHECK: movl g(%rip), %eax
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@g = external global i32
+
+define i32 @f() {
+  %v = load i32, i32* @g
+  ret i32 %v
+}
@@ -0,0 +1,46 @@
+; RUN: opt -module-hash -module-summary %s -o %t.bc
+; RUN: opt -module-hash -module-summary %p/Inputs/cache.ll -o %t2.bc
+
+; Build in-process for reference.
+; RUN: llvm-lto2 run -o %t.ref.o %t2.bc %t.bc \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+
+; The backends give the same objects when run in worker processes, which
+; import @globalfunc from the module file written for them.
+; RUN: llvm-lto2 run -o %t.proc.o %t2.bc %t.bc -thinlto-processes=2 \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.ref.o.0 %t.proc.o.0
+; RUN: cmp %t.ref.o.1 %t.proc.o.1
+
+; The objects of the worker processes are cached like in-process ones.
+; RUN: rm -Rf %t.cache
+; RUN: llvm-lto2 run -o %t.miss.o %t2.bc %t.bc -thinlto-processes=2 \
+; RUN:  -cache-dir %t.cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: ls %t.cache | count 2
+; RUN: llvm-lto2 run -o %t.hit.o %t2.bc %t.bc -cache-dir %t.cache \
+; RUN:  -r=%t2.bc,_main,plx \
+; RUN:  -r=%t2.bc,_globalfunc,lx \
+; RUN:  -r=%t.bc,_globalfunc,plx
+; RUN: cmp %t.ref.o.0 %t.hit.o.0
+; RUN: cmp %t.ref.o.1 %t.hit.o.1
+
+; The worker rejects a malformed job.
+; RUN: echo > %t.list
+; RUN: not llvm-lto2 thin-backend -o %t.bad.o %t.bc %t.list 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=BAD
+; BAD: ThinLTO backend failed: malformed module list
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+define void @globalfunc() {
+entry:
+  ret void
+}
@@ -0,0 +1,84 @@
+; Check that the thin link analyses give the same results whatever the number
+; of threads they run on, and that their phases can be timed.
+
+; RUN: opt -module-summary %s -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/thin-link-threads.ll -o %t2.bc
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.serial -save-temps \
+; RUN:   -thinlto-threads=1 \
+; RUN:   -r %t1.bc,_main,plx \
+; RUN:   -r %t1.bc,_foo,pl \
+; RUN:   -r %t1.bc,_dead_func,pl \
+; RUN:   -r %t1.bc,_linkonce_func,pl \
+; RUN:   -r %t1.bc,_bar,l \
+; RUN:   -r %t2.bc,_bar,pl \
+; RUN:   -r %t2.bc,_baz,pl \
+; RUN:   -r %t2.bc,_linkonce_func, \
+; RUN:   -r %t2.bc,_dead_func,l \
+; RUN:   -r %t2.bc,_another_dead_func,pl
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.parallel -save-temps \
+; RUN:   -thinlto-threads=4 -time-thin-link \
+; RUN:   -r %t1.bc,_main,plx \
+; RUN:   -r %t1.bc,_foo,pl \
+; RUN:   -r %t1.bc,_dead_func,pl \
+; RUN:   -r %t1.bc,_linkonce_func,pl \
+; RUN:   -r %t1.bc,_bar,l \
+; RUN:   -r %t2.bc,_bar,pl \
+; RUN:   -r %t2.bc,_baz,pl \
+; RUN:   -r %t2.bc,_linkonce_func, \
+; RUN:   -r %t2.bc,_dead_func,l \
+; RUN:   -r %t2.bc,_another_dead_func,pl 2>&1 | FileCheck %s --check-prefix=TIME
+
+; RUN: llvm-dis < %t.serial.0.3.import.bc -o %t.serial.0.ll
+; RUN: llvm-dis < %t.parallel.0.3.import.bc -o %t.parallel.0.ll
+; RUN: llvm-dis < %t.serial.1.3.import.bc -o %t.serial.1.ll
+; RUN: llvm-dis < %t.parallel.1.3.import.bc -o %t.parallel.1.ll
+; RUN: diff %t.serial.0.ll %t.parallel.0.ll
+; RUN: diff %t.serial.1.ll %t.parallel.1.ll
+; RUN: cmp %t.serial.0 %t.parallel.0
+; RUN: cmp %t.serial.1 %t.parallel.1
+; RUN: FileCheck %s < %t.parallel.0.ll
+; RUN: FileCheck %s --check-prefix=CHECK2 < %t.parallel.1.ll
+
+; TIME: ThinLTO thin link
+; TIME-DAG: Compute dead symbols
+; TIME-DAG: Compute cross-module imports
+; TIME-DAG: Internalize and promote
+; TIME-DAG: Resolve weak for linker
+
+; @bar is imported, and the dead @dead_func and the non-exported @foo are
+; internalized.
+; CHECK-DAG: define weak_odr void @linkonce_func()
+; CHECK-DAG: define internal void @foo()
+; CHECK-DAG: define internal void @dead_func()
+; CHECK-DAG: define available_externally void @bar()
+
+; The non-prevailing copy of @linkonce_func is made available_externally.
+; CHECK2-DAG: define available_externally void @linkonce_func()
+; CHECK2-DAG: define void @bar()
+; CHECK2-DAG: define internal void @another_dead_func()
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+declare void @bar()
+
+define linkonce_odr void @linkonce_func() {
+  ret void
+}
+
+define void @foo() {
+  call void @linkonce_func()
+  ret void
+}
+
+define void @dead_func() {
+  call void @foo()
+  ret void
+}
+
+define void @main() {
+  call void @bar()
+  call void @foo()
+  ret void
+}
@@ -0,0 +1,62 @@
+; RUN: opt -disable-debug-info-type-map -compact-debug-info -verify %s -S | FileCheck %s
+
+; Both compile units describe struct A. The copy from the second unit is
+; replaced by the first one, and the variables retained by the subprogram of
+; the deleted function @dead, which an import still refers to, are dropped.
+
+; CHECK: define void @f(%struct.A* %a) !dbg [[F:![0-9]+]]
+; CHECK: define void @g(%struct.A* %a) !dbg [[G:![0-9]+]]
+; CHECK-NOT: variables:
+; CHECK: distinct !DISubprogram(name: "dead", {{.*}}isDefinition: true
+; CHECK-NOT: variables:
+; CHECK: [[F]] = distinct !DISubprogram(name: "f", {{.*}}type: [[FTY:![0-9]+]]
+; CHECK: [[FTY]] = !DISubroutineType(types: [[TYPES:![0-9]+]])
+; CHECK: [[TYPES]] = !{null, [[PTR:![0-9]+]]}
+; CHECK: [[PTR]] = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: [[A:![0-9]+]]
+; CHECK: [[A]] = distinct !DICompositeType(tag: DW_TAG_structure_type, name: "A", {{.*}}identifier: "_ZTS1A")
+; CHECK: [[G]] = distinct !DISubprogram(name: "g", {{.*}}type: [[FTY]]
+; CHECK-NOT: identifier: "_ZTS1A"
+
+%struct.A = type { i32 }
+
+define void @f(%struct.A* %a) !dbg !6 {
+  ret void, !dbg !14
+}
+
+define void @g(%struct.A* %a) !dbg !15 {
+  ret void, !dbg !20
+}
+
+!llvm.dbg.cu = !{!0, !2}
+!llvm.module.flags = !{!4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "f.cpp", directory: "/tmp")
+!2 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !3, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, imports: !28)
+!3 = !DIFile(filename: "g.cpp", directory: "/tmp")
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !DIFile(filename: "a.h", directory: "/tmp")
+!6 = distinct !DISubprogram(name: "f", linkageName: "_Z1fP1A", scope: !1, file: !1, line: 2, type: !7, isLocal: false, isDefinition: true, scopeLine: 2, isOptimized: false, unit: !0)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null, !9}
+!9 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !10, size: 64)
+!10 = distinct !DICompositeType(tag: DW_TAG_structure_type, name: "A", file: !5, line: 1, size: 32, elements: !11, identifier: "_ZTS1A")
+!11 = !{!12}
+!12 = !DIDerivedType(tag: DW_TAG_member, name: "x", scope: !10, file: !5, line: 1, baseType: !13, size: 32)
+!13 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!14 = !DILocation(line: 2, scope: !6)
+!15 = distinct !DISubprogram(name: "g", linkageName: "_Z1gP1A", scope: !3, file: !3, line: 2, type: !16, isLocal: false, isDefinition: true, scopeLine: 2, isOptimized: false, unit: !2)
+!16 = !DISubroutineType(types: !17)
+!17 = !{null, !18}
+!18 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !19, size: 64)
+!19 = distinct !DICompositeType(tag: DW_TAG_structure_type, name: "A", file: !5, line: 1, size: 32, elements: !21, identifier: "_ZTS1A")
+!20 = !DILocation(line: 2, scope: !15)
+!21 = !{!22}
+!22 = !DIDerivedType(tag: DW_TAG_member, name: "x", scope: !19, file: !5, line: 1, baseType: !13, size: 32)
+!23 = distinct !DISubprogram(name: "dead", linkageName: "_Z4deadv", scope: !3, file: !3, line: 5, type: !24, isLocal: false, isDefinition: true, scopeLine: 5, isOptimized: false, unit: !2, variables: !26)
+!24 = !DISubroutineType(types: !25)
+!25 = !{null}
+!26 = !{!27}
+!27 = !DILocalVariable(name: "y", scope: !23, file: !3, line: 5, type: !13)
+!28 = !{!29}
+!29 = !DIImportedEntity(tag: DW_TAG_imported_declaration, scope: !3, entity: !23, file: !3, line: 6)
@@ -0,0 +1,37 @@
+; RUN: not llvm-as %s -disable-output 2>&1 | FileCheck %s
+; RUN: not llvm-as %s -disable-output -verify-threads=4 2>&1 | FileCheck %s
+
+; The attributes incompatible with the type of a call argument are reported
+; the same way when the bodies are verified in parallel.
+
+declare void @takes_i8ptr(i8*)
+declare void @takes_i32(i32)
+declare void @takes_float(float)
+
+; CHECK: Wrong types for attribute: byval inalloca nest noalias nocapture nonnull readnone readonly signext sret zeroext dereferenceable(1) dereferenceable_or_null(1)
+; CHECK-NEXT: call void @takes_float(float signext 0.000000e+00)
+define void @f1() {
+  call void @takes_float(float signext 0.0)
+  ret void
+}
+
+; CHECK: Wrong types for attribute: byval inalloca nest noalias nocapture nonnull readnone readonly sret dereferenceable(1) dereferenceable_or_null(1)
+; CHECK-NEXT: call void @takes_i32(i32 nonnull 0)
+define void @f2() {
+  call void @takes_i32(i32 nonnull 0)
+  ret void
+}
+
+; CHECK: Wrong types for attribute: signext zeroext
+; CHECK-NEXT: call void @takes_i8ptr(i8* zeroext null)
+define void @f3() {
+  call void @takes_i8ptr(i8* zeroext null)
+  ret void
+}
+
+; CHECK: Wrong types for attribute: byval inalloca nest noalias nocapture nonnull readnone readonly sret dereferenceable(1) dereferenceable_or_null(1)
+; CHECK-NEXT: call void @takes_i32(i32 noalias 1)
+define void @f4() {
+  call void @takes_i32(i32 noalias 1)
+  ret void
+}
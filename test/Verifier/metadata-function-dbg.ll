@@ -1,4 +1,5 @@
 ; RUN: not llvm-as %s -disable-output 2>&1 | FileCheck %s
+; RUN: not llvm-as %s -disable-output -verify-threads=4 2>&1 | FileCheck %s
 
 ; CHECK:      function declaration may not have a !dbg attachment
 declare !dbg !4 void @f1()
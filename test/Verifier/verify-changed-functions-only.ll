@@ -0,0 +1,23 @@
+; RUN: not opt -disable-verify -verify-changed-functions-only \
+; RUN:   -passes='function(no-op-function),verify' -S %s -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s
+; RUN: not opt -disable-verify \
+; RUN:   -passes='function(no-op-function),verify' -S %s -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s
+
+; A broken body is reported even when the function analyses are cached.
+
+define i32 @good(i32 %x) {
+  ret i32 %x
+}
+
+define i32 @bad(i32 %x) {
+  %y = add i32 %z, 1
+  %z = add i32 %x, 1
+  ret i32 %y
+}
+
+; CHECK: Instruction does not dominate all uses!
+; CHECK-NEXT:  %z = add i32 %x, 1
+; CHECK-NEXT:  %y = add i32 %z, 1
+; CHECK: Broken module found, compilation aborted!
@@ -0,0 +1,54 @@
+; RUN: llvm-split -partitioning=callgraph -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; The call in the loop is heavier than the call on exit, so caller and hot are
+; clustered first. Adding cold would make the cluster larger than half of the
+; module, so it is balanced against x instead.
+; CHECK0: define void @caller
+; CHECK0: define void @hot
+; CHECK0: declare void @cold
+; CHECK0: declare i32 @x
+
+; CHECK1: declare void @caller
+; CHECK1: declare void @hot
+; CHECK1: define void @cold
+; CHECK1: define i32 @x
+
+define void @caller(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  call void @hot()
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  call void @cold()
+  ret void
+}
+
+define void @hot() {
+  ret void
+}
+
+define void @cold() {
+  call void @ext()
+  ret void
+}
+
+define i32 @x(i32 %p) {
+  %a1 = add i32 %p, 1
+  %a2 = add i32 %a1, 2
+  %a3 = add i32 %a2, 3
+  %a4 = add i32 %a3, 4
+  %a5 = add i32 %a4, 5
+  %a6 = add i32 %a5, 6
+  %a7 = add i32 %a6, 7
+  ret i32 %a7
+}
+
+declare void @ext()
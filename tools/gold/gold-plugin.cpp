@@ -125,6 +125,8 @@ namespace options {
   static unsigned Parallelism = 0;
   // Default regular LTO codegen parallelism (number of partitions).
   static unsigned ParallelCodeGenParallelismLevel = 1;
+  // How the regular LTO module is split into the partitions.
+  static SplitModulePartitioning Partitioning = SplitModulePartitioning::Hash;
 #ifdef NDEBUG
   static bool DisableVerify = true;
 #else
@@ -233,6 +235,10 @@ namespace options {
       if (opt.substr(strlen("lto-partitions="))
               .getAsInteger(10, ParallelCodeGenParallelismLevel))
         message(LDPL_FATAL, "Invalid codegen partition level: %s", opt_ + 5);
+    } else if (opt == "lto-partitioning=hash") {
+      Partitioning = SplitModulePartitioning::Hash;
+    } else if (opt == "lto-partitioning=callgraph") {
+      Partitioning = SplitModulePartitioning::CallGraph;
     } else if (opt == "disable-verify") {
       DisableVerify = true;
     } else if (opt.startswith("sample-profile=")) {
@@ -762,6 +768,7 @@ static std::unique_ptr<LTO> createLTO() {
   Conf.CGOptLevel = getCGOptLevel();
   Conf.DisableVerify = options::DisableVerify;
   Conf.OptLevel = options::OptLevel;
+  Conf.CodeGenPartitioning = options::Partitioning;
   if (options::Parallelism)
     Backend = createInProcessThinBackend(options::Parallelism);
   if (options::thinlto_index_only) {
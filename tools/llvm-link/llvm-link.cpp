@@ -19,6 +19,7 @@
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
 #include "llvm/IR/Verifier.h"
@@ -29,10 +30,12 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/FunctionImport.h"
 #include "llvm/Transforms/IPO/Internalize.h"
 #include "llvm/Transforms/Utils/FunctionImportUtils.h"
@@ -77,6 +80,11 @@ static cl::opt<bool>
     DisableDITypeMap("disable-debug-info-type-map",
                      cl::desc("Don't use a uniquing type map for debug info"));
 
+static cl::opt<bool>
+    CompactDebugInfo("compact-debug-info",
+                     cl::desc("Deduplicate and compact the debug info of the "
+                              "linked module"));
+
 static cl::opt<bool>
 OnlyNeeded("only-needed", cl::desc("Link only needed symbols"));
 
@@ -110,6 +118,12 @@ static cl::opt<bool> PreserveAssemblyUseListOrder(
     cl::desc("Preserve use-list order when writing LLVM assembly."),
     cl::init(false), cl::Hidden);
 
+static cl::opt<bool> PrintMemoryUsage(
+    "print-memory-usage",
+    cl::desc("Print the operand storage of the linked module and the peak "
+             "resident set size after linking"),
+    cl::init(false), cl::Hidden);
+
 static ExitOnError ExitOnErr;
 
 // Read the specified bitcode file in and return it. This routine searches the
@@ -375,8 +389,31 @@ int main(int argc, char **argv) {
   if (!importFunctions(argv[0], *Composite))
     return 1;
 
+  if (CompactDebugInfo) {
+    legacy::PassManager PM;
+    PM.add(createCompactDebugInfoPass());
+    PM.run(*Composite);
+  }
+
   if (DumpAsm) errs() << "Here's the assembly:\n" << *Composite;
 
+  if (PrintMemoryUsage) {
+    // Operands of instructions and global values are the bulk of the Use
+    // objects owned by the module. This only measures their storage; the
+    // layout of Use itself is unchanged.
+    uint64_t NumUses = 0;
+    for (const GlobalValue &GV : Composite->global_values())
+      NumUses += GV.getNumOperands();
+    for (const Function &F : *Composite)
+      for (const BasicBlock &BB : F)
+        for (const Instruction &I : BB)
+          NumUses += I.getNumOperands();
+    errs() << argv[0] << ": " << NumUses << " operands, "
+           << NumUses * sizeof(Use) / 1024 << " KiB of Use storage\n";
+    errs() << argv[0] << ": peak resident set size "
+           << sys::Process::GetPeakResidentSetSize() / 1024 << " KiB\n";
+  }
+
   std::error_code EC;
   tool_output_file Out(OutputFilename, EC, sys::fs::F_None);
   if (EC) {
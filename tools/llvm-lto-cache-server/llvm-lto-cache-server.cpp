@@ -0,0 +1,329 @@
+//===-- llvm-lto-cache-server: shared ThinLTO cache server ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program serves a ThinLTO cache directory to other machines using the
+// protocol described in llvm/LTO/CacheServer.h. Clients use it as the second
+// tier behind their local cache directory (see llvm-lto2 -cache-server).
+//
+// Objects are stored by content: each key names the SHA1 of its object, and
+// objects with the same contents are stored once.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/LTO/CacheServer.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef LLVM_ON_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace llvm;
+using namespace llvm::lto;
+
+static cl::opt<std::string>
+    Address("address", cl::Required,
+            cl::desc("Address to serve on, either unix:<path> or "
+                     "tcp:<host>:<port>"),
+            cl::value_desc("address"));
+
+static cl::opt<std::string> CacheDir("cache-dir",
+                                     cl::desc("Directory to store objects in"),
+                                     cl::value_desc("directory"));
+
+static cl::opt<bool>
+    Daemonize("daemonize",
+              cl::desc("Run in the background once the server is listening"));
+
+static cl::opt<unsigned>
+    IdleTimeout("idle-timeout",
+                cl::desc("Exit after this many seconds without a request "
+                         "(0 means never)"),
+                cl::init(0));
+
+static cl::opt<std::string>
+    LogFile("log-file", cl::desc("Append a line per request to this file"),
+            cl::value_desc("filename"));
+
+static cl::opt<bool>
+    Shutdown("shutdown",
+             cl::desc("Ask the server listening on -address to exit"));
+
+static std::unique_ptr<raw_fd_ostream> Log;
+
+static void log(const Twine &Msg) {
+  if (!Log)
+    return;
+  *Log << Msg << '\n';
+  Log->flush();
+}
+
+static void error(const Twine &Msg) {
+  errs() << "llvm-lto-cache-server: " << Msg << '\n';
+  exit(1);
+}
+
+static void check(Error E) {
+  if (!E)
+    return;
+  handleAllErrors(std::move(E), [&](ErrorInfoBase &EIB) {
+    error(EIB.message());
+  });
+}
+
+template <typename T> static T check(Expected<T> E) {
+  if (E)
+    return std::move(*E);
+  check(E.takeError());
+  return T();
+}
+
+static std::string hashObject(StringRef Object) {
+  std::array<uint8_t, 20> Hash = SHA1::hash(makeArrayRef(
+      reinterpret_cast<const uint8_t *>(Object.data()), Object.size()));
+  return toHex(StringRef(reinterpret_cast<const char *>(Hash.data()),
+                         Hash.size()));
+}
+
+static std::string keyPath(StringRef Key) {
+  SmallString<128> Path;
+  sys::path::append(Path, CacheDir, "keys", Key);
+  return Path.str();
+}
+
+static std::string objectPath(StringRef Hash) {
+  SmallString<128> Path;
+  sys::path::append(Path, CacheDir, "objects", Hash);
+  return Path.str();
+}
+
+/// Write Contents to Path through a temporary file, so that readers never see
+/// a partially written file.
+static bool writeFileAtomically(StringRef Path, StringRef Contents) {
+  int TempFD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(Path + ".tmp-%%%%%%", TempFD, TempPath))
+    return false;
+  {
+    raw_fd_ostream OS(TempFD, /* ShouldClose */ true);
+    OS << Contents;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return false;
+    }
+  }
+  if (sys::fs::rename(TempPath, Path)) {
+    sys::fs::remove(TempPath);
+    return false;
+  }
+  return true;
+}
+
+/// Return the object stored under Key, or null if there is none. Entries that
+/// fail their integrity check are removed.
+static std::unique_ptr<MemoryBuffer> lookup(StringRef Key) {
+  std::string KeyFile = keyPath(Key);
+  ErrorOr<std::unique_ptr<MemoryBuffer>> HashOrErr =
+      MemoryBuffer::getFile(KeyFile);
+  if (!HashOrErr)
+    return nullptr;
+  StringRef Hash = (*HashOrErr)->getBuffer().trim();
+  if (Hash.size() != 40 ||
+      Hash.find_first_not_of("0123456789ABCDEF") != StringRef::npos)
+    return nullptr;
+
+  std::string ObjectFile = objectPath(Hash);
+  ErrorOr<std::unique_ptr<MemoryBuffer>> ObjectOrErr =
+      MemoryBuffer::getFile(ObjectFile, /*FileSize=*/-1,
+                            /*RequiresNullTerminator=*/false);
+  if (!ObjectOrErr)
+    return nullptr;
+  if (hashObject((*ObjectOrErr)->getBuffer()) != Hash) {
+    sys::fs::remove(ObjectFile);
+    sys::fs::remove(KeyFile);
+    return nullptr;
+  }
+  return std::move(*ObjectOrErr);
+}
+
+static bool store(StringRef Key, StringRef Object) {
+  std::string Hash = hashObject(Object);
+  std::string ObjectFile = objectPath(Hash);
+  if (!sys::fs::exists(ObjectFile) && !writeFileAtomically(ObjectFile, Object))
+    return false;
+  return writeFileAtomically(keyPath(Key), Hash);
+}
+
+/// Serve the request on FD. Returns true if the server was asked to exit.
+static bool handleConnection(int FD) {
+  std::string Key;
+  Expected<cacheserver::Opcode> Op = cacheserver::readRequest(FD, Key);
+  if (!Op) {
+    consumeError(Op.takeError());
+    consumeError(cacheserver::writeStatus(FD, cacheserver::Status::Error));
+    return false;
+  }
+
+  switch (*Op) {
+  case cacheserver::Opcode::Shutdown:
+    log("shutdown");
+    consumeError(cacheserver::writeStatus(FD, cacheserver::Status::Ok));
+    return true;
+  case cacheserver::Opcode::Get:
+    if (std::unique_ptr<MemoryBuffer> Object = lookup(Key)) {
+      log("get " + Key + " hit");
+      if (Error E = cacheserver::writeStatus(FD, cacheserver::Status::Ok))
+        consumeError(std::move(E));
+      else
+        consumeError(cacheserver::writeObject(FD, Object->getBuffer()));
+    } else {
+      log("get " + Key + " miss");
+      consumeError(cacheserver::writeStatus(FD, cacheserver::Status::Miss));
+    }
+    return false;
+  case cacheserver::Opcode::Put: {
+    Expected<std::unique_ptr<MemoryBuffer>> Object =
+        cacheserver::readObject(FD, Key);
+    if (!Object) {
+      consumeError(Object.takeError());
+      consumeError(cacheserver::writeStatus(FD, cacheserver::Status::Error));
+      return false;
+    }
+    bool Stored = store(Key, (*Object)->getBuffer());
+    log("put " + Key + (Stored ? "" : " failed"));
+    consumeError(cacheserver::writeStatus(
+        FD, Stored ? cacheserver::Status::Ok : cacheserver::Status::Error));
+    return false;
+  }
+  }
+  llvm_unreachable("unknown opcode");
+}
+
+#ifdef LLVM_ON_UNIX
+static int serve() {
+  if (CacheDir.empty())
+    error("-cache-dir is required");
+  for (const char *Subdir : {"keys", "objects"}) {
+    SmallString<128> Path;
+    sys::path::append(Path, CacheDir, Subdir);
+    if (std::error_code EC = sys::fs::create_directories(Path))
+      error(Twine(Path) + ": " + EC.message());
+  }
+
+  // A socket file left behind by a server that did not exit cleanly would
+  // make listen() fail, so remove it unless a server is still answering.
+  StringRef SocketPath;
+  if (StringRef(Address).startswith("unix:")) {
+    SocketPath = StringRef(Address).drop_front(strlen("unix:"));
+    Expected<int> FD = cacheserver::connect(Address);
+    if (FD) {
+      cacheserver::close(*FD);
+      error("a server is already listening on " + Address);
+    }
+    consumeError(FD.takeError());
+    // sys::fs::remove() only removes files, directories and links.
+    ::unlink(SocketPath.str().c_str());
+  }
+
+  if (!LogFile.empty()) {
+    std::error_code EC;
+    Log = llvm::make_unique<raw_fd_ostream>(LogFile, EC, sys::fs::F_Append);
+    if (EC)
+      error(LogFile + ": " + EC.message());
+  }
+
+  int ListenFD = check(cacheserver::listen(Address));
+
+  if (Daemonize) {
+    pid_t Pid = ::fork();
+    if (Pid < 0)
+      error("cannot fork");
+    // The parent exits once the server is listening, so that clients started
+    // after it can connect right away.
+    if (Pid > 0)
+      return 0;
+    ::setsid();
+    int Null = ::open("/dev/null", O_RDWR);
+    if (Null >= 0) {
+      ::dup2(Null, 0);
+      ::dup2(Null, 1);
+      ::dup2(Null, 2);
+      if (Null > 2)
+        ::close(Null);
+    }
+  }
+
+  int Timeout = IdleTimeout ? IdleTimeout * 1000 : -1;
+  for (;;) {
+    pollfd PFD = {ListenFD, POLLIN, 0};
+    int N = ::poll(&PFD, 1, Timeout);
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0)
+      break;
+    Expected<int> FD = cacheserver::accept(ListenFD);
+    if (!FD) {
+      consumeError(FD.takeError());
+      continue;
+    }
+    bool Exit = handleConnection(*FD);
+    cacheserver::close(*FD);
+    if (Exit)
+      break;
+  }
+
+  cacheserver::close(ListenFD);
+  if (!SocketPath.empty())
+    ::unlink(SocketPath.str().c_str());
+  return 0;
+}
+#else
+static int serve() {
+  error("the cache server is not supported on this platform");
+  return 1;
+}
+#endif
+
+static int requestShutdown() {
+  int FD = check(cacheserver::connect(Address));
+  check(cacheserver::writeRequest(FD, cacheserver::Opcode::Shutdown));
+  Expected<cacheserver::Status> S = cacheserver::readStatus(FD);
+  cacheserver::close(FD);
+  if (check(std::move(S)) != cacheserver::Status::Ok)
+    error("server refused to shut down");
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+
+  cl::ParseCommandLineOptions(argc, argv, "shared ThinLTO cache server\n");
+
+  if (Shutdown)
+    return requestShutdown();
+  return serve();
+}
@@ -16,6 +16,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/IR/DiagnosticPrinter.h"
@@ -23,8 +24,10 @@
 #include "llvm/LTO/LTO.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
 
 using namespace llvm;
 using namespace lto;
@@ -49,6 +52,16 @@ static cl::opt<std::string> OutputFilename("o", cl::Required,
 static cl::opt<std::string> CacheDir("cache-dir", cl::desc("Cache Directory"),
                                      cl::value_desc("directory"));
 
+static cl::opt<std::string>
+    CacheServer("cache-server",
+                cl::desc("Shared cache server to use behind -cache-dir, "
+                         "either unix:<path> or tcp:<host>:<port>"),
+                cl::value_desc("address"));
+
+static cl::opt<bool>
+    CompressCacheEntries("compress-cache-entries",
+                         cl::desc("Store new cache entries compressed"));
+
 static cl::opt<std::string> OptPipeline("opt-pipeline",
                                         cl::desc("Optimizer Pipeline"),
                                         cl::value_desc("pipeline"));
@@ -68,6 +81,33 @@ static cl::opt<bool>
 static cl::opt<int> Threads("thinlto-threads",
                             cl::init(llvm::heavyweight_hardware_concurrency()));
 
+static cl::opt<unsigned>
+    Processes("thinlto-processes", cl::init(0),
+              cl::desc("Run the ThinLTO backends in this many worker "
+                       "processes instead of threads"));
+
+static cl::opt<unsigned> MemoryBudget(
+    "thinlto-memory-budget", cl::init(0),
+    cl::desc("Estimated memory the ThinLTO backends may use at once, in MiB "
+             "(0 = unlimited)"));
+
+static cl::opt<bool>
+    JobReport("thinlto-job-report",
+              cl::desc("Print a table of the ThinLTO backend jobs"));
+
+static cl::opt<unsigned>
+    Partitions("lto-partitions", cl::init(1),
+               cl::desc("Number of partitions of the regular LTO module "
+                        "code generated in parallel"));
+
+static cl::opt<SplitModulePartitioning> Partitioning(
+    "lto-partitioning", cl::init(SplitModulePartitioning::Hash),
+    cl::desc("How the regular LTO module is split into partitions"),
+    cl::values(clEnumValN(SplitModulePartitioning::Hash, "hash",
+                          "By a hash of the names of the globals"),
+               clEnumValN(SplitModulePartitioning::CallGraph, "callgraph",
+                          "By clustering functions along their call graph")));
+
 static cl::list<std::string> SymbolResolutions(
     "r",
     cl::desc("Specify a symbol resolution: filename,symbolname,resolution\n"
@@ -82,6 +122,10 @@ static cl::list<std::string> SymbolResolutions(
              "A resolution for each symbol must be specified."),
     cl::ZeroOrMore);
 
+static cl::opt<bool>
+    TimeThinLink("time-thin-link", cl::init(false),
+                 cl::desc("Time the phases of the ThinLTO thin link"));
+
 static cl::opt<std::string> OverrideTriple(
     "override-triple",
     cl::desc("Replace target triples in input files with this triple"));
@@ -141,50 +185,12 @@ template <typename T> static T check(ErrorOr<T> E, std::string Msg) {
 }
 
 static int usage() {
-  errs() << "Available subcommands: dump-symtab run\n";
+  errs() << "Available subcommands: dump-symtab run thin-backend\n";
   return 1;
 }
 
-static int run(int argc, char **argv) {
-  cl::ParseCommandLineOptions(argc, argv, "Resolution-based LTO test harness");
-
-  // FIXME: Workaround PR30396 which means that a symbol can appear
-  // more than once if it is defined in module-level assembly and
-  // has a GV declaration. We allow (file, symbol) pairs to have multiple
-  // resolutions and apply them in the order observed.
-  std::map<std::pair<std::string, std::string>, std::list<SymbolResolution>>
-      CommandLineResolutions;
-  for (std::string R : SymbolResolutions) {
-    StringRef Rest = R;
-    StringRef FileName, SymbolName;
-    std::tie(FileName, Rest) = Rest.split(',');
-    if (Rest.empty()) {
-      llvm::errs() << "invalid resolution: " << R << '\n';
-      return 1;
-    }
-    std::tie(SymbolName, Rest) = Rest.split(',');
-    SymbolResolution Res;
-    for (char C : Rest) {
-      if (C == 'p')
-        Res.Prevailing = true;
-      else if (C == 'l')
-        Res.FinalDefinitionInLinkageUnit = true;
-      else if (C == 'x')
-        Res.VisibleToRegularObj = true;
-      else if (C == 'r')
-        Res.LinkerRedefined = true;
-      else {
-        llvm::errs() << "invalid character " << C << " in resolution: " << R
-                     << '\n';
-        return 1;
-      }
-    }
-    CommandLineResolutions[{FileName, SymbolName}].push_back(Res);
-  }
-
-  std::vector<std::unique_ptr<MemoryBuffer>> MBs;
-
-  Config Conf;
+/// Set up \p Conf from the options shared by the subcommands running backends.
+static bool initConfig(Config &Conf) {
   Conf.DiagHandler = [](const DiagnosticInfo &DI) {
     DiagnosticPrinterRawOStream DP(errs());
     DI.print(DP);
@@ -201,10 +207,6 @@ static int run(int argc, char **argv) {
 
   Conf.DebugPassManager = DebugPassManager;
 
-  if (SaveTemps)
-    check(Conf.addSaveTemps(OutputFilename + "."),
-          "Config::addSaveTemps failed");
-
   // Optimization remarks.
   Conf.RemarksFilename = OptRemarksOutput;
   Conf.RemarksWithHotness = OptRemarksWithHotness;
@@ -232,7 +234,7 @@ static int run(int argc, char **argv) {
     break;
   default:
     llvm::errs() << "invalid cg optimization level: " << CGOptLevel << '\n';
-    return 1;
+    return false;
   }
 
   if (FileType.getNumOccurrences())
@@ -241,12 +243,103 @@ static int run(int argc, char **argv) {
   Conf.OverrideTriple = OverrideTriple;
   Conf.DefaultTriple = DefaultTriple;
 
+  return true;
+}
+
+/// Return the command running a ThinLTO backend of -thinlto-processes in this
+/// program. It gets every option of this command, so that the workers set up
+/// the same Config, and the same internal options, as the in-process backend.
+static std::vector<std::string> getWorkerArgs(int argc, char **argv) {
+  std::vector<std::string> Args = {
+      sys::fs::getMainExecutable(argv[0], (void *)(intptr_t)getWorkerArgs),
+      "thin-backend"};
+  StringMap<cl::Option *> &Options = cl::getRegisteredOptions();
+  for (int I = 1; I < argc; ++I) {
+    StringRef Arg = argv[I];
+    // The input files are replaced by the files of the job.
+    if (Arg == "--")
+      break;
+    if (!Arg.startswith("-") || Arg == "-")
+      continue;
+    StringRef Name = Arg.ltrim('-').split('=').first;
+    cl::Option *O = Options.lookup(Name);
+    bool HasSeparateValue = O && !Arg.contains('=') && I + 1 < argc &&
+                            O->getValueExpectedFlag() == cl::ValueRequired;
+    // The worker writes the object of the job, has no symbol resolutions to
+    // apply, and would write the remarks of every job to the same file.
+    if (O && (Name == "o" || Name == "r" || Name == "pass-remarks-output")) {
+      I += HasSeparateValue;
+      continue;
+    }
+    Args.push_back(Arg);
+    if (HasSeparateValue)
+      Args.push_back(argv[++I]);
+  }
+  return Args;
+}
+
+static int run(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "Resolution-based LTO test harness");
+
+  // FIXME: Workaround PR30396 which means that a symbol can appear
+  // more than once if it is defined in module-level assembly and
+  // has a GV declaration. We allow (file, symbol) pairs to have multiple
+  // resolutions and apply them in the order observed.
+  std::map<std::pair<std::string, std::string>, std::list<SymbolResolution>>
+      CommandLineResolutions;
+  for (std::string R : SymbolResolutions) {
+    StringRef Rest = R;
+    StringRef FileName, SymbolName;
+    std::tie(FileName, Rest) = Rest.split(',');
+    if (Rest.empty()) {
+      llvm::errs() << "invalid resolution: " << R << '\n';
+      return 1;
+    }
+    std::tie(SymbolName, Rest) = Rest.split(',');
+    SymbolResolution Res;
+    for (char C : Rest) {
+      if (C == 'p')
+        Res.Prevailing = true;
+      else if (C == 'l')
+        Res.FinalDefinitionInLinkageUnit = true;
+      else if (C == 'x')
+        Res.VisibleToRegularObj = true;
+      else if (C == 'r')
+        Res.LinkerRedefined = true;
+      else {
+        llvm::errs() << "invalid character " << C << " in resolution: " << R
+                     << '\n';
+        return 1;
+      }
+    }
+    CommandLineResolutions[{FileName, SymbolName}].push_back(Res);
+  }
+
+  std::vector<std::unique_ptr<MemoryBuffer>> MBs;
+
+  Config Conf;
+  if (!initConfig(Conf))
+    return 1;
+
+  Conf.ThinLinkThreads = Threads;
+  Conf.TimeThinLink = TimeThinLink;
+  Conf.ThinLTOMemoryBudget = uint64_t(MemoryBudget) << 20;
+  Conf.ReportThinLTOJobs = JobReport;
+  Conf.CodeGenPartitioning = Partitioning;
+
+  if (SaveTemps)
+    check(Conf.addSaveTemps(OutputFilename + "."),
+          "Config::addSaveTemps failed");
+
   ThinBackend Backend;
   if (ThinLTODistributedIndexes)
     Backend = createWriteIndexesThinBackend("", "", true, "");
+  else if (Processes)
+    Backend = createOutOfProcessThinBackend(Processes,
+                                            getWorkerArgs(argc, argv));
   else
     Backend = createInProcessThinBackend(Threads);
-  LTO Lto(std::move(Conf), std::move(Backend));
+  LTO Lto(std::move(Conf), std::move(Backend), Partitions);
 
   bool HasErrors = false;
   for (std::string F : InputFilenames) {
@@ -301,10 +394,44 @@ static int run(int argc, char **argv) {
   };
 
   NativeObjectCache Cache;
-  if (!CacheDir.empty())
-    Cache = check(localCache(CacheDir, AddBuffer), "failed to create cache");
+  if (!CacheDir.empty()) {
+    std::shared_ptr<RemoteCache> Remote;
+    if (!CacheServer.empty())
+      Remote = check(createCacheServerClient(CacheServer),
+                     "failed to create cache server client");
+    Cache = check(localCache(CacheDir, AddBuffer, std::move(Remote),
+                             CompressCacheEntries),
+                  "failed to create cache");
+  }
 
   check(Lto.run(AddStream, Cache), "LTO::run failed");
+  if (TimeThinLink)
+    TimerGroup::printAll(errs());
+  return 0;
+}
+
+static int thinBackend(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "ThinLTO backend worker");
+  if (InputFilenames.size() != 2) {
+    errs() << argv[0] << ": expected an index file and a module list\n";
+    return 1;
+  }
+
+  Config Conf;
+  if (!initConfig(Conf))
+    return 1;
+
+  auto AddStream =
+      [&](size_t Task) -> std::unique_ptr<lto::NativeObjectStream> {
+    std::error_code EC;
+    auto S = llvm::make_unique<raw_fd_ostream>(OutputFilename, EC,
+                                               sys::fs::F_None);
+    check(EC, OutputFilename);
+    return llvm::make_unique<lto::NativeObjectStream>(std::move(S));
+  };
+  check(runThinBackendJob(Conf, InputFilenames[0], InputFilenames[1],
+                          AddStream),
+        "ThinLTO backend failed");
   return 0;
 }
 
@@ -379,6 +506,7 @@ static int dumpSymtab(int argc, char **argv) {
 }
 
 int main(int argc, char **argv) {
+  llvm_shutdown_obj Y; // Call llvm_shutdown() on exit, e.g. to print -stats.
   InitializeAllTargets();
   InitializeAllTargetMCs();
   InitializeAllAsmPrinters();
@@ -397,5 +525,7 @@ int main(int argc, char **argv) {
     return dumpSymtab(argc - 1, argv + 1);
   if (Subcommand == "run")
     return run(argc - 1, argv + 1);
+  if (Subcommand == "thin-backend")
+    return thinBackend(argc - 1, argv + 1);
   return usage();
 }
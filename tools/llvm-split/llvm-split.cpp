@@ -40,6 +40,14 @@ static cl::opt<bool>
     PreserveLocals("preserve-locals", cl::Prefix, cl::init(false),
                    cl::desc("Split without externalizing locals"));
 
+static cl::opt<SplitModulePartitioning> Partitioning(
+    "partitioning", cl::init(SplitModulePartitioning::Hash),
+    cl::desc("How to assign the globals to the output files"),
+    cl::values(clEnumValN(SplitModulePartitioning::Hash, "hash",
+                          "By a hash of their names"),
+               clEnumValN(SplitModulePartitioning::CallGraph, "callgraph",
+                          "By clustering functions along their call graph")));
+
 int main(int argc, char **argv) {
   LLVMContext Context;
   SMDiagnostic Err;
@@ -67,7 +75,7 @@ int main(int argc, char **argv) {
 
     // Declare success.
     Out->keep();
-  }, PreserveLocals);
+  }, PreserveLocals, Partitioning);
 
   return 0;
 }
@@ -0,0 +1,64 @@
+//===- llvm/unittest/CodeGen/DIEAbbrevTest.cpp ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/CodeGen/DIE.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class DIEAbbrevTest : public testing::Test {
+public:
+  BumpPtrAllocator Alloc;
+
+  DIE &makeVariable(dwarf::Form LineForm, uint64_t Line) {
+    DIE &Die = *DIE::get(Alloc, dwarf::DW_TAG_variable);
+    Die.addValue(Alloc, dwarf::DW_AT_decl_file, dwarf::DW_FORM_data1,
+                 DIEInteger(1));
+    Die.addValue(Alloc, dwarf::DW_AT_decl_line, LineForm, DIEInteger(Line));
+    return Die;
+  }
+};
+
+TEST_F(DIEAbbrevTest, Unique) {
+  DIEAbbrevSet Set(Alloc);
+
+  // DIEs with the same tag and attribute forms share an abbreviation.
+  DIE &A = makeVariable(dwarf::DW_FORM_data1, 1);
+  DIE &B = makeVariable(dwarf::DW_FORM_data1, 2);
+  Set.uniqueAbbreviation(A);
+  Set.uniqueAbbreviation(B);
+  EXPECT_EQ(1u, A.getAbbrevNumber());
+  EXPECT_EQ(1u, B.getAbbrevNumber());
+
+  // Implicit constants are part of the abbreviation.
+  DIE &C = makeVariable(dwarf::DW_FORM_implicit_const, 3);
+  DIE &D = makeVariable(dwarf::DW_FORM_implicit_const, 4);
+  DIE &E = makeVariable(dwarf::DW_FORM_implicit_const, 3);
+  Set.uniqueAbbreviation(C);
+  Set.uniqueAbbreviation(D);
+  const DIEAbbrev &Abbrev = Set.uniqueAbbreviation(E);
+  EXPECT_EQ(2u, C.getAbbrevNumber());
+  EXPECT_EQ(3u, D.getAbbrevNumber());
+  EXPECT_EQ(2u, E.getAbbrevNumber());
+  ASSERT_EQ(2u, Abbrev.getData().size());
+  EXPECT_EQ(3, Abbrev.getData()[1].getValue());
+
+  // So is whether the DIE has children.
+  DIE &F = makeVariable(dwarf::DW_FORM_data1, 1);
+  F.setForceChildren(true);
+  const DIEAbbrev &ChildrenAbbrev = Set.uniqueAbbreviation(F);
+  EXPECT_EQ(4u, F.getAbbrevNumber());
+  EXPECT_TRUE(ChildrenAbbrev.hasChildren());
+  EXPECT_EQ(dwarf::DW_TAG_variable, ChildrenAbbrev.getTag());
+}
+
+} // end anonymous namespace
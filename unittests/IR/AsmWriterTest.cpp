@@ -13,6 +13,8 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -51,4 +53,33 @@ TEST(AsmWriterTest, DumpDIExpression) {
             OS.str());
 }
 
+TEST(AsmWriterTest, PrintToUnbufferedStream) {
+  LLVMContext Ctx;
+  Module M("m", Ctx);
+  Function *F = Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false),
+                                 GlobalValue::ExternalLinkage, "f", &M);
+  ReturnInst::Create(Ctx, BasicBlock::Create(Ctx, "entry", F));
+
+  // Printing is buffered internally, but the stream printed to must keep its
+  // own buffering, so that later diagnostics are not delayed or reordered.
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("asmwriter", "ll", FD, Path));
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true, /*unbuffered=*/true);
+    F->print(OS);
+    M.print(OS, nullptr);
+    F->getEntryBlock().getTerminator()->print(OS);
+    EXPECT_EQ(0u, OS.GetBufferSize());
+  }
+  auto Buffer = MemoryBuffer::getFile(Path);
+  sys::fs::remove(Path);
+  ASSERT_TRUE(bool(Buffer));
+  StringRef Text = (*Buffer)->getBuffer();
+  EXPECT_TRUE(
+      Text.startswith("\ndefine void @f() {\nentry:\n  ret void\n}\n"));
+  EXPECT_NE(StringRef::npos, Text.find("; ModuleID = 'm'"));
+  EXPECT_TRUE(Text.endswith("}\n  ret void"));
+}
+
 }
@@ -19,6 +19,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "gtest/gtest.h"
 
 namespace llvm {
@@ -205,6 +206,100 @@ TEST(VerifierTest, StripInvalidDebugInfo) {
   }
 }
 
+TEST(VerifierTest, StripInvalidDebugInfoChangedFunctionsOnly) {
+  auto &Opts = cl::getRegisteredOptions();
+  auto *ChangedOnly =
+      static_cast<cl::opt<bool> *>(Opts["verify-changed-functions-only"]);
+  ASSERT_TRUE(ChangedOnly);
+  *ChangedOnly = true;
+
+  LLVMContext C;
+  Module M("M", C);
+  DIBuilder DIB(M);
+  auto *File = DIB.createFile("broken.c", "/");
+  auto *CU = DIB.createCompileUnit(dwarf::DW_LANG_C89, File, "unittest", false,
+                                   "", 0);
+  auto *FTy = FunctionType::get(Type::getVoidTy(C), false);
+  Function *Fns[2];
+  for (unsigned I = 0; I != 2; ++I) {
+    StringRef Name = I ? "g" : "f";
+    Fns[I] = cast<Function>(M.getOrInsertFunction(Name, FTy));
+    IRBuilder<> Builder(BasicBlock::Create(C, "", Fns[I]));
+    Builder.CreateRetVoid();
+    Fns[I]->setSubprogram(
+        DIB.createFunction(CU, Name, Name, File, 1, nullptr, true, true, 1));
+  }
+  DIB.finalize();
+  EXPECT_FALSE(verifyModule(M));
+
+  FunctionAnalysisManager FAM(true);
+  ModuleAnalysisManager MAM(true);
+  FAM.registerPass([&] { return ModuleAnalysisManagerFunctionProxy(MAM); });
+  MAM.registerPass([&] { return FunctionAnalysisManagerModuleProxy(FAM); });
+  MAM.registerPass([&] { return VerifierAnalysis(); });
+  MAM.getResult<FunctionAnalysisManagerModuleProxy>(M);
+
+  ModulePassManager MPM(true);
+  MPM.addPass(VerifierPass(false));
+  MPM.run(M, MAM);
+  EXPECT_TRUE(Fns[0]->getSubprogram());
+
+  // Now break it by changing only @f to share the subprogram of @g, which
+  // stays cached as verified.
+  Fns[0]->setSubprogram(Fns[1]->getSubprogram());
+  EXPECT_TRUE(verifyModule(M));
+  FAM.invalidate(*Fns[0], PreservedAnalyses::none());
+  PreservedAnalyses PA;
+  PA.preserve<FunctionAnalysisManagerModuleProxy>();
+  PA.preserveSet<AllAnalysesOn<Function>>();
+  MAM.invalidate(M, PA);
+
+  MPM.run(M, MAM);
+  EXPECT_FALSE(Fns[0]->getSubprogram());
+  EXPECT_FALSE(verifyModule(M));
+
+  *ChangedOnly = false;
+}
+
+TEST(VerifierTest, SkipUnchangedFunctions) {
+  auto &Opts = cl::getRegisteredOptions();
+  auto *ChangedOnly =
+      static_cast<cl::opt<bool> *>(Opts["verify-changed-functions-only"]);
+  ASSERT_TRUE(ChangedOnly);
+  *ChangedOnly = true;
+
+  LLVMContext C;
+  Module M("M", C);
+  auto *FTy = FunctionType::get(Type::getVoidTy(C), false);
+  Function *F = cast<Function>(M.getOrInsertFunction("f", FTy));
+  ReturnInst::Create(C, BasicBlock::Create(C, "", F));
+
+  FunctionAnalysisManager FAM(true);
+  ModuleAnalysisManager MAM(true);
+  FAM.registerPass([&] { return ModuleAnalysisManagerFunctionProxy(MAM); });
+  MAM.registerPass([&] { return FunctionAnalysisManagerModuleProxy(FAM); });
+  MAM.registerPass([&] { return VerifierAnalysis(); });
+  MAM.getResult<FunctionAnalysisManagerModuleProxy>(M);
+  EXPECT_FALSE(MAM.getResult<VerifierAnalysis>(M).IRBroken);
+
+  // Break the body of @f behind the back of the analysis manager. The module
+  // is verified again, but @f is still marked as verified and is skipped.
+  ReturnInst::Create(C, &F->getEntryBlock());
+  EXPECT_TRUE(verifyModule(M));
+  PreservedAnalyses PA;
+  PA.preserve<FunctionAnalysisManagerModuleProxy>();
+  PA.preserveSet<AllAnalysesOn<Function>>();
+  MAM.invalidate(M, PA);
+  EXPECT_FALSE(MAM.getResult<VerifierAnalysis>(M).IRBroken);
+
+  // Once @f is known to have changed, its body is verified again.
+  FAM.invalidate(*F, PreservedAnalyses::none());
+  MAM.invalidate(M, PA);
+  EXPECT_TRUE(MAM.getResult<VerifierAnalysis>(M).IRBroken);
+
+  *ChangedOnly = false;
+}
+
 TEST(VerifierTest, StripInvalidDebugInfoLegacy) {
   LLVMContext C;
   Module M("M", C);
@@ -8,7 +8,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/CachePruning.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Chrono.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -21,6 +27,18 @@ TEST(CachePruningPolicyParser, Empty) {
   EXPECT_EQ(75u, P->MaxSizePercentageOfAvailableSpace);
 }
 
+TEST(CachePruningPolicyParser, UseIndex) {
+  auto P = parseCachePruningPolicy("");
+  ASSERT_TRUE(bool(P));
+  EXPECT_FALSE(P->UseIndex);
+  P = parseCachePruningPolicy("use_index=true");
+  ASSERT_TRUE(bool(P));
+  EXPECT_TRUE(P->UseIndex);
+  P = parseCachePruningPolicy("use_index=false");
+  ASSERT_TRUE(bool(P));
+  EXPECT_FALSE(P->UseIndex);
+}
+
 TEST(CachePruningPolicyParser, Interval) {
   auto P = parseCachePruningPolicy("prune_interval=1s");
   ASSERT_TRUE(bool(P));
@@ -92,6 +110,105 @@ TEST(CachePruningPolicyParser, Errors) {
   EXPECT_EQ(
       "'foo' not an integer",
       toString(parseCachePruningPolicy("cache_size_bytes=foom").takeError()));
+  EXPECT_EQ("'yes' must be 'true' or 'false'",
+            toString(parseCachePruningPolicy("use_index=yes").takeError()));
   EXPECT_EQ("Unknown key: 'foo'",
             toString(parseCachePruningPolicy("foo=bar").takeError()));
 }
+
+namespace {
+class CachePruningIndexTest : public ::testing::Test {
+protected:
+  SmallString<128> CacheDir;
+
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("cache-pruning", CacheDir));
+  }
+
+  void TearDown() override { sys::fs::remove_directories(CacheDir); }
+
+  std::string path(StringRef Name) {
+    SmallString<128> Path(CacheDir);
+    sys::path::append(Path, Name);
+    return Path.str();
+  }
+
+  void writeFile(StringRef Name, StringRef Contents) {
+    std::error_code EC;
+    raw_fd_ostream OS(path(Name), EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  }
+
+  std::string readFile(StringRef Name) {
+    auto MBOrErr = MemoryBuffer::getFile(path(Name));
+    if (!MBOrErr)
+      return "";
+    return (*MBOrErr)->getBuffer();
+  }
+
+  static CachePruningPolicy indexPolicy() {
+    CachePruningPolicy Policy;
+    Policy.Interval = std::chrono::seconds(0);
+    Policy.Expiration = std::chrono::hours(1);
+    Policy.MaxSizePercentageOfAvailableSpace = 0;
+    Policy.UseIndex = true;
+    return Policy;
+  }
+};
+} // end anonymous namespace
+
+TEST_F(CachePruningIndexTest, IndexDrivesPruning) {
+  writeFile("llvmcache-old", "old");
+  writeFile("llvmcache-big", "big");
+  writeFile("llvmcache-new", "new");
+  writeFile("user-file", "user");
+
+  // Without an index, the first pruning scans the directory and builds one.
+  ASSERT_TRUE(pruneCache(CacheDir, indexPolicy()));
+  EXPECT_TRUE(StringRef(readFile("llvmcache.index"))
+                  .startswith("llvmcache-index v1 "));
+
+  // From now on, the recorded accesses and sizes are trusted over the files.
+  uint64_t Now = sys::toTimeT(std::chrono::system_clock::now());
+  std::string Index;
+  raw_string_ostream OS(Index);
+  OS << "llvmcache-index v1 " << Now << "\n"
+     << "llvmcache-old 3 " << Now - 2 * 3600 << "\n"
+     << "llvmcache-big 3 " << Now << "\n"
+     << "llvmcache-new 3 " << Now << "\n";
+  writeFile("llvmcache.index", OS.str());
+  recordCacheAccess(CacheDir, path("llvmcache-big"), 1000000);
+
+  CachePruningPolicy Policy = indexPolicy();
+  Policy.MaxSizeBytes = 1000;
+  ASSERT_TRUE(pruneCache(CacheDir, Policy));
+  EXPECT_FALSE(sys::fs::exists(path("llvmcache-old")));
+  EXPECT_FALSE(sys::fs::exists(path("llvmcache-big")));
+  EXPECT_TRUE(sys::fs::exists(path("llvmcache-new")));
+  EXPECT_TRUE(sys::fs::exists(path("user-file")));
+
+  // Only the surviving entry is left in the index.
+  std::string NewIndex = readFile("llvmcache.index");
+  EXPECT_EQ(std::string::npos, NewIndex.find("llvmcache-old"));
+  EXPECT_EQ(std::string::npos, NewIndex.find("llvmcache-big"));
+  EXPECT_NE(std::string::npos, NewIndex.find("llvmcache-new 3 "));
+}
+
+TEST_F(CachePruningIndexTest, CorruptIndexFallsBackToScan) {
+  writeFile("llvmcache-a", "a");
+  writeFile("llvmcache.index", "llvmcache-index v1 0\nllvmcache-a ../x 1\n");
+  ASSERT_TRUE(pruneCache(CacheDir, indexPolicy()));
+  EXPECT_TRUE(sys::fs::exists(path("llvmcache-a")));
+
+  std::string Index = readFile("llvmcache.index");
+  EXPECT_TRUE(StringRef(Index).startswith("llvmcache-index v1 "));
+  EXPECT_NE(std::string::npos, Index.find("llvmcache-a 1 "));
+}
+
+TEST_F(CachePruningIndexTest, RecordWithoutIndex) {
+  // Caches that are not pruned with an index never get one.
+  writeFile("llvmcache-a", "a");
+  recordCacheAccess(CacheDir, path("llvmcache-a"), 1);
+  EXPECT_FALSE(sys::fs::exists(path("llvmcache.index")));
+}
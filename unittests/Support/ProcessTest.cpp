@@ -9,6 +9,7 @@
 
 #include "llvm/Support/Process.h"
 #include "gtest/gtest.h"
+#include <vector>
 
 #ifdef LLVM_ON_WIN32
 #include <windows.h>
@@ -26,6 +27,28 @@ TEST(ProcessTest, GetRandomNumberTest) {
   EXPECT_NE((r1 | r2), 0u);
 }
 
+TEST(ProcessTest, PeakResidentSetSize) {
+  size_t Before = Process::GetPeakResidentSetSize();
+  if (!Before)
+    return; // Not reported on this platform.
+
+  // Touch enough memory that the high-water mark has to account for it.
+  std::vector<char> Buffer(16 << 20, 1);
+  size_t After = Process::GetPeakResidentSetSize();
+  EXPECT_GE(After, Before);
+  EXPECT_GE(After, Buffer.size());
+}
+
+TEST(ProcessTest, ResidentSetSize) {
+  size_t Before = Process::GetResidentSetSize();
+  if (!Before)
+    return; // Not reported on this platform.
+
+  std::vector<char> Buffer(16 << 20, 1);
+  size_t After = Process::GetResidentSetSize();
+  EXPECT_GE(After, Buffer.size());
+}
+
 #ifdef _MSC_VER
 #define setenv(name, var, ignore) _putenv_s(name, var)
 #endif
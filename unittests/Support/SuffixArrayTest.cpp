@@ -0,0 +1,124 @@
+//===- SuffixArrayTest.cpp - Unit tests for suffix and LCP arrays ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/SuffixArray.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+unsigned commonPrefix(ArrayRef<unsigned> Str, unsigned I, unsigned J) {
+  unsigned H = 0;
+  while (I + H < Str.size() && J + H < Str.size() && Str[I + H] == Str[J + H])
+    ++H;
+  return H;
+}
+
+std::vector<unsigned> naiveSuffixArray(ArrayRef<unsigned> Str) {
+  std::vector<unsigned> SA(Str.size());
+  for (unsigned I = 0; I != SA.size(); ++I)
+    SA[I] = I;
+  std::sort(SA.begin(), SA.end(), [&](unsigned A, unsigned B) {
+    return std::lexicographical_compare(Str.begin() + A, Str.end(),
+                                        Str.begin() + B, Str.end());
+  });
+  return SA;
+}
+
+// Group every index by its longest prefix that starts elsewhere too.
+std::vector<RepeatedSubstring> naiveRepeats(ArrayRef<unsigned> Str,
+                                            unsigned MinLength) {
+  std::map<std::vector<unsigned>, std::vector<unsigned>> Groups;
+  for (unsigned I = 0; I != Str.size(); ++I) {
+    unsigned Longest = 0;
+    for (unsigned J = 0; J != Str.size(); ++J)
+      if (J != I)
+        Longest = std::max(Longest, commonPrefix(Str, I, J));
+    if (Longest >= MinLength && Longest > 0)
+      Groups[Str.slice(I, Longest).vec()].push_back(I);
+  }
+  std::vector<RepeatedSubstring> Result;
+  for (auto &Group : Groups)
+    if (Group.second.size() >= 2)
+      Result.push_back({unsigned(Group.first.size()), Group.second});
+  std::sort(Result.begin(), Result.end(),
+            [](const RepeatedSubstring &A, const RepeatedSubstring &B) {
+              return A.StartIndices[0] < B.StartIndices[0];
+            });
+  return Result;
+}
+
+void checkString(const std::vector<unsigned> &Str) {
+  std::vector<unsigned> SA = buildSuffixArray(Str);
+  ASSERT_EQ(naiveSuffixArray(Str), SA);
+
+  std::vector<unsigned> LCP = buildLCPArray(Str, SA);
+  ASSERT_EQ(Str.size(), LCP.size());
+  for (unsigned I = 1; I < SA.size(); ++I)
+    EXPECT_EQ(commonPrefix(Str, SA[I - 1], SA[I]), LCP[I]);
+
+  for (unsigned MinLength : {1, 2}) {
+    std::vector<RepeatedSubstring> Expected = naiveRepeats(Str, MinLength);
+    std::vector<RepeatedSubstring> Repeats =
+        findRepeatedSubstrings(Str, MinLength);
+    ASSERT_EQ(Expected.size(), Repeats.size());
+    for (unsigned I = 0; I != Repeats.size(); ++I) {
+      EXPECT_EQ(Expected[I].Length, Repeats[I].Length);
+      EXPECT_EQ(Expected[I].StartIndices, Repeats[I].StartIndices);
+    }
+  }
+}
+
+TEST(SuffixArrayTest, Empty) {
+  EXPECT_TRUE(buildSuffixArray({}).empty());
+  EXPECT_TRUE(findRepeatedSubstrings({}).empty());
+}
+
+TEST(SuffixArrayTest, Banana) {
+  // "banana$", with characters far apart as the outliner's are.
+  std::vector<unsigned> Str = {20, 10, ~5u, 10, ~5u, 10, 0};
+  EXPECT_EQ(std::vector<unsigned>({6, 5, 3, 1, 0, 4, 2}),
+            buildSuffixArray(Str));
+  EXPECT_EQ(std::vector<unsigned>({0, 0, 1, 3, 0, 0, 2}),
+            buildLCPArray(Str, buildSuffixArray(Str)));
+
+  // "ana" at 1 and 3 and "na" at 2 and 4. "a" is only the longest repeat of
+  // the suffix at 5.
+  std::vector<RepeatedSubstring> Repeats = findRepeatedSubstrings(Str);
+  ASSERT_EQ(2u, Repeats.size());
+  EXPECT_EQ(3u, Repeats[0].Length);
+  EXPECT_EQ(std::vector<unsigned>({1, 3}), Repeats[0].StartIndices);
+  EXPECT_EQ(2u, Repeats[1].Length);
+  EXPECT_EQ(std::vector<unsigned>({2, 4}), Repeats[1].StartIndices);
+  EXPECT_TRUE(findRepeatedSubstrings(Str, 4).empty());
+  checkString(Str);
+}
+
+TEST(SuffixArrayTest, Random) {
+  std::mt19937 Generator(42);
+  for (unsigned Size : {1, 2, 3, 10, 50, 200}) {
+    for (unsigned AlphabetSize : {1, 2, 4, 16}) {
+      std::uniform_int_distribution<unsigned> Char(0, AlphabetSize - 1);
+      std::vector<unsigned> Str;
+      for (unsigned I = 0; I != Size; ++I)
+        Str.push_back(Char(Generator));
+      // End with a unique character, as the outliner's strings do.
+      Str.push_back(AlphabetSize);
+      checkString(Str);
+    }
+  }
+}
+
+} // end anonymous namespace
@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+"""Measure SelectionDAG instruction selection throughput of llc.
+
+Without input files, this generates a function of many small blocks, the
+shape for which setting up and tearing down the DAG of each block dominates,
+and compiles it. Input files are compiled as they are. For each input, the
+time spent in the instruction selection pass is read from -time-passes and,
+when llc was built with statistics, the DAG nodes built, created by combining,
+legalization and selection are read from -stats.
+
+With --global-isel, each input is also compiled with GlobalISel, falling back
+to SelectionDAG for the functions it cannot select. The time of each GlobalISel
+phase is reported next to that of the selector it replaces (FastISel at -O0),
+along with how many functions fell back and in which phase.
+
+Example:
+  utils/isel_bench.py --llc build/bin/llc --blocks 20000 --runs 3
+  utils/isel_bench.py --llc build/bin/llc -- -O0 large.ll
+  utils/isel_bench.py --llc build/bin/llc --global-isel -- -O0 large.ll
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+def generate_blocks(num_blocks):
+  """Return a module with a function of num_blocks small blocks."""
+  lines = ['define i32 @blocks(i32* %p, i32 %x) {', 'entry:',
+           '  br label %b0']
+  for i in range(num_blocks):
+    succ = 'b%d' % (i + 1) if i + 1 < num_blocks else 'exit'
+    lines += ['b%d:' % i,
+              '  %%v%d = load volatile i32, i32* %%p' % i,
+              '  %%a%d = add i32 %%v%d, %d' % (i, i, i),
+              '  %%m%d = mul i32 %%a%d, %%x' % (i, i),
+              '  store volatile i32 %%m%d, i32* %%p' % i,
+              '  %%c%d = icmp eq i32 %%m%d, 0' % (i, i),
+              '  br i1 %%c%d, label %%exit, label %%%s' % (i, succ)]
+  lines += ['exit:', '  ret i32 0', '}']
+  return '\n'.join(lines) + '\n'
+
+def run_llc(llc, llc_args, input_path):
+  """Compile input_path and return the timing and statistics report."""
+  fd, info_path = tempfile.mkstemp(suffix='.txt')
+  os.close(fd)
+  try:
+    cmd = [llc, '-filetype=null', '-time-passes', '-stats',
+           '-info-output-file=' + info_path] + llc_args + [input_path]
+    subprocess.check_call(cmd)
+    with open(info_path) as f:
+      return f.read()
+  finally:
+    os.remove(info_path)
+
+# The passes of GlobalISel, in pipeline order.
+GISEL_PHASES = ['IRTranslator', 'Legalizer', 'RegBankSelect',
+                'InstructionSelect']
+
+# The statistics groups reported.
+STAT_GROUPS = ['isel', 'irtranslator', 'globalisel-utils',
+               'reset-machine-function']
+
+def parse_report(report):
+  """Return the wall time of instruction selection, the wall time of each
+  GlobalISel phase and the statistics."""
+  isel_time = 0.0
+  phase_times = {}
+  stats = {}
+  for line in report.splitlines():
+    times = re.findall(r'([\d.]+) \(\s*[\d.]+%\)', line)
+    pass_name = line.rsplit(')', 1)[-1].strip()
+    # The selection pass, not the phases of the sdag timer group.
+    if times and 'DAG->DAG' in pass_name:
+      isel_time += float(times[-1])
+      continue
+    if times and pass_name in GISEL_PHASES:
+      phase_times[pass_name] = phase_times.get(pass_name, 0.0) + \
+                               float(times[-1])
+      continue
+    m = re.match(r'^\s*(\d+) (\S+)\s+- (.*)$', line)
+    if m and m.group(2) in STAT_GROUPS:
+      stats[m.group(3)] = int(m.group(1))
+  return isel_time, phase_times, stats
+
+def measure(llc, llc_args, path, runs):
+  """Compile path runs times and return the report of the fastest run."""
+  best = None
+  for _ in range(runs):
+    isel_time, phase_times, stats = parse_report(
+        run_llc(llc, llc_args, path))
+    total = isel_time + sum(phase_times.values())
+    if best is None or total < best[0]:
+      best = (total, isel_time, phase_times, stats)
+  return best[1:]
+
+def print_stats(stats):
+  for desc in sorted(stats):
+    print('  %10d %s' % (stats[desc], desc))
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--llc', default='llc', help='llc binary to measure')
+  parser.add_argument('--blocks', type=int, default=10000,
+                      help='blocks of the generated function')
+  parser.add_argument('--runs', type=int, default=1,
+                      help='compilations of each input; the fastest is kept')
+  parser.add_argument('--global-isel', action='store_true',
+                      help='also compile with GlobalISel and compare')
+  parser.add_argument('args', nargs='*',
+                      help='llc options, then input files, after --')
+  args = parser.parse_args()
+
+  llc_args = [a for a in args.args if a.startswith('-')]
+  inputs = [a for a in args.args if not a.startswith('-')]
+  generated = None
+  if not inputs:
+    fd, generated = tempfile.mkstemp(suffix='.ll')
+    with os.fdopen(fd, 'w') as f:
+      f.write(generate_blocks(args.blocks))
+    inputs = [generated]
+
+  try:
+    for path in inputs:
+      best, _, stats = measure(args.llc, llc_args, path, args.runs)
+      name = '<%d blocks>' % args.blocks if path == generated else path
+      print('%s: %.4fs in instruction selection' % (name, best))
+      print_stats(stats)
+      built = stats.get('Number of DAG nodes built from IR')
+      if built and best:
+        print('  %10.0f nodes built per second' % (built / best))
+      if not args.global_isel:
+        continue
+
+      gisel_args = llc_args + ['-global-isel', '-global-isel-abort=2']
+      fallback_time, phase_times, stats = measure(args.llc, gisel_args, path,
+                                                  args.runs)
+      gisel_time = sum(phase_times.values())
+      print('%s: %.4fs in GlobalISel, %.4fs in the SelectionDAG fallback' %
+            (name, gisel_time, fallback_time))
+      for phase in GISEL_PHASES:
+        print('  %10.4fs %s' % (phase_times.get(phase, 0.0), phase))
+      print_stats(stats)
+      reset = stats.get('Number of functions reset', 0)
+      kept = stats.get('Number of functions kept after selection', 0)
+      if reset + kept:
+        print('  %9.1f%% of the functions fell back' %
+              (100.0 * reset / (reset + kept)))
+      if best:
+        print('  %10.2fx the instruction selection time' %
+              ((gisel_time + fallback_time) / best))
+  finally:
+    if generated:
+      os.remove(generated)
+
+if __name__ == '__main__':
+  sys.exit(main())